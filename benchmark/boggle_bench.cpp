@@ -1,9 +1,26 @@
+#include <atomic>
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
 #include <random>
 #include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 #include "benchmark/benchmark.h"
+#include "any_boggle.hpp"
+#include "board_stats.hpp"
 #include "boggle.hpp"
+#include "incremental_solver.hpp"
+#include "solve_cache.hpp"
+#include "trace.hpp"
+#include "trie_profile.hpp"
 
 namespace {
 constexpr char UPPERCASE_LETTERS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
@@ -15,8 +32,11 @@ std::string random_string(std::size_t length) {
 	std::string random_str;
 	random_str.reserve(length);
 
-	auto time = std::chrono::system_clock::now().time_since_epoch().count();
-	std::minstd_rand eng(time);
+	// Seeded once: reseeding from the clock on every call gave the same string to calls made
+	// within one tick.
+	static std::minstd_rand eng(
+			static_cast<std::minstd_rand::result_type>(
+					std::chrono::system_clock::now().time_since_epoch().count()));
 	std::uniform_int_distribution<std::size_t> dist(0, 25);
 
 	for (std::size_t i = 0; i < length; ++i) {
@@ -26,6 +46,65 @@ std::string random_string(std::size_t length) {
 
 	return random_str;
 }
+
+/*
+ * Return the given number of random N by M Boggle boards, the same for a given seed.
+ */
+template <std::size_t N, std::size_t M>
+std::vector<Boggle<N, M>> random_boards(std::size_t count, std::size_t seed) {
+	std::minstd_rand eng(seed);
+	std::uniform_int_distribution<std::size_t> dist(0, 25);
+	std::vector<Boggle<N, M>> boggles(count);
+	for (auto& boggle : boggles) {
+		for (std::size_t row = 0; row < N; ++row) {
+			for (std::size_t col = 0; col < M; ++col) {
+				boggle[row][col] = UPPERCASE_LETTERS[dist(eng)];
+			}
+		}
+	}
+	return boggles;
+}
+
+/*
+ * Return the boards of real games stored in the test data, whose letters are more common and
+ * spell out many more words than those of random boards.
+ */
+std::vector<Boggle<4, 4>> game_boards() {
+	std::vector<Boggle<4, 4>> boggles;
+	std::ifstream file(TEST_DATA_DIR "/boggle_4x4.csv");
+	std::string line;
+	while (std::getline(file, line)) {
+		std::string letters;
+		for (char c : line.substr(0, line.find(','))) {
+			if (c != 'u') {
+				letters.push_back(c);
+			}
+		}
+		boggles.emplace_back(letters);
+	}
+	return boggles;
+}
+
+std::atomic<std::size_t> n_allocations(0); // Number of calls to operator new.
+}
+
+/*
+ * Replace the global allocation functions so that benchmarks can count allocations.
+ */
+void *operator new(std::size_t size) {
+	n_allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void *p = std::malloc(size == 0 ? 1 : size)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+	std::free(p);
 }
 
 /*
@@ -49,4 +128,580 @@ BENCHMARK_TEMPLATE(boggle_solve, 32, 32)->Unit(benchmark::kMicrosecond);
 BENCHMARK_TEMPLATE(boggle_solve, 64, 64)->Unit(benchmark::kMicrosecond);
 BENCHMARK_TEMPLATE(boggle_solve, 128, 128)->Unit(benchmark::kMicrosecond);
 
+/*
+ * Benchmark the solving of a random N by M Boggle board on a pool of threads created for the solve
+ * and joined after it, which is what every solve did before the pool was kept alive. Compare with
+ * boggle_solve.
+ */
+template <std::size_t N, std::size_t M>
+static void boggle_solve_spawn(benchmark::State& state) {
+	Boggle<N, M>::load_dictionary(DICT_PATH);
+	while (state.KeepRunning()) {
+		std::string random_str = random_string(N * M);
+		Boggle<N, M> boggle(random_str);
+		ThreadPool pool;
+		benchmark::DoNotOptimize(boggle.solve(Boggle<N, M>::dictionary(), pool));
+	}
+}
+
+BENCHMARK_TEMPLATE(boggle_solve_spawn, 4, 4)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(boggle_solve_spawn, 8, 8)->Unit(benchmark::kMicrosecond);
+
+/*
+ * Benchmark the solving of a random N by M Boggle board on a pool with the given number of
+ * threads, to measure how the work-stealing search scales with the number of threads. The same
+ * boards are used for every thread count.
+ */
+template <std::size_t N, std::size_t M>
+static void boggle_solve_threads(benchmark::State& state) {
+	Boggle<N, M>::load_dictionary(DICT_PATH);
+	auto boggles = random_boards<N, M>(8, N * M);
+
+	ThreadPool pool(static_cast<std::size_t>(state.range(0)));
+	std::size_t i = 0;
+	while (state.KeepRunning()) {
+		benchmark::DoNotOptimize(boggles[i].solve(Boggle<N, M>::dictionary(), pool));
+		i == boggles.size() - 1 ? i = 0 : ++i;
+	}
+	state.counters["threads"] = static_cast<double>(pool.size());
+}
+
+BENCHMARK_TEMPLATE(boggle_solve_threads, 16, 16)
+		->RangeMultiplier(2)->Range(1, 16)->UseRealTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(boggle_solve_threads, 32, 32)
+		->RangeMultiplier(2)->Range(1, 16)->UseRealTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(boggle_solve_threads, 64, 64)
+		->RangeMultiplier(2)->Range(1, 16)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(boggle_solve_threads, 128, 128)
+		->RangeMultiplier(2)->Range(1, 16)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+/*
+ * Benchmark the single-threaded solve of random N by M Boggle boards with a reused workspace and
+ * result vector, and report the number of allocations made per solve once every board has been
+ * solved once.
+ */
+template <std::size_t N, std::size_t M>
+static void boggle_solve_workspace(benchmark::State& state) {
+	Boggle<N, M>::load_dictionary(DICT_PATH);
+
+	std::vector<Boggle<N, M>> boggles;
+	for (int i = 0; i < 64; ++i) {
+		boggles.emplace_back(random_string(N * M));
+	}
+
+	typename Boggle<N, M>::Workspace workspace;
+	std::vector<std::string> words;
+	for (const auto& boggle : boggles) {
+		boggle.solve(workspace, words);
+	}
+
+	std::size_t i = 0;
+	std::size_t allocations = 0;
+	while (state.KeepRunning()) {
+		std::size_t before = n_allocations.load(std::memory_order_relaxed);
+		boggles[i].solve(workspace, words);
+		allocations += n_allocations.load(std::memory_order_relaxed) - before;
+		benchmark::DoNotOptimize(words.data());
+		i == boggles.size() - 1 ? i = 0 : ++i;
+	}
+
+	state.counters["allocs_per_solve"] = benchmark::Counter(
+			static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK_TEMPLATE(boggle_solve_workspace, 4, 4)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(boggle_solve_workspace, 5, 5)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(boggle_solve_workspace, 6, 6)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(boggle_solve_workspace, 7, 7)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(boggle_solve_workspace, 8, 8)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(boggle_solve_workspace, 16, 16)->Unit(benchmark::kMicrosecond);
+
+/*
+ * As boggle_solve_workspace, counting the work done by the search in a SearchStats if the argument
+ * is 1, to measure the cost of the counters. With an argument of 0 the counters are compiled out
+ * and the benchmark is the same as boggle_solve_workspace.
+ */
+template <std::size_t N, std::size_t M>
+static void boggle_solve_stats(benchmark::State& state) {
+	Boggle<N, M>::load_dictionary(DICT_PATH);
+
+	std::vector<Boggle<N, M>> boggles;
+	for (int i = 0; i < 64; ++i) {
+		boggles.emplace_back(random_string(N * M));
+	}
+
+	typename Boggle<N, M>::Workspace workspace;
+	std::vector<std::string> words;
+	SearchStats stats;
+	std::uint64_t nodes = 0;
+	std::size_t i = 0;
+	while (state.KeepRunning()) {
+		if (state.range(0) == 0) {
+			boggles[i].solve(workspace, words);
+		} else {
+			boggles[i].solve(Boggle<N, M>::dictionary(), workspace, words, stats);
+			nodes += stats.nodes;
+		}
+		benchmark::DoNotOptimize(words.data());
+		i == boggles.size() - 1 ? i = 0 : ++i;
+	}
+	state.counters["nodes_per_solve"] = benchmark::Counter(
+			static_cast<double>(nodes), benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK_TEMPLATE(boggle_solve_stats, 4, 4)->DenseRange(0, 1)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(boggle_solve_stats, 8, 8)->DenseRange(0, 1)->Unit(benchmark::kMicrosecond);
+
+/*
+ * As boggle_solve_workspace, but returning word IDs rather than words.
+ */
+template <std::size_t N, std::size_t M>
+static void boggle_solve_ids(benchmark::State& state) {
+	Boggle<N, M>::load_dictionary(DICT_PATH);
+
+	std::vector<Boggle<N, M>> boggles;
+	for (int i = 0; i < 64; ++i) {
+		boggles.emplace_back(random_string(N * M));
+	}
+
+	typename Boggle<N, M>::Workspace workspace;
+	std::vector<std::uint32_t> ids;
+	for (const auto& boggle : boggles) {
+		boggle.solve_ids(Boggle<N, M>::dictionary(), workspace, ids);
+	}
+
+	std::size_t i = 0;
+	std::size_t allocations = 0;
+	while (state.KeepRunning()) {
+		std::size_t before = n_allocations.load(std::memory_order_relaxed);
+		boggles[i].solve_ids(Boggle<N, M>::dictionary(), workspace, ids);
+		allocations += n_allocations.load(std::memory_order_relaxed) - before;
+		benchmark::DoNotOptimize(ids.data());
+		i == boggles.size() - 1 ? i = 0 : ++i;
+	}
+
+	state.counters["allocs_per_solve"] = benchmark::Counter(
+			static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK_TEMPLATE(boggle_solve_ids, 4, 4)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(boggle_solve_ids, 8, 8)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(boggle_solve_ids, 16, 16)->Unit(benchmark::kMicrosecond);
+
+/*
+ * As boggle_solve_workspace, but only counting the words with a visitor rather than storing them.
+ */
+template <std::size_t N, std::size_t M>
+static void boggle_visit(benchmark::State& state) {
+	Boggle<N, M>::load_dictionary(DICT_PATH);
+
+	std::vector<Boggle<N, M>> boggles;
+	for (int i = 0; i < 64; ++i) {
+		boggles.emplace_back(random_string(N * M));
+	}
+
+	typename Boggle<N, M>::Workspace workspace;
+	std::size_t i = 0;
+	std::size_t n_words = 0;
+	while (state.KeepRunning()) {
+		boggles[i].visit(Boggle<N, M>::dictionary(), workspace,
+		                 [&n_words](const typename Boggle<N, M>::Match&) {
+			++n_words;
+			return true;
+		});
+		i == boggles.size() - 1 ? i = 0 : ++i;
+	}
+	benchmark::DoNotOptimize(n_words);
+}
+
+BENCHMARK_TEMPLATE(boggle_visit, 4, 4)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(boggle_visit, 8, 8)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(boggle_visit, 16, 16)->Unit(benchmark::kMicrosecond);
+
+/*
+ * Benchmark solving a batch of random N by M Boggle boards one after another, each split between
+ * the threads of a pool of the given size. Compare with boggle_solve_many.
+ */
+template <std::size_t N, std::size_t M>
+static void boggle_solve_batch(benchmark::State& state) {
+	Boggle<N, M>::load_dictionary(DICT_PATH);
+	auto boggles = random_boards<N, M>(1024, N * M);
+
+	ThreadPool pool(static_cast<std::size_t>(state.range(0)));
+	while (state.KeepRunning()) {
+		for (const auto& boggle : boggles) {
+			benchmark::DoNotOptimize(boggle.solve(Boggle<N, M>::dictionary(), pool));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(boggles.size()));
+	state.counters["threads"] = static_cast<double>(pool.size());
+}
+
+BENCHMARK_TEMPLATE(boggle_solve_batch, 4, 4)
+		->RangeMultiplier(2)->Range(1, 16)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+/*
+ * Benchmark solving the same batch of boards as boggle_solve_batch with solve_many, which gives
+ * whole boards to the threads of a pool of the given size.
+ */
+template <std::size_t N, std::size_t M>
+static void boggle_solve_many(benchmark::State& state) {
+	Boggle<N, M>::load_dictionary(DICT_PATH);
+	auto boggles = random_boards<N, M>(1024, N * M);
+
+	ThreadPool pool(static_cast<std::size_t>(state.range(0)));
+	ResultSink sink;
+	while (state.KeepRunning()) {
+		Boggle<N, M>::solve_many(Boggle<N, M>::dictionary(), boggles.data(), boggles.size(), sink,
+		                         pool);
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(boggles.size()));
+	state.counters["threads"] = static_cast<double>(pool.size());
+}
+
+BENCHMARK_TEMPLATE(boggle_solve_many, 4, 4)
+		->RangeMultiplier(2)->Range(1, 16)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+/*
+ * Benchmark the single-threaded solve of the given boards, with the filter of each board if
+ * 'filter' is true.
+ */
+template <std::size_t N, std::size_t M>
+static void solve_boards(benchmark::State& state, const std::vector<Boggle<N, M>>& boggles,
+                         bool filter) {
+	typename Boggle<N, M>::Workspace workspace;
+	workspace.use_filter(filter);
+	std::vector<std::string> words;
+	std::size_t i = 0;
+	std::size_t n_words = 0;
+	while (state.KeepRunning()) {
+		boggles[i].solve(workspace, words);
+		n_words += words.size();
+		i == boggles.size() - 1 ? i = 0 : ++i;
+	}
+	state.counters["filter"] = filter;
+	state.counters["words_per_board"] =
+			static_cast<double>(n_words) / static_cast<double>(state.iterations());
+}
+
+/*
+ * Benchmark the single-threaded solve of random N by M Boggle boards with the board filter, see
+ * BoardFilter, if the argument is 1 and without it if it is 0. Random boards have few words, so
+ * most paths end within a couple of squares.
+ */
+template <std::size_t N, std::size_t M>
+static void boggle_solve_filter(benchmark::State& state) {
+	Boggle<N, M>::load_dictionary(DICT_PATH);
+	solve_boards(state, random_boards<N, M>(64, N * M), state.range(0) != 0);
+}
+
+BENCHMARK_TEMPLATE(boggle_solve_filter, 4, 4)->DenseRange(0, 1)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(boggle_solve_filter, 8, 8)->DenseRange(0, 1)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(boggle_solve_filter, 16, 16)->DenseRange(0, 1)->Unit(benchmark::kMicrosecond);
+
+/*
+ * As above, on the boards of real games in the test data, which are dense with words.
+ */
+static void boggle_solve_filter_games(benchmark::State& state) {
+	Boggle<4, 4>::load_dictionary(DICT_PATH);
+	solve_boards(state, game_boards(), state.range(0) != 0);
+}
+
+BENCHMARK(boggle_solve_filter_games)->DenseRange(0, 1)->Unit(benchmark::kMicrosecond);
+
+/*
+ * Benchmark the single-threaded solve of the given boards advancing the number of searches given
+ * by the argument in turn, see Workspace::interleave. An argument of 1 is the plain DFS.
+ */
+template <std::size_t N, std::size_t M>
+static void solve_interleaved(benchmark::State& state, const std::vector<Boggle<N, M>>& boggles) {
+	typename Boggle<N, M>::Workspace workspace;
+	workspace.interleave(static_cast<std::size_t>(state.range(0)));
+	std::vector<std::string> words;
+	std::size_t i = 0;
+	while (state.KeepRunning()) {
+		boggles[i].solve(workspace, words);
+		benchmark::DoNotOptimize(words.data());
+		i == boggles.size() - 1 ? i = 0 : ++i;
+	}
+}
+
+/*
+ * Benchmark solve_interleaved on random N by M Boggle boards.
+ */
+template <std::size_t N, std::size_t M>
+static void boggle_solve_interleave(benchmark::State& state) {
+	Boggle<N, M>::load_dictionary(DICT_PATH);
+	solve_interleaved(state, random_boards<N, M>(64, N * M));
+}
+
+BENCHMARK_TEMPLATE(boggle_solve_interleave, 4, 4)
+		->RangeMultiplier(2)->Range(1, 16)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(boggle_solve_interleave, 16, 16)
+		->RangeMultiplier(2)->Range(1, 16)->Unit(benchmark::kMicrosecond);
+
+/*
+ * As above, on the boards of real games in the test data, whose searches go deeper.
+ */
+static void boggle_solve_interleave_games(benchmark::State& state) {
+	Boggle<4, 4>::load_dictionary(DICT_PATH);
+	solve_interleaved(state, game_boards());
+}
+
+BENCHMARK(boggle_solve_interleave_games)
+		->RangeMultiplier(2)->Range(1, 16)->Unit(benchmark::kMicrosecond);
+
+/*
+ * Benchmark the lookup of random N by M Boggle boards that are all in a SolveCache, on the given
+ * number of threads sharing the cache.
+ */
+template <std::size_t N, std::size_t M>
+static void solve_cache_hit(benchmark::State& state) {
+	// The boards and the cache are set up by whichever thread gets here first and are kept for
+	// every run of the benchmark. The cache has room for twice as many boards, since each shard
+	// holds an equal share and the boards do not spread over the shards exactly evenly.
+	static const std::vector<Boggle<N, M>> boggles = random_boards<N, M>(1024, N * M);
+	static SolveCache<N, M>& cache = []() -> SolveCache<N, M>& {
+		Boggle<N, M>::load_dictionary(DICT_PATH);
+		static SolveCache<N, M> cache(2 * boggles.size());
+		for (const auto& boggle : boggles) {
+			cache.solve(boggle);
+		}
+		return cache;
+	}();
+
+	std::size_t i = std::hash<std::thread::id>()(std::this_thread::get_id());
+	while (state.KeepRunning()) {
+		benchmark::DoNotOptimize(cache.solve(boggles[i % boggles.size()]));
+		++i;
+	}
+}
+
+BENCHMARK_TEMPLATE(solve_cache_hit, 4, 4)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(solve_cache_hit, 8, 8)->Threads(1)->UseRealTime();
+
+/*
+ * Benchmark changing one random square of a random N by M Boggle board to a random letter and
+ * updating its words with IncrementalSolver, as a board optimization would. Compare with
+ * boggle_solve_workspace, which solves the board from scratch.
+ */
+template <std::size_t N, std::size_t M>
+static void incremental_set(benchmark::State& state) {
+	Boggle<N, M>::load_dictionary(DICT_PATH);
+	IncrementalSolver<N, M> solver(random_boards<N, M>(1, N * M)[0]);
+
+	std::minstd_rand eng(N * M);
+	std::uniform_int_distribution<std::size_t> square(0, N * M - 1);
+	std::uniform_int_distribution<std::size_t> letter(0, 25);
+	std::vector<std::uint32_t> added;
+	std::vector<std::uint32_t> removed;
+	std::size_t n_words = 0;
+	while (state.KeepRunning()) {
+		std::size_t s = square(eng);
+		solver.set(s / M, s % M, UPPERCASE_LETTERS[letter(eng)], added, removed);
+		n_words += solver.size();
+	}
+	state.counters["words_per_board"] =
+			static_cast<double>(n_words) / static_cast<double>(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(incremental_set, 4, 4)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(incremental_set, 5, 5)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(incremental_set, 8, 8)->Unit(benchmark::kMicrosecond);
+
+/*
+ * Benchmark the single-threaded solve of random N by N Boggle boards through AnyBoggle, whose size
+ * is only known at run time. Compare with boggle_solve_workspace. Sizes 4, 5, 6 and 8 are
+ * dispatched to Boggle<N, N>; the others use DynamicBoggle.
+ */
+static void any_boggle_solve(benchmark::State& state) {
+	auto n = static_cast<std::size_t>(state.range(0));
+	Boggle<>::load_dictionary(DICT_PATH);
+
+	std::vector<AnyBoggle> boggles;
+	for (int i = 0; i < 64; ++i) {
+		boggles.emplace_back(n, n, random_string(n * n));
+	}
+
+	std::vector<std::string> words;
+	std::size_t i = 0;
+	while (state.KeepRunning()) {
+		boggles[i].solve(Boggle<>::dictionary(), words);
+		benchmark::DoNotOptimize(words.data());
+		i == boggles.size() - 1 ? i = 0 : ++i;
+	}
+	state.counters["specialized"] = boggles[0].specialized();
+}
+
+BENCHMARK(any_boggle_solve)->DenseRange(4, 8)->Unit(benchmark::kMicrosecond);
+
+/*
+ * Benchmark rolling a board from a set of dice with a counter-based generator, the overhead
+ * BoardStats::sample adds to solving each board. The argument is 0 for the modern 4x4 dice and 1
+ * for the 5x5 Big Boggle dice.
+ */
+static void dice_roll(benchmark::State& state) {
+	const DiceSet& dice = state.range(0) == 0 ? DiceSet::modern() : DiceSet::big();
+	std::string board(dice.size(), ' ');
+	std::uint64_t i = 0;
+	while (state.KeepRunning()) {
+		CounterRng rng(0, i++);
+		dice.roll(rng, &board[0]);
+		benchmark::DoNotOptimize(board.data());
+	}
+}
+
+BENCHMARK(dice_roll)->DenseRange(0, 1);
+
+/*
+ * Benchmark the statistics of 4096 boards rolled from a set of dice on the process-wide pool,
+ * reporting the boards solved per second. The argument is as for dice_roll.
+ */
+static void board_stats_sample(benchmark::State& state) {
+	Boggle<4>::load_dictionary(DICT_PATH);
+	Boggle<5>::load_dictionary(DICT_PATH);
+	constexpr std::uint64_t n_boards = 4096;
+	std::uint64_t seed = 0;
+	while (state.KeepRunning()) {
+		BoardStats stats = state.range(0) == 0 ?
+		                   BoardStats::sample<4>(DiceSet::modern(), n_boards, seed++) :
+		                   BoardStats::sample<5>(DiceSet::big(), n_boards, seed++);
+		benchmark::DoNotOptimize(stats.boards);
+	}
+	state.counters["boards_per_second"] = benchmark::Counter(
+			static_cast<double>(n_boards * state.iterations()), benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(board_stats_sample)->DenseRange(0, 1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/*
+ * Benchmark recording a span with the global tracer, including draining it into the histograms
+ * every half a ring. The argument is 0 with tracing disabled and 1 with it enabled.
+ */
+static void trace_span(benchmark::State& state) {
+	Tracer& tracer = Tracer::global();
+	tracer.enable(state.range(0) == 1);
+	std::uint32_t name = tracer.name("benchmark");
+	std::size_t i = 0;
+	while (state.KeepRunning()) {
+		TraceSpan span(name);
+		if (++i == Tracer::ring_capacity / 2) {
+			tracer.flush();
+			i = 0;
+		}
+	}
+	tracer.enable(false);
+	tracer.reset();
+}
+
+BENCHMARK(trace_span)->DenseRange(0, 1);
+
+/*
+ * Counts the cache misses of the calling thread with perf_event_open, if the kernel lets it.
+ */
+class CacheMissCounter {
+public:
+	CacheMissCounter() :
+			fd_(-1) {
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_CACHE_MISSES;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+	}
+
+	~CacheMissCounter() {
+		if (fd_ != -1) {
+			close(fd_);
+		}
+	}
+
+	// Delete copy constructor and copy assignment.
+	CacheMissCounter(const CacheMissCounter&) = delete;
+
+	CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+	/*
+	 * Return true if cache misses can be counted.
+	 */
+	bool available() const {
+		return fd_ != -1;
+	}
+
+	/*
+	 * Return the number of cache misses counted so far.
+	 */
+	std::uint64_t read() const {
+		std::uint64_t count = 0;
+		if (fd_ == -1 or ::read(fd_, &count, sizeof(count)) != sizeof(count)) {
+			return 0;
+		}
+		return count;
+	}
+
+private:
+	int fd_;
+};
+
+/*
+ * Benchmark solving boards rolled from the modern 4x4 dice or the 5x5 Big Boggle dice with the
+ * dictionary in the breadth-first layout it is built in, for argument 0, and laid out by the heat
+ * of 10000 other boards rolled from the same dice, for argument 1. Reports the cache lines of the
+ * arena each solve touches and, where perf_event_open is allowed, the cache misses of each solve.
+ */
+template <std::size_t N, std::size_t M>
+static void boggle_solve_layout(benchmark::State& state) {
+	const DiceSet& dice = N == 4 ? DiceSet::modern() : DiceSet::big();
+	Trie dictionary = Boggle<N, M>::read_dictionary(DICT_PATH);
+	typename Boggle<N, M>::Workspace workspace;
+	std::vector<std::string> words;
+	if (state.range(0) == 1) {
+		TrieProfile profile(dictionary);
+		Boggle<N, M> boggle;
+		for (std::uint64_t i = 0; i < 10000; ++i) {
+			CounterRng rng(0, i);
+			dice.roll(rng, boggle[0]);
+			profile.add(dictionary, boggle, workspace);
+		}
+		dictionary.layout_by_heat(profile.visits());
+	}
+
+	std::vector<Boggle<N, M>> boggles(256);
+	double lines = 0;
+	for (std::uint64_t i = 0; i < boggles.size(); ++i) {
+		CounterRng rng(1, i);
+		dice.roll(rng, boggles[i][0]);
+		TrieProfile profile(dictionary);
+		profile.add(dictionary, boggles[i], workspace);
+		std::unordered_set<std::size_t> touched;
+		for (std::size_t node = 0; node < profile.visits().size(); ++node) {
+			if (profile.visits()[node] != 0) {
+				touched.insert(node * sizeof(Trie::Node) / 64);
+				touched.insert(((node + 1) * sizeof(Trie::Node) - 1) / 64);
+			}
+		}
+		lines += static_cast<double>(touched.size());
+	}
+
+	CacheMissCounter misses;
+	std::uint64_t first_count = misses.read();
+	std::size_t i = 0;
+	while (state.KeepRunning()) {
+		boggles[i].solve(dictionary, workspace, words);
+		benchmark::DoNotOptimize(words.data());
+		i == boggles.size() - 1 ? i = 0 : ++i;
+	}
+	state.counters["lines_per_solve"] = lines / static_cast<double>(boggles.size());
+	if (misses.available()) {
+		auto count = static_cast<double>(misses.read() - first_count);
+		state.counters["misses_per_solve"] =
+				benchmark::Counter(count, benchmark::Counter::kAvgIterations);
+	}
+}
+BENCHMARK_TEMPLATE(boggle_solve_layout, 4, 4)->DenseRange(0, 1)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(boggle_solve_layout, 5, 5)->DenseRange(0, 1)->Unit(benchmark::kMicrosecond);
+
 BENCHMARK_MAIN();
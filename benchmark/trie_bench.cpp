@@ -1,10 +1,13 @@
 #include <algorithm>
 #include <array>
+#include <cstdio>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "benchmark/benchmark.h"
+#include "thread_pool.hpp"
 #include "trie.hpp"
 
 namespace {
@@ -35,6 +38,49 @@ std::vector<std::string> load_dictionary() {
 
 	return words;
 }
+
+/*
+ * The node layout the Trie used before it was stored in an arena: every node is a separate heap
+ * allocation holding one pointer for each uppercase letter plus one marking the end of a string.
+ * Kept here so the two layouts can be compared.
+ */
+class PointerTrie {
+public:
+	bool has_string(const char *s) const {
+		const PointerTrie *p_trie = this;
+		for (; *s != '\0'; ++s) {
+			p_trie = p_trie->children_[static_cast<std::size_t>(*s - 'A')].get();
+			if (p_trie == nullptr) {
+				return false;
+			}
+		}
+		return p_trie->children_.back() != nullptr;
+	}
+
+	/*
+	 * Insert the given string and return the number of nodes allocated.
+	 */
+	std::size_t insert(const char *s) {
+		std::size_t n_nodes = 0;
+		PointerTrie *p_trie = this;
+		for (; *s != '\0'; ++s) {
+			auto& child = p_trie->children_[static_cast<std::size_t>(*s - 'A')];
+			if (not child) {
+				child = std::make_unique<PointerTrie>();
+				++n_nodes;
+			}
+			p_trie = child.get();
+		}
+		if (not p_trie->children_.back()) {
+			p_trie->children_.back() = std::make_unique<PointerTrie>();
+			++n_nodes;
+		}
+		return n_nodes;
+	}
+
+private:
+	std::array<std::unique_ptr<PointerTrie>, 27> children_;
+};
 }
 
 /*
@@ -128,4 +174,175 @@ static void trie_dictionary_lookup(benchmark::State& state) {
 
 BENCHMARK(trie_dictionary_lookup);
 
-BENCHMARK_MAIN()
+/*
+ * Benchmark the lookup of every word in the dictionary in a trie using the old pointer-based node
+ * layout, for comparison with trie_dictionary_lookup.
+ */
+static void pointer_trie_dictionary_lookup(benchmark::State& state) {
+	std::vector<std::string> dictionary = load_dictionary();
+	PointerTrie trie;
+	for (const auto& word : dictionary) {
+		trie.insert(word.c_str());
+	}
+
+	std::vector<std::string>::size_type i = 0;
+	while (state.KeepRunning()) {
+		benchmark::DoNotOptimize(trie.has_string(dictionary[i].c_str()));
+		i == dictionary.size() - 1 ? i = 0 : ++i;
+	}
+}
+
+BENCHMARK(pointer_trie_dictionary_lookup);
+
+/*
+ * Report the memory held by the nodes of a trie loaded with the dictionary, for the arena layout
+ * both before and after removing the holes left by insertions.
+ */
+static void trie_memory_footprint(benchmark::State& state) {
+	std::vector<std::string> dictionary = load_dictionary();
+	Trie trie;
+	for (const auto& word : dictionary) {
+		trie.insert(word.c_str());
+	}
+	std::size_t bytes_before_shrink = trie.memory_usage();
+	trie.shrink_to_fit();
+
+	while (state.KeepRunning()) {
+		benchmark::DoNotOptimize(trie.memory_usage());
+	}
+
+	state.counters["nodes"] = static_cast<double>(trie.size());
+	state.counters["bytes"] = static_cast<double>(trie.memory_usage());
+	state.counters["bytes_before_shrink"] = static_cast<double>(bytes_before_shrink);
+}
+
+BENCHMARK(trie_memory_footprint)->Iterations(1);
+
+/*
+ * Report the memory held by the nodes of a trie loaded with the dictionary and minimized into a
+ * DAWG.
+ */
+static void dawg_memory_footprint(benchmark::State& state) {
+	std::vector<std::string> dictionary = load_dictionary();
+	Trie trie;
+	for (const auto& word : dictionary) {
+		trie.insert(word.c_str());
+	}
+	trie.minimize();
+
+	while (state.KeepRunning()) {
+		benchmark::DoNotOptimize(trie.memory_usage());
+	}
+
+	state.counters["nodes"] = static_cast<double>(trie.size());
+	state.counters["bytes"] = static_cast<double>(trie.memory_usage());
+}
+
+BENCHMARK(dawg_memory_footprint)->Iterations(1);
+
+/*
+ * Benchmark the lookup of every word in the dictionary in a DAWG, for comparison with
+ * trie_dictionary_lookup.
+ */
+static void dawg_dictionary_lookup(benchmark::State& state) {
+	std::vector<std::string> dictionary = load_dictionary();
+	Trie trie;
+	for (const auto& word : dictionary) {
+		trie.insert(word.c_str());
+	}
+	trie.minimize();
+
+	std::vector<std::string>::size_type i = 0;
+	while (state.KeepRunning()) {
+		benchmark::DoNotOptimize(trie.has_string(dictionary[i].c_str()));
+		i == dictionary.size() - 1 ? i = 0 : ++i;
+	}
+}
+
+BENCHMARK(dawg_dictionary_lookup);
+
+/*
+ * Report the memory held by the nodes of a trie loaded with the dictionary using the old
+ * pointer-based node layout, not counting the allocator's own overhead per node.
+ */
+static void pointer_trie_memory_footprint(benchmark::State& state) {
+	std::vector<std::string> dictionary = load_dictionary();
+	PointerTrie trie;
+	std::size_t n_nodes = 1;
+	for (const auto& word : dictionary) {
+		n_nodes += trie.insert(word.c_str());
+	}
+
+	while (state.KeepRunning()) {
+		benchmark::DoNotOptimize(n_nodes);
+	}
+
+	state.counters["nodes"] = static_cast<double>(n_nodes);
+	state.counters["bytes"] = static_cast<double>(n_nodes * sizeof(PointerTrie));
+}
+
+BENCHMARK(pointer_trie_memory_footprint)->Iterations(1);
+
+/*
+ * Benchmark mapping a minimized dictionary saved in the binary format, which is what replaces
+ * parsing the word list at startup.
+ */
+static void trie_map_dictionary(benchmark::State& state) {
+	std::vector<std::string> dictionary = load_dictionary();
+	Trie trie;
+	for (const auto& word : dictionary) {
+		trie.insert(word.c_str());
+	}
+	trie.minimize();
+	std::string path = "trie_bench_dictionary.bin";
+	trie.save(path);
+
+	while (state.KeepRunning()) {
+		benchmark::DoNotOptimize(Trie::map(path));
+	}
+	std::remove(path.c_str());
+}
+
+BENCHMARK(trie_map_dictionary)->Unit(benchmark::kMicrosecond);
+
+/*
+ * Benchmark building a trie of the whole dictionary by inserting the words one at a time and
+ * removing the holes left behind, for comparison with trie_build_dictionary.
+ */
+static void trie_insert_dictionary(benchmark::State& state) {
+	std::vector<std::string> dictionary = load_dictionary();
+	while (state.KeepRunning()) {
+		Trie trie;
+		for (const auto& word : dictionary) {
+			trie.insert(word.c_str());
+		}
+		trie.shrink_to_fit();
+		benchmark::DoNotOptimize(trie.size());
+	}
+}
+
+BENCHMARK(trie_insert_dictionary)->Unit(benchmark::kMillisecond);
+
+/*
+ * Benchmark building the same trie from the sorted dictionary with Trie::build, on a pool of the
+ * number of threads given by the argument.
+ */
+static void trie_build_dictionary(benchmark::State& state) {
+	std::vector<std::string> dictionary = load_dictionary();
+	std::sort(dictionary.begin(), dictionary.end());
+	dictionary.erase(std::unique(dictionary.begin(), dictionary.end()), dictionary.end());
+	std::vector<const char *> strings;
+	for (const auto& word : dictionary) {
+		strings.push_back(word.c_str());
+	}
+	ThreadPool pool(static_cast<std::size_t>(state.range(0)));
+	while (state.KeepRunning()) {
+		Trie trie = Trie::build(strings.data(), strings.size(), pool);
+		benchmark::DoNotOptimize(trie.size());
+	}
+}
+
+BENCHMARK(trie_build_dictionary)
+		->RangeMultiplier(2)->Range(1, 8)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
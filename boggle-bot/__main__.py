@@ -1,21 +1,58 @@
 """Main entry point of boggle-bot."""
+import argparse
+import contextlib
 import getpass
 import os
 import sys
 import time
 
+import tracing
 from boggle import Boggle
-from wordplays import Wordplays
+from play import play
+from wordplays import BASE_URL, Wordplays
 
 MAX_CONSECUTIVE_ERRORS = 3
 
 module_dir = os.path.dirname(__file__)
-Boggle.load_dictionary(module_dir + '/dict.list')
+dictionary_path = os.path.join(module_dir, 'dict.list')
+compiled_dictionary_path = os.path.join(module_dir, 'dict.bin')
+
+# Map the compiled dictionary if it is up to date, otherwise compile it from
+# the word list for the next start.
+try:
+    if (os.path.getmtime(compiled_dictionary_path) <
+            os.path.getmtime(dictionary_path)):
+        raise RuntimeError('compiled dictionary is older than word list')
+    Boggle.map_dictionary(compiled_dictionary_path)
+except (OSError, RuntimeError):
+    Boggle.load_dictionary(dictionary_path, minimize=True)
+    try:
+        Boggle.save_dictionary(compiled_dictionary_path)
+    except RuntimeError as e:
+        print('Warning: cannot save compiled dictionary:', e, file=sys.stderr)
+
+parser = argparse.ArgumentParser(prog='boggle-bot')
+parser.add_argument('--url', default=BASE_URL,
+                    help='site to play on (default %(default)s)')
+parser.add_argument('--trace', metavar='FILE',
+                    help='write a trace of every puzzle to FILE in the Chrome '
+                         'trace event format')
+parser.add_argument('--trace-interval', metavar='SECONDS', type=float,
+                    default=10.0,
+                    help='seconds between writes of the trace (default '
+                         '%(default)s)')
+args = parser.parse_args()
 
 username = input('Enter username: ')
 password = getpass.getpass(prompt='Enter password: ')
 
-with Wordplays() as wp:
+with contextlib.ExitStack() as stack:
+    wp = stack.enter_context(Wordplays(base_url=args.url))
+    exporter = None
+    if args.trace:
+        exporter = stack.enter_context(
+            tracing.Exporter(args.trace, interval=args.trace_interval))
+
     try:
         if not wp.login(username=username, password=password):
             print('Login unsuccessful.', file=sys.stderr)
@@ -34,10 +71,7 @@ with Wordplays() as wp:
     n_puzzles = 0
     while consecutive_errors < MAX_CONSECUTIVE_ERRORS:
         try:
-            boggle_elements = wp.start_boggle()
-            b = Boggle(boggle_elements)
-            words = b.solve()
-            score, max_score = wp.solve(words)
+            score, max_score = play(wp)
 
             print('Puzzle number: {:5s}, score: {:>4s}, max score: {:>4s}'.
                   format(wp.pzlnbr, score, max_score))
@@ -48,6 +82,10 @@ with Wordplays() as wp:
         except Exception as e:
             print('Error:', e, file=sys.stderr)
             consecutive_errors += 1
+        if exporter:
+            exporter.tick()
 
     print('Too many consecutive errors were encountered. Exiting.',
           file=sys.stderr)
+    if exporter:
+        print(tracing.summary(), file=sys.stderr)
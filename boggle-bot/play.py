@@ -0,0 +1,21 @@
+"""This module plays puzzles on wordplays.com."""
+from boggle import Boggle
+from tracing import span
+
+
+def play(wp):
+    """Start a boggle game, solve it and submit the words.
+
+    Every stage is recorded as a span of the trace, and the whole puzzle as a
+    span named 'puzzle'. Raise a RuntimeError if the server cannot be reached.
+
+    :param wp: Logged in Wordplays session.
+    :return: Tuple containing actual score and max score.
+    """
+    with span('puzzle'):
+        boggle_elements = wp.start_boggle()
+        with span('construct'):
+            b = Boggle(boggle_elements)
+        with span('solve'):
+            words = b.solve_bytes()
+        return wp.solve(words)
@@ -0,0 +1,100 @@
+"""Tracing of the time the bot spends in each stage of a puzzle.
+
+Spans are recorded by the tracer of the boggle module, which also records a
+span for each thread of every search, so one trace shows fetching, parsing,
+solving and submitting side by side with the solver's threads. Spans are kept
+in a ring buffer of each thread until flushed into a latency histogram for
+each span name and, while a trace is being exported, into a file in the Chrome
+trace event format that chrome://tracing and https://ui.perfetto.dev open.
+Nothing is recorded until tracing is started.
+"""
+import contextlib
+import time
+
+from boggle import Tracer
+
+# The IDs of the span names seen so far.
+_names = {}
+
+
+@contextlib.contextmanager
+def span(name):
+    """Record the body of a with statement as a span with the given name, if
+    tracing is enabled. The span is recorded even if the body raises.
+
+    :param name: Name of the span.
+    """
+    if not Tracer.enabled():
+        yield
+        return
+    start = Tracer.now()
+    try:
+        yield
+    finally:
+        Tracer.record(_name(name), start, Tracer.now())
+
+
+def _name(name):
+    """Return the ID of the given span name."""
+    span_id = _names.get(name)
+    if span_id is None:
+        span_id = _names[name] = Tracer.name(name)
+    return span_id
+
+
+class Exporter:
+    """Records spans and writes them to a trace file as they are recorded.
+
+    Tracing is enabled while the exporter is open. The trace file holds every
+    span up to the last flush, as a complete JSON array, so it can be opened
+    while the bot runs. Has methods for context management.
+    """
+
+    def __init__(self, path, interval=10.0):
+        """Start tracing to the given file.
+
+        Raise a RuntimeError if the file cannot be written.
+
+        :param path: Trace file, replaced if it exists.
+        :param interval: Least number of seconds between flushes by tick.
+        """
+        Tracer.open(path)
+        Tracer.enable()
+        self._interval = interval
+        self._last_flush = time.monotonic()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def tick(self):
+        """Flush the spans to the trace file if the interval has passed since
+        the last flush."""
+        now = time.monotonic()
+        if now - self._last_flush >= self._interval:
+            Tracer.flush()
+            self._last_flush = now
+
+    def close(self):
+        """Stop tracing, flush the last spans and close the trace file."""
+        Tracer.enable(False)
+        Tracer.close()
+
+
+def summary():
+    """Return a table of the latencies of each span name, in milliseconds.
+
+    :return: String holding a header line and a line for each span name.
+    """
+    lines = ['{:12s} {:>8s} {:>9s} {:>9s} {:>9s} {:>9s} {:>9s}'.format(
+        'span', 'count', 'mean', 'p50', 'p90', 'p99', 'max')]
+    for name, h in sorted(Tracer.histograms().items()):
+        lines.append('{:12s} {:8d} {:9.3f} {:9.3f} {:9.3f} {:9.3f} {:9.3f}'.
+                     format(name, h['count'], h['mean'] / 1e6, h['p50'] / 1e6,
+                            h['p90'] / 1e6, h['p99'] / 1e6, h['max'] / 1e6))
+    dropped = Tracer.dropped()
+    if dropped:
+        lines.append('{} spans were dropped'.format(dropped))
+    return '\n'.join(lines)
@@ -4,8 +4,11 @@ import time
 
 from bs4 import BeautifulSoup
 
-LOGIN_URL = 'http://www.wordplays.com/wordgames/signin.pl'
-BOGGLE_URL = 'http://www.wordplays.com/boggle'
+from tracing import span
+
+BASE_URL = 'http://www.wordplays.com'
+LOGIN_PATH = '/wordgames/signin.pl'
+BOGGLE_PATH = '/boggle'
 
 
 class Wordplays:
@@ -14,9 +17,20 @@ class Wordplays:
     Provides methods for interacting with wordplays.com, including logging in
     and starting a boggle game. Has methods for context management, so can (and
     should) be called with the with statement.
+
+    The fetching and parsing of pages are recorded as spans of the trace, see
+    the tracing module.
     """
 
-    def __init__(self):
+    def __init__(self, base_url=BASE_URL):
+        """Create a session with the site at the given URL.
+
+        :param base_url: Scheme and host of the site, wordplays.com unless
+            testing against another server.
+        """
+        self._login_url = base_url + LOGIN_PATH
+        self._boggle_url = base_url + BOGGLE_PATH
+
         # Keep track of current puzzle number and puzzle key.
         self.pzlnbr = ''
         self.pzlkey = ''
@@ -47,8 +61,9 @@ class Wordplays:
         payload = {'userid': username, 'pwd': password, 'signin': 'Sign In'}
 
         try:
-            s = self._session.post(url=LOGIN_URL, data=payload,
-                                   headers=self._headers)
+            with span('login'):
+                s = self._session.post(url=self._login_url, data=payload,
+                                       headers=self._headers)
         except requests.RequestException as e:
             raise RuntimeError(e) from e
 
@@ -66,17 +81,19 @@ class Wordplays:
         :return List of characters in the Boggle board.
         """
         try:
-            s = self._session.get(BOGGLE_URL, headers=self._headers)
+            with span('fetch'):
+                s = self._session.get(self._boggle_url, headers=self._headers)
         except requests.RequestException as e:
             raise RuntimeError(e) from e
 
         # Collect boggle elements, puzzle number, and puzzle key.
-        soup = BeautifulSoup(markup=s.text, features='lxml')
-        boggle_table = soup.find('table', attrs={'id': 'pzl'})
-        boggle_elements = [boggle_element.find('input')['value'] for
-                           boggle_element in boggle_table.find_all('td')]
-        self.pzlnbr = soup.find('input', attrs={'name': 'pzlnbr'})['value']
-        self.pzlkey = soup.find('input', attrs={'name': 'pzlkey'})['value']
+        with span('parse'):
+            soup = BeautifulSoup(markup=s.text, features='lxml')
+            boggle_table = soup.find('table', attrs={'id': 'pzl'})
+            boggle_elements = [boggle_element.find('input')['value'] for
+                               boggle_element in boggle_table.find_all('td')]
+            self.pzlnbr = soup.find('input', attrs={'name': 'pzlnbr'})['value']
+            self.pzlkey = soup.find('input', attrs={'name': 'pzlkey'})['value']
 
         return boggle_elements
 
@@ -85,10 +102,16 @@ class Wordplays:
 
         Raise a RuntimeError if words cannot be sent to the server.
 
-        :param words: Solutions to the current Boggle game.
+        :param words: Solutions to the current Boggle game, either as an
+            iterable of strings or as bytes holding one word per line, as
+            returned by Boggle.solve_bytes.
         :return Tuple containing actual score and max score.
         """
-        payload = {'answers': '\n'.join(words),
+        if isinstance(words, bytes):
+            answers = words
+        else:
+            answers = '\n'.join(words)
+        payload = {'answers': answers,
                    'op': 'solve',
                    'pzlnbr': self.pzlnbr,
                    'pzlkey': self.pzlkey,
@@ -98,15 +121,17 @@ class Wordplays:
                    'gametime': int(time.time())}
 
         try:
-            s = self._session.post(url=BOGGLE_URL, data=payload,
-                                   headers=self._headers)
+            with span('submit'):
+                s = self._session.post(url=self._boggle_url, data=payload,
+                                       headers=self._headers)
         except requests.RequestException as e:
             raise RuntimeError(e) from e
 
         # Get score and max score.
-        soup = BeautifulSoup(markup=s.text, features='lxml')
-        score_table = soup.find('table', attrs={'id': 'score-table'})
-        score = score_table.find_all('td')[0].text
-        max_score = score_table.find_all('td')[1].text
+        with span('parse_score'):
+            soup = BeautifulSoup(markup=s.text, features='lxml')
+            score_table = soup.find('table', attrs={'id': 'score-table'})
+            score = score_table.find_all('td')[0].text
+            max_score = score_table.find_all('td')[1].text
 
         return score, max_score
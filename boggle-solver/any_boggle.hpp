@@ -0,0 +1,250 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "boggle.hpp"
+#include "dynamic_boggle.hpp"
+#include "result_sink.hpp"
+#include "search_stats.hpp"
+#include "thread_pool.hpp"
+#include "trie.hpp"
+
+/*
+ * A Boggle board whose dimensions are chosen at run time.
+ *
+ * Boards of the sizes in common use, 4 by 4, 5 by 5 (Big Boggle), 6 by 6 (Super Big Boggle) and
+ * 8 by 8, are solved by the Boggle<N, M> instantiation for their size, whose neighbour masks, path
+ * sets and buffer sizes are compile-time constants. Boards of any other size are solved by
+ * DynamicBoggle. Choosing the kernel is a switch on the dimensions, and the only other cost of
+ * going through AnyBoggle is copying the letters into the instantiation, so a dispatched size
+ * solves about as fast as its Boggle<N, M>.
+ *
+ * Unlike Boggle<N, M>, an AnyBoggle has no dictionary of its own, since each instantiation of
+ * Boggle<N, M> has a separate one. The dictionary is always passed in.
+ */
+class AnyBoggle {
+public:
+	/*
+	 * Create a board with the given number of rows and columns from the given letters, in row-major
+	 * order. The letters must be uppercase ASCII letters, 'Q' standing for the square 'QU'. Throws
+	 * std::invalid_argument if a dimension is zero or the number of letters does not match them.
+	 */
+	AnyBoggle(std::size_t rows, std::size_t cols, std::string letters);
+
+	/*
+	 * Return the number of rows of the board.
+	 */
+	std::size_t rows() const;
+
+	/*
+	 * Return the number of columns of the board.
+	 */
+	std::size_t cols() const;
+
+	/*
+	 * Return the letters of the board in row-major order.
+	 */
+	const std::string& letters() const;
+
+	/*
+	 * Return true if the board is solved by an instantiation of Boggle<N, M> rather than by
+	 * DynamicBoggle.
+	 */
+	bool specialized() const;
+
+	/*
+	 * Return the words in the board that are in the given dictionary, searching on the threads of
+	 * the process-wide pool.
+	 */
+	std::vector<std::string> solve(const Trie& dictionary) const;
+
+	/*
+	 * Return the words in the board that are in the given dictionary, searching on the threads of
+	 * the given pool.
+	 */
+	std::vector<std::string> solve(const Trie& dictionary, ThreadPool& pool) const;
+
+	/*
+	 * As above, also counting the work done by the search, and by each thread, in the given stats,
+	 * which are reset first. See SearchStats.
+	 */
+	std::vector<std::string> solve(const Trie& dictionary, ThreadPool& pool,
+	                               SearchStats& stats) const;
+
+	/*
+	 * Return the IDs in the given dictionary of the words in the board, searching on the threads of
+	 * the given pool.
+	 */
+	std::vector<std::uint32_t> solve_ids(const Trie& dictionary, ThreadPool& pool) const;
+
+	/*
+	 * Find the words in the board that are in the given dictionary using only the calling thread,
+	 * and a workspace kept for the thread, and place them in the given vector, which is cleared
+	 * first.
+	 */
+	void solve(const Trie& dictionary, std::vector<std::string>& words) const;
+
+	/*
+	 * As above, also counting the work done by the search in the given stats, which are reset
+	 * first.
+	 */
+	void solve(const Trie& dictionary, std::vector<std::string>& words, SearchStats& stats) const;
+
+	/*
+	 * Call the given visitor for each word of the given dictionary in the board on the calling
+	 * thread, until it returns false, see Boggle<N, M>::visit. The visitor is called with the Match
+	 * type of the kernel solving the board, which all have the same members, so it should take its
+	 * argument as 'const auto&'.
+	 */
+	template <typename Visitor>
+	bool visit(const Trie& dictionary, Visitor&& visitor) const;
+
+	/*
+	 * Solve the given number of boards, which may be of different sizes, and store the words of
+	 * boards[i] as board i of the given sink, which is reset first. The threads of the given pool
+	 * take whole boards in turn, see Boggle<N, M>::solve_many.
+	 */
+	static void solve_many(const Trie& dictionary, const AnyBoggle *boards, std::size_t count,
+	                       ResultSink& sink, ThreadPool& pool);
+
+private:
+	std::size_t rows_;
+	std::size_t cols_;
+	std::string letters_; // The letters of the board in row-major order.
+	std::shared_ptr<const DynamicBoggle> dynamic_; // The board if no Boggle<N, M> solves it.
+
+	/*
+	 * Call the given function with the board as an instance of the kernel that solves it, and
+	 * return what it returns.
+	 */
+	template <typename F>
+	auto dispatch(F&& f) const -> decltype(f(std::declval<const DynamicBoggle&>()));
+
+	/*
+	 * Return the workspace of the calling thread for the kernel of type B.
+	 */
+	template <typename B>
+	static typename B::Workspace& thread_workspace();
+};
+
+inline AnyBoggle::AnyBoggle(std::size_t rows, std::size_t cols, std::string letters) :
+		rows_(rows),
+		cols_(cols),
+		letters_(std::move(letters)),
+		dynamic_() {
+	if (rows == 0 or cols == 0 or letters_.size() != rows * cols) {
+		throw std::invalid_argument("a " + std::to_string(rows) + " by " + std::to_string(cols) +
+		                            " board can not hold " + std::to_string(letters_.size()) +
+		                            " letters");
+	}
+	if (not specialized()) {
+		dynamic_ = std::make_shared<const DynamicBoggle>(rows_, cols_, letters_);
+	}
+}
+
+inline std::size_t AnyBoggle::rows() const {
+	return rows_;
+}
+
+inline std::size_t AnyBoggle::cols() const {
+	return cols_;
+}
+
+inline const std::string& AnyBoggle::letters() const {
+	return letters_;
+}
+
+inline bool AnyBoggle::specialized() const {
+	return rows_ == cols_ and (rows_ == 4 or rows_ == 5 or rows_ == 6 or rows_ == 8);
+}
+
+inline std::vector<std::string> AnyBoggle::solve(const Trie& dictionary) const {
+	return solve(dictionary, ThreadPool::global());
+}
+
+inline std::vector<std::string> AnyBoggle::solve(const Trie& dictionary, ThreadPool& pool) const {
+	return dispatch([&](const auto& boggle) {
+		return boggle.solve(dictionary, pool);
+	});
+}
+
+inline std::vector<std::string> AnyBoggle::solve(const Trie& dictionary, ThreadPool& pool,
+                                                 SearchStats& stats) const {
+	return dispatch([&](const auto& boggle) {
+		return boggle.solve(dictionary, pool, stats);
+	});
+}
+
+inline std::vector<std::uint32_t> AnyBoggle::solve_ids(const Trie& dictionary,
+                                                       ThreadPool& pool) const {
+	return dispatch([&](const auto& boggle) {
+		return boggle.solve_ids(dictionary, pool);
+	});
+}
+
+inline void AnyBoggle::solve(const Trie& dictionary, std::vector<std::string>& words) const {
+	dispatch([&](const auto& boggle) {
+		using kernel_t = std::decay_t<decltype(boggle)>;
+		boggle.solve(dictionary, thread_workspace<kernel_t>(), words);
+	});
+}
+
+inline void AnyBoggle::solve(const Trie& dictionary, std::vector<std::string>& words,
+                             SearchStats& stats) const {
+	dispatch([&](const auto& boggle) {
+		using kernel_t = std::decay_t<decltype(boggle)>;
+		boggle.solve(dictionary, thread_workspace<kernel_t>(), words, stats);
+	});
+}
+
+template <typename Visitor>
+bool AnyBoggle::visit(const Trie& dictionary, Visitor&& visitor) const {
+	return dispatch([&](const auto& boggle) {
+		using kernel_t = std::decay_t<decltype(boggle)>;
+		return boggle.visit(dictionary, thread_workspace<kernel_t>(), visitor);
+	});
+}
+
+inline void AnyBoggle::solve_many(const Trie& dictionary, const AnyBoggle *boards,
+                                  std::size_t count, ResultSink& sink, ThreadPool& pool) {
+	sink.reset(count);
+	std::atomic<std::size_t> next(0);
+	auto job = [&](std::size_t) {
+		std::vector<std::string> words;
+		for (std::size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+			boards[i].solve(dictionary, words);
+			sink.append(i, words);
+		}
+	};
+	pool.run(job);
+}
+
+template <typename F>
+auto AnyBoggle::dispatch(F&& f) const -> decltype(f(std::declval<const DynamicBoggle&>())) {
+	if (dynamic_) {
+		return f(*dynamic_);
+	}
+	switch (rows_) {
+		case 4:
+			return f(Boggle<4, 4>(letters_));
+		case 5:
+			return f(Boggle<5, 5>(letters_));
+		case 6:
+			return f(Boggle<6, 6>(letters_));
+		default:
+			return f(Boggle<8, 8>(letters_));
+	}
+}
+
+template <typename B>
+typename B::Workspace& AnyBoggle::thread_workspace() {
+	thread_local typename B::Workspace workspace;
+	return workspace;
+}
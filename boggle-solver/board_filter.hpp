@@ -0,0 +1,198 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "neighbours.hpp"
+
+/*
+ * What an N by M Boggle board rules out of the dictionary before it is searched.
+ *
+ * A word can only be on the board if the board has at least as many squares of each of its letters
+ * as the word uses, and if every two consecutive letters of the word are on adjacent squares. The
+ * filter holds the number of squares of each letter, the 26 by 26 matrix of letters that are next
+ * to each other somewhere on the board, and, for each square, the letters of its neighbours, which
+ * is the row of the matrix for the letter of that one square. The search uses the last of these to
+ * drop a trie edge as soon as it is taken: a node none of whose children is a letter next to the
+ * square that reached it is a dead end, and is only looked at if it is a word itself.
+ *
+ * Words are read as squares, 'QU' being the single square 'Q'. On boards of at most 64 squares, the
+ * squares of each letter are kept as a 64-bit set and the squares next to any of them are found all
+ * at once by shifting the set by a column and a row, so the filter is built with a handful of word
+ * operations per letter on the board rather than a loop over every square and neighbour. Larger
+ * boards go through the neighbours of each square, as do boards whose dimensions are only known at
+ * run time, BoardFilter<dynamic_size, dynamic_size>, whose filter is rebuilt with the table of
+ * neighbours of the board.
+ */
+template <std::size_t N, std::size_t M>
+class BoardFilter {
+public:
+	/*
+	 * Create the filter of a board with no letters, which rules out every word.
+	 */
+	BoardFilter() :
+			counts_(),
+			pairs_(),
+			next_() { }
+
+	/*
+	 * Create the filter of the board with the given N * M letters, in row-major order.
+	 */
+	explicit BoardFilter(const char *board) :
+			BoardFilter() {
+		reset(board);
+	}
+
+	/*
+	 * Rebuild the filter for the board with the given N * M letters, in row-major order.
+	 */
+	void reset(const char *board) {
+		reset(board, Neighbours<N, M>());
+	}
+
+	/*
+	 * Rebuild the filter for the board with the given letters, in row-major order, and the given
+	 * neighbours.
+	 */
+	void reset(const char *board, const Neighbours<N, M>& neighbours) {
+		counts_.fill(0);
+		pairs_.fill(0);
+		clear(next_, neighbours.size());
+		build(board, neighbours, std::integral_constant<bool, N * M != 0 and N * M <= 64>());
+	}
+
+	/*
+	 * Return the number of squares with the given letter.
+	 */
+	std::size_t count(char c) const {
+		return counts_[static_cast<std::size_t>(c - 'A')];
+	}
+
+	/*
+	 * Return true if a square with letter 'a' is next to a square with letter 'b'.
+	 */
+	bool adjacent(char a, char b) const {
+		return (pairs_[static_cast<std::size_t>(a - 'A')] & bit(b)) != 0;
+	}
+
+	/*
+	 * Return the letters of the neighbours of the given square, bit i standing for 'A' + i.
+	 */
+	std::uint32_t next_letters(std::size_t square) const {
+		return next_[square];
+	}
+
+	/*
+	 * Return false if the given uppercase word can not be on the board, because it uses a letter
+	 * more often than the board has it or two consecutive letters that are never adjacent. A word
+	 * that passes may still not be on the board.
+	 */
+	bool admits(const char *word) const {
+		std::array<std::uint16_t, 26> used{};
+		char previous = 0;
+		for (const char *c = word; *c != '\0'; ++c) {
+			char square = *c;
+			// The 'U' after a 'Q' is part of the same square.
+			if (square < 'A' or square > 'Z' or (square == 'Q' and *++c != 'U')) {
+				return false;
+			}
+			if (++used[static_cast<std::size_t>(square - 'A')] > count(square) or
+			    (previous != 0 and not adjacent(previous, square))) {
+				return false;
+			}
+			previous = square;
+		}
+		return true;
+	}
+
+private:
+	std::array<std::uint16_t, 26> counts_; // The number of squares with each letter.
+	std::array<std::uint32_t, 26> pairs_; // Bit j of the ith element is set if a square with
+	// letter 'A' + i is next to a square with letter 'A' + j.
+	std::conditional_t<N * M == 0, std::vector<std::uint32_t>,
+	                   std::array<std::uint32_t, N * M>> next_; // The letters of the neighbours of
+	// each square.
+
+	static std::uint32_t bit(char c) {
+		return std::uint32_t{1} << (c - 'A');
+	}
+
+	/*
+	 * Set the letters of the neighbours of each of the given number of squares to none.
+	 */
+	static void clear(std::array<std::uint32_t, N * M>& next, std::size_t) {
+		next.fill(0);
+	}
+
+	static void clear(std::vector<std::uint32_t>& next, std::size_t size) {
+		next.assign(size, 0);
+	}
+
+	/*
+	 * Return the set of squares that are next to a square in the given set, on a board of at most
+	 * 64 squares. A board of one row of 64 squares has no rows above or below to shift to, and
+	 * shifting by 64 would be undefined, so its squares are only spread sideways.
+	 */
+	static std::uint64_t dilate(std::uint64_t squares) {
+		constexpr std::uint64_t board = N * M == 64 ? ~std::uint64_t{0} :
+		                                (std::uint64_t{1} << (N * M % 64)) - 1;
+		constexpr std::uint64_t not_first = not_column(0);
+		constexpr std::uint64_t not_last = not_column(M - 1);
+		std::uint64_t sideways = ((squares << 1) & not_first) | ((squares >> 1) & not_last);
+		if (M >= 64) {
+			return sideways & board;
+		}
+		std::uint64_t row = squares | sideways;
+		return (sideways | (row << (M % 64)) | (row >> (M % 64))) & board;
+	}
+
+	/*
+	 * Return the set of squares that are not in the given column, on a board of at most 64
+	 * squares.
+	 */
+	static constexpr std::uint64_t not_column(std::size_t col) {
+		std::uint64_t squares = 0;
+		for (std::size_t i = 0; i < N * M; ++i) {
+			if (i % M != col) {
+				squares |= std::uint64_t{1} << (i % 64);
+			}
+		}
+		return squares;
+	}
+
+	void build(const char *board, const Neighbours<N, M>&, std::true_type) {
+		std::array<std::uint64_t, 26> squares{}; // The squares with each letter.
+		std::uint32_t present = 0;
+		for (std::size_t i = 0; i < N * M; ++i) {
+			squares[static_cast<std::size_t>(board[i] - 'A')] |= std::uint64_t{1} << i;
+			present |= bit(board[i]);
+		}
+
+		for (std::uint32_t letters = present; letters != 0; letters &= letters - 1) {
+			auto l = static_cast<std::size_t>(__builtin_ctz(letters));
+			counts_[l] = static_cast<std::uint16_t>(__builtin_popcountll(squares[l]));
+			for (std::uint64_t near = dilate(squares[l]); near != 0; near &= near - 1) {
+				next_[static_cast<std::size_t>(__builtin_ctzll(near))] |= std::uint32_t{1} << l;
+			}
+		}
+		for (std::size_t i = 0; i < N * M; ++i) {
+			pairs_[static_cast<std::size_t>(board[i] - 'A')] |= next_[i];
+		}
+	}
+
+	void build(const char *board, const Neighbours<N, M>& neighbours, std::false_type) {
+		typename Neighbours<N, M>::set_t none{};
+		neighbours.clear(none);
+		for (std::size_t i = 0; i < neighbours.size(); ++i) {
+			++counts_[static_cast<std::size_t>(board[i] - 'A')];
+			auto cursor = neighbours.begin(i, none);
+			std::size_t neighbour;
+			while (neighbours.next(i, cursor, none, neighbour)) {
+				next_[i] |= bit(board[neighbour]);
+			}
+			pairs_[static_cast<std::size_t>(board[i] - 'A')] |= next_[i];
+		}
+	}
+};
@@ -0,0 +1,766 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "board_filter.hpp"
+#include "found_words.hpp"
+#include "neighbours.hpp"
+#include "search_stats.hpp"
+#include "thread_pool.hpp"
+#include "trace.hpp"
+#include "trie.hpp"
+#include "work_queue.hpp"
+
+template <std::size_t N, std::size_t M>
+class Boggle;
+
+/*
+ * The search that finds the words of an N by M Boggle board, shared by Boggle<N, M> and, with N and
+ * M both dynamic_size, DynamicBoggle.
+ *
+ * A search sees the board only through its letters, in row-major order, and the Neighbours of its
+ * squares. For the fixed sizes the neighbours are compile-time tables and the functions of
+ * Neighbours<N, M> are static, so going through an instance costs nothing; for dynamic_size they
+ * are the table built for the board. A BoardSearch is a view created for each solve and must not
+ * outlive the letters or the neighbours it was created with.
+ */
+template <std::size_t N, std::size_t M>
+class BoardSearch {
+public:
+	using neighbours_t = Neighbours<N, M>; // Adjacency of the squares of the board.
+
+	/*
+	 * Scratch memory used by a single thread to search a board: the DFS frames, which double as
+	 * the current path through the board, the set of squares on that path, the word spelled out by
+	 * the path, the set of words already found and the filter of the board, see BoardFilter. The
+	 * buffers are sized for the longest possible path when the workspace is created, or on its
+	 * first search if the dimensions of the board are only known at run time, and grow to fit the
+	 * largest board searched with it. They are then modified in place, so a search does not
+	 * allocate. A workspace can be reused for any number of searches but must not be shared by
+	 * threads searching at the same time.
+	 */
+	class Workspace {
+		friend BoardSearch;
+		friend Boggle<N, M>;
+	public:
+		Workspace() :
+				cursor_(),
+				found_(),
+				filter_(),
+				filtered_(true),
+				cursors_(),
+				results_() { }
+
+		/*
+		 * Choose whether searches using the workspace build the filter of the board first and skip
+		 * the dictionary nodes it rules out. On by default; the words found are the same either
+		 * way.
+		 */
+		void use_filter(bool enabled) {
+			filtered_ = enabled;
+		}
+
+		/*
+		 * Choose how many searches, each from a starting square of its own, a solve on the calling
+		 * thread using the workspace advances in turn. Each search asks for the dictionary nodes it
+		 * steps into next to be loaded into the cache before giving way to the next, so that the
+		 * loads of the searches overlap instead of stalling one after the other. 1 by default, a
+		 * single search; 0 is taken as 1. The words found are the same either way, but a solve with
+		 * several searches finds them, and passes them to a visitor, in another order. Allocates
+		 * the buffers of the searches, so it is best called once, before the workspace is used.
+		 * Parallel solves always run one search per thread.
+		 */
+		void interleave(std::size_t searches) {
+			cursors_.clear();
+			cursors_.resize(searches > 1 ? searches : 0);
+		}
+
+	private:
+		struct frame_t {
+			Trie::node_t node; // Trie node reached by the word spelled out by the path so far.
+			std::uint32_t id; // Word ID accumulated on the way to 'node', see Trie::child.
+			std::size_t square; // Square at this depth of the path.
+			typename neighbours_t::cursor_t next; // The neighbours of the square left to try.
+		};
+
+		/*
+		 * The state of a search: the current path, the squares on it and the word it spells out.
+		 * The workspace keeps one for a single search and one for each of the searches a solve
+		 * advances in turn, see interleave.
+		 */
+		struct cursor_t {
+			cursor_t() :
+					frames(N * M),
+					visited(),
+					word(2 * N * M),
+					length(0),
+					depth(0),
+					active(false) { }
+
+			/*
+			 * Make room for a path through the given number of squares, and empty the set of
+			 * squares on the path.
+			 */
+			void reset(const neighbours_t& neighbours) {
+				if (frames.size() < neighbours.size()) {
+					frames.resize(neighbours.size());
+					word.resize(2 * neighbours.size());
+				}
+				neighbours.clear(visited);
+			}
+
+			std::vector<frame_t> frames; // frames[0..depth] is the current path.
+			typename neighbours_t::set_t visited; // The squares in frames[0..depth].
+			std::vector<char> word; // The word spelled out by the path, two characters for QU.
+			std::size_t length; // The number of characters in 'word'.
+			std::size_t depth; // The index of the last frame of the path.
+			bool active; // False once no starting square is left for the search.
+		};
+
+		cursor_t cursor_; // The state of a single search.
+		FoundWords found_; // The words found on the board being solved.
+		BoardFilter<N, M> filter_; // The filter of the board being solved.
+		bool filtered_; // True if searches use filter_.
+		std::vector<cursor_t> cursors_; // The searches a solve advances in turn, or none if it
+		// runs a single search with cursor_.
+		std::tuple<std::vector<std::string>, std::vector<std::uint32_t>> results_; // The words or
+		// word IDs found by this thread in a parallel solve or on its current board in solve_many.
+
+		/*
+		 * Return the buffer of results of the given type.
+		 */
+		template <typename T>
+		std::vector<T>& results() {
+			return std::get<std::vector<T>>(results_);
+		}
+	};
+
+	/*
+	 * A word found by visit: its letters, its ID in the dictionary, and the squares of the path
+	 * that spells it out. The pointers are only valid during the call to the visitor.
+	 */
+	struct Match {
+		const char *word; // The letters of the word, not null-terminated.
+		std::size_t length; // The number of letters in the word.
+		std::uint32_t id; // The ID of the word in the dictionary.
+		std::size_t path_length; // The number of squares in the path.
+
+		/*
+		 * Return the index of the ith square of the path, in row-major order.
+		 */
+		std::size_t square(std::size_t i) const {
+			return frames_[i].square;
+		}
+
+		const typename Workspace::frame_t *frames_; // The DFS frames holding the path.
+	};
+
+	/*
+	 * Create a search of the board with the given letters, in row-major order, whose squares have
+	 * the given neighbours.
+	 */
+	BoardSearch(const char *board, const neighbours_t& neighbours);
+
+	/*
+	 * Find the words in the board with the work-stealing search on the threads of the given pool
+	 * and return them, either as strings or as IDs in the dictionary depending on T, counting the
+	 * work done in the given stats, see SearchStats.
+	 */
+	template <typename T, typename Stats>
+	std::vector<T> solve_parallel(const Trie& dictionary, ThreadPool& pool, Stats& stats) const;
+
+	/*
+	 * Find the words in the board on the calling thread and pass them to the given output, see
+	 * add_result, counting the work done in the given stats. Return false if the output stopped the
+	 * search.
+	 */
+	template <typename Output, typename Stats>
+	bool solve_serial(const Trie& dictionary, Workspace& workspace, Output& output,
+	                  Stats& stats) const;
+
+	/*
+	 * Return the workspace of the calling thread, which is kept for the lifetime of the thread so
+	 * that repeated solves on the threads of a pool reuse it.
+	 */
+	static Workspace& thread_workspace();
+
+private:
+	const char *board_; // The letters of the board. Note that the QU square is simply 'Q'.
+	const neighbours_t& neighbours_; // The neighbours of the squares of the board.
+
+	/*
+	 * A unit of work for the work-stealing search in solve_parallel: either all the paths starting
+	 * from a square, or all the paths starting with a given pair of adjacent squares.
+	 */
+	struct task_t {
+		std::size_t path[2]; // The squares the paths start with.
+		std::size_t length; // The number of squares in 'path', 1 or 2.
+		Trie::node_t node; // The dictionary node reached by the squares, if 'length' is 2.
+		std::uint32_t id; // The word ID accumulated on the way to 'node'.
+	};
+
+	/*
+	 * The outcome of advancing a search by one step, see advance.
+	 */
+	enum class advance_t {
+		pushed, // A square was added to the path.
+		popped, // The last square of the path was taken off it.
+		exhausted, // No neighbour of the last square is left to try and the path is at its start.
+		stopped // The output stopped the search.
+	};
+
+	/*
+	 * As solve_serial, advancing the searches of the given workspace in turn, see
+	 * Workspace::interleave. The workspace must have at least two.
+	 */
+	template <typename Output, typename Stats>
+	bool solve_interleaved(const Trie& dictionary, Workspace& workspace, Output& output,
+	                       Stats& stats) const;
+
+	/*
+	 * Find all words that start from the ith element of the board and are not yet in the given set
+	 * of found words, add them to the set and pass them to the given output, using the given
+	 * workspace and counting the work done in the given stats. Return false if the output stopped
+	 * the search. No bounds checks are made. Not thread safe, except for the set.
+	 */
+	template <typename Output, typename Stats>
+	bool solve_starting_at(const Trie& dictionary, std::size_t i, Workspace& workspace,
+	                       FoundWords& found, Output& output, Stats& stats) const;
+
+	/*
+	 * Find all words whose paths begin with the given path through the board, which spells out the
+	 * word reaching the given dictionary node with the given accumulated ID, and that are not yet
+	 * in the given set of found words. Add them to the set and pass them to the given output, using
+	 * the given workspace and counting the work done in the given stats. The path itself is
+	 * included if it is a word. Return false if the output stopped the search. No bounds checks are
+	 * made. Not thread safe, except for the set.
+	 */
+	template <typename Output, typename Stats>
+	bool search(const Trie& dictionary, const std::size_t *path, std::size_t path_length,
+	            Trie::node_t node, std::uint32_t id, Workspace& workspace, FoundWords& found,
+	            Output& output, Stats& stats) const;
+
+	/*
+	 * Advance the DFS of search along the path held by the given cursor, whose word has the given
+	 * length and whose last frame is at the given depth, by one step: add the next neighbour of the
+	 * last square that is not on the path and continues a word, passing the new word to the given
+	 * output if it is one and not yet in the given set of found words, or take the last square off
+	 * the path if no neighbour is left, unless the path is at the given starting depth. Neighbours
+	 * the given filter of the board rules out going on from, unless it is null, are only checked
+	 * for ending a word. The length and depth are updated in place, and the work done is counted in
+	 * the given stats.
+	 */
+	template <typename Output, typename Stats>
+	advance_t advance(const Trie& dictionary, const BoardFilter<N, M> *filter,
+	                  typename Workspace::cursor_t& cursor, std::size_t& length, std::size_t& depth,
+	                  std::size_t start_depth, FoundWords& found, Output& output,
+	                  Stats& stats) const;
+
+	/*
+	 * Run the given task of the work-stealing search, placing words in the given vector and any
+	 * tasks it is split into in the given queue, and counting the work done in the given stats.
+	 * Return the number of tasks added to the queue.
+	 */
+	template <typename T, typename Stats>
+	std::size_t run_task(const Trie& dictionary, const task_t& task, Workspace& workspace,
+	                     FoundWords& found, WorkQueue<task_t>& queue, std::vector<T>& words,
+	                     Stats& stats) const;
+
+	/*
+	 * Make the given workspace ready to search the board: size its buffers for the board, empty
+	 * the sets of squares of its searches and build the filter of the board, if it uses one.
+	 */
+	void prepare(Workspace& workspace) const;
+
+	/*
+	 * Return the node of the given dictionary reached from the given node by appending the letters
+	 * of a square with the given character, i.e. "QU" for 'Q', accumulating the word ID in 'id' and
+	 * counting the step in the given stats. Return 0 if no word continues that way.
+	 */
+	template <typename Stats>
+	static Trie::node_t step(const Trie& dictionary, Trie::node_t node, char c, std::uint32_t& id,
+	                         Stats& stats);
+
+	/*
+	 * Claim the word with the given ID in the given set of found words, counting the hit in the
+	 * given stats, and return true if it was not found before.
+	 */
+	template <typename Stats>
+	static bool claim(FoundWords& found, std::uint32_t id, Stats& stats);
+
+	/*
+	 * Return the number of seconds since the given time.
+	 */
+	static double seconds_since(std::chrono::steady_clock::time_point start);
+
+	/*
+	 * Write the letters of a square with the given character to the given word buffer at the given
+	 * length, and return the new length of the word.
+	 */
+	static std::size_t push_letters(char *word, std::size_t length, char c);
+
+	/*
+	 * Pass a word found by the search, spelled out by the given characters, with the given ID and
+	 * found on the path held by the given frames, to the given output: a vector of words, a vector
+	 * of word IDs or a visitor. Return false if the search should stop, which only a visitor asks
+	 * for.
+	 */
+	static bool add_result(std::vector<std::string>& words, const char *word, std::size_t length,
+	                       std::uint32_t id, const typename Workspace::frame_t *frames,
+	                       std::size_t path_length);
+
+	static bool add_result(std::vector<std::uint32_t>& ids, const char *word, std::size_t length,
+	                       std::uint32_t id, const typename Workspace::frame_t *frames,
+	                       std::size_t path_length);
+
+	template <typename Visitor>
+	static bool add_result(Visitor& visitor, const char *word, std::size_t length,
+	                       std::uint32_t id, const typename Workspace::frame_t *frames,
+	                       std::size_t path_length);
+};
+
+template <std::size_t N, std::size_t M>
+BoardSearch<N, M>::BoardSearch(const char *board, const neighbours_t& neighbours) :
+		board_(board),
+		neighbours_(neighbours) { }
+
+template <std::size_t N, std::size_t M>
+template <typename T, typename Stats>
+std::vector<T> BoardSearch<N, M>::solve_parallel(const Trie& dictionary, ThreadPool& pool,
+                                                 Stats& stats) const {
+	// The search is balanced with work stealing. Every thread has a queue of tasks, and the
+	// starting squares are dealt out to the queues as the first tasks. A thread takes tasks from
+	// the back of its own queue; a task for a starting square is split into one task for each
+	// neighbour that continues a word, which go to the back of the queue, and a task for a pair of
+	// squares is searched to the end. A thread whose queue is empty steals from the front of
+	// another queue, taking a whole starting square if one is left and a pair of squares
+	// otherwise. 'remaining' counts the tasks that have not finished; a task's subtasks are added
+	// to it before the task itself is subtracted, so it only reaches zero once all the work is done.
+	// The threads share the set of found words of the calling thread, so a word found on several
+	// paths is only kept by the thread that claims it first and there is nothing left to merge.
+	const std::size_t size = neighbours_.size();
+	std::size_t n_threads = pool.size();
+	std::vector<WorkQueue<task_t>> queues(n_threads);
+	for (auto& queue : queues) {
+		// A queue holds at most its share of the starting squares plus the subtasks of one square.
+		queue.reset((size + n_threads - 1) / n_threads + 8);
+	}
+	for (std::size_t i = 0; i < size; ++i) {
+		queues[i % n_threads].push(task_t{{i, 0}, 1, 0, 0});
+	}
+	std::atomic<std::size_t> remaining(size);
+	FoundWords& found = thread_workspace().found_;
+	found.reset(dictionary.word_count());
+
+	// Each thread places its words in the buffer of its own workspace and counts into stats of its
+	// own, and the buffers are concatenated and the stats merged once every thread is done.
+	std::vector<std::vector<T> *> buffers(n_threads);
+	std::vector<Stats> thread_stats(n_threads);
+	// Each thread's part in the search is a span of the trace, if tracing is enabled.
+	static const std::uint32_t span_name = Tracer::global().name("search");
+	auto job = [&](std::size_t thread) {
+		TraceSpan span(span_name);
+		Workspace& workspace = thread_workspace();
+		std::vector<T>& buffer = workspace.template results<T>();
+		buffer.clear();
+		buffers[thread] = &buffer;
+		prepare(workspace);
+		Stats& local = thread_stats[thread];
+		local.reset(size);
+
+		task_t task;
+		while (remaining.load() != 0) {
+			bool have_task = queues[thread].pop(task);
+			for (std::size_t i = 1; i < n_threads and not have_task; ++i) {
+				have_task = queues[(thread + i) % n_threads].steal(task);
+			}
+			if (not have_task) {
+				std::this_thread::yield();
+				continue;
+			}
+
+			auto start = Stats::enabled ? std::chrono::steady_clock::now() :
+			             std::chrono::steady_clock::time_point();
+			std::size_t n_subtasks =
+					run_task(dictionary, task, workspace, found, queues[thread], buffer, local);
+			if (Stats::enabled) {
+				local.busy(thread, seconds_since(start));
+			}
+			remaining.fetch_add(n_subtasks);
+			remaining.fetch_sub(1);
+		}
+	};
+	pool.run(job);
+	stats.reset(size);
+	for (const auto& local : thread_stats) {
+		stats.merge(local);
+	}
+
+	std::size_t n_words = 0;
+	for (const auto *buffer : buffers) {
+		n_words += buffer->size();
+	}
+	std::vector<T> words;
+	words.reserve(n_words);
+	for (auto *buffer : buffers) {
+		std::move(buffer->begin(), buffer->end(), std::back_inserter(words));
+	}
+	return words;
+}
+
+template <std::size_t N, std::size_t M>
+template <typename Output, typename Stats>
+bool BoardSearch<N, M>::solve_serial(const Trie& dictionary, Workspace& workspace, Output& output,
+                                     Stats& stats) const {
+	workspace.found_.reset(dictionary.word_count());
+	prepare(workspace);
+	if (not workspace.cursors_.empty()) {
+		return solve_interleaved(dictionary, workspace, output, stats);
+	}
+	for (std::size_t i = 0; i < neighbours_.size(); ++i) {
+		if (not solve_starting_at(dictionary, i, workspace, workspace.found_, output, stats)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+template <std::size_t N, std::size_t M>
+template <typename Output, typename Stats>
+bool BoardSearch<N, M>::solve_interleaved(const Trie& dictionary, Workspace& workspace,
+                                          Output& output, Stats& stats) const {
+	// Each cursor runs the DFS of search on a starting square of its own, taking the next square
+	// left once it is done with one, but only up to the next step down the trie: once a cursor has
+	// pushed a frame for a new node, it asks for the node's children, which its next step will
+	// read, to be prefetched, and the next cursor takes its turn. By the time the round comes back
+	// to the cursor, the children have had the turns of all the other cursors to arrive, so the
+	// misses of the cursors overlap rather than each stalling the thread in turn. Backtracking
+	// only returns to nodes whose children were read before and does not give way. The cursors
+	// share the set of found words, so as with threads each word is kept by the cursor that claims
+	// it first. Single squares spell out at most two letters, so a cursor starts without checking
+	// for a word.
+
+	using frame_t = typename Workspace::frame_t;
+	using cursor_t = typename Workspace::cursor_t;
+
+	FoundWords& found = workspace.found_;
+	const auto *filter = workspace.filtered_ ? &workspace.filter_ : nullptr;
+
+	// Start the given cursor on the next square that begins a word, if any is left.
+	std::size_t next_square = 0;
+	auto start = [&](cursor_t& cursor) {
+		while (next_square < neighbours_.size()) {
+			std::size_t square = next_square++;
+			std::uint32_t id = 0;
+			Trie::node_t node = step(dictionary, 0, board_[square], id, stats);
+			if (node == 0) {
+				continue;
+			}
+			auto& visited = cursor.visited;
+			neighbours_.clear(visited);
+			neighbours_.insert(visited, square);
+			cursor.frames[0] = frame_t{node, id, square, neighbours_.begin(square, visited)};
+			cursor.length = push_letters(cursor.word.data(), 0, board_[square]);
+			cursor.depth = 0;
+			stats.expand(square);
+			dictionary.prefetch(node);
+			return true;
+		}
+		return false;
+	};
+
+	std::size_t n_active = 0;
+	for (auto& cursor : workspace.cursors_) {
+		cursor.active = start(cursor);
+		n_active += cursor.active;
+	}
+	while (n_active != 0) {
+		for (auto& cursor : workspace.cursors_) {
+			if (not cursor.active) {
+				continue;
+			}
+			std::size_t length = cursor.length;
+			std::size_t depth = cursor.depth;
+			while (true) {
+				auto result = advance(dictionary, filter, cursor, length, depth, 0, found,
+				                      output, stats);
+				if (result == advance_t::stopped) {
+					return false;
+				}
+				if (result == advance_t::exhausted) {
+					// Move on to the next starting square.
+					neighbours_.erase(cursor.visited, cursor.frames[0].square);
+					cursor.active = start(cursor);
+					n_active -= not cursor.active;
+					break;
+				}
+				if (result == advance_t::pushed) {
+					dictionary.prefetch(cursor.frames[depth].node);
+					cursor.length = length;
+					cursor.depth = depth;
+					break;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+template <std::size_t N, std::size_t M>
+template <typename Output, typename Stats>
+bool BoardSearch<N, M>::solve_starting_at(const Trie& dictionary, std::size_t i,
+                                          Workspace& workspace, FoundWords& found, Output& output,
+                                          Stats& stats) const {
+	std::uint32_t id = 0;
+	Trie::node_t node = step(dictionary, 0, board_[i], id, stats);
+	return node == 0 or search(dictionary, &i, 1, node, id, workspace, found, output, stats);
+}
+
+template <std::size_t N, std::size_t M>
+template <typename Output, typename Stats>
+bool BoardSearch<N, M>::search(const Trie& dictionary, const std::size_t *path,
+                               std::size_t path_length, Trie::node_t node, std::uint32_t id,
+                               Workspace& workspace, FoundWords& found, Output& output,
+                               Stats& stats) const {
+	// A modified DFS algorithm is used to find all words in the Boggle board.
+	// The DFS is iterative and backtracks in place: frames[0..depth] holds the current path through
+	// the board, each frame storing its square, the trie node reached by the word spelled out so
+	// far, and which of the square's neighbours are left to try. The squares on the path are also
+	// kept in a bitset, so checking whether a neighbour is free is a single bit test (on boards of
+	// at most 64 squares the free neighbours are found all at once with a mask). The word itself is
+	// kept alongside in a character buffer. Extending the path is a single step down the trie (two
+	// for the QU square) and is only done if the trie has a child for the new letters, so every path
+	// is the prefix of a valid word, and it is a word itself if its node is terminal. When a square
+	// has no neighbours left to try, its frame and its letters are popped, until the search is back
+	// to the path it started from. Each frame also carries the ID of its word, accumulated on the
+	// way down the trie, and a word is only kept if this search is the first to claim that ID in the
+	// set of found words, so no word is kept twice. Nothing is allocated except the words that are
+	// found. If the output asks to stop, the path is abandoned where it is. With the filter of the
+	// board, a step to a node that has no child for any letter next to the new square is never
+	// pushed: the node is checked for being a word right away and the search moves on to the next
+	// neighbour, which saves pushing a frame only to try each of its neighbours in vain. Each step
+	// of the DFS is taken by advance, which solve_interleaved uses to run its searches as well.
+
+	using frame_t = typename Workspace::frame_t;
+
+	auto& cursor = workspace.cursor_;
+	auto& frames = cursor.frames;
+	auto& visited = cursor.visited;
+	char *word = cursor.word.data();
+	const auto *filter = workspace.filtered_ ? &workspace.filter_ : nullptr;
+
+	// Only the last frame of the starting path is ever resumed, so the others just need squares.
+	std::size_t length = 0;
+	for (std::size_t i = 0; i < path_length; ++i) {
+		length = push_letters(word, length, board_[path[i]]);
+		neighbours_.insert(visited, path[i]);
+		frames[i] = frame_t{0, 0, path[i], typename neighbours_t::cursor_t()};
+	}
+	const std::size_t start_depth = path_length - 1;
+	std::size_t depth = start_depth;
+	frames[depth] = frame_t{node, id, path[depth], neighbours_.begin(path[depth], visited)};
+	stats.expand(path[0]);
+	if (dictionary.terminal(node) and length >= 3 and claim(found, id, stats) and
+	    not add_result(output, word, length, id, frames.data(), depth + 1)) {
+		neighbours_.clear(visited);
+		return false;
+	}
+
+	while (true) {
+		auto result = advance(dictionary, filter, cursor, length, depth, start_depth, found,
+		                      output, stats);
+		if (result == advance_t::stopped) {
+			neighbours_.clear(visited);
+			return false;
+		}
+		if (result == advance_t::exhausted) {
+			for (std::size_t i = 0; i < path_length; ++i) {
+				neighbours_.erase(visited, path[i]);
+			}
+			return true;
+		}
+	}
+}
+
+template <std::size_t N, std::size_t M>
+template <typename Output, typename Stats>
+inline typename BoardSearch<N, M>::advance_t BoardSearch<N, M>::advance(
+		const Trie& dictionary, const BoardFilter<N, M> *filter,
+		typename Workspace::cursor_t& cursor, std::size_t& length, std::size_t& depth,
+		std::size_t start_depth, FoundWords& found, Output& output, Stats& stats) const {
+	using frame_t = typename Workspace::frame_t;
+
+	frame_t *frames = cursor.frames.data();
+	auto& visited = cursor.visited;
+	char *word = cursor.word.data();
+	frame_t& frame = frames[depth];
+
+	// Find the next neighbour that is not already in the path and continues a word.
+	Trie::node_t next = 0;
+	std::size_t neighbour = 0;
+	std::uint32_t next_id = 0;
+	while (next == 0 and neighbours_.next(frame.square, frame.next, visited, neighbour)) {
+		next_id = frame.id;
+		next = step(dictionary, frame.node, board_[neighbour], next_id, stats);
+		if (next == 0 or filter == nullptr or
+		    (dictionary.letters(next) & filter->next_letters(neighbour)) != 0) {
+			continue;
+		}
+		stats.filtered();
+
+		// The word can not go on from the neighbour, so only check whether it ends there.
+		if (dictionary.terminal(next)) {
+			std::size_t end = push_letters(word, length, board_[neighbour]);
+			if (end >= 3 and claim(found, next_id, stats)) {
+				frames[depth + 1] = frame_t{next, next_id, neighbour, {}};
+				if (not add_result(output, word, end, next_id, frames, depth + 2)) {
+					return advance_t::stopped;
+				}
+			}
+		}
+		next = 0;
+	}
+
+	if (next == 0) {
+		// Backtrack.
+		if (depth == start_depth) {
+			return advance_t::exhausted;
+		}
+		neighbours_.erase(visited, frame.square);
+		length -= board_[frame.square] == 'Q' ? 2u : 1u;
+		--depth;
+		return advance_t::popped;
+	}
+
+	neighbours_.insert(visited, neighbour);
+	frames[++depth] = frame_t{next, next_id, neighbour, neighbours_.begin(neighbour, visited)};
+	stats.expand(frames[0].square);
+	length = push_letters(word, length, board_[neighbour]);
+	if (dictionary.terminal(next) and length >= 3 and claim(found, next_id, stats) and
+	    not add_result(output, word, length, next_id, frames, depth + 1)) {
+		return advance_t::stopped;
+	}
+	return advance_t::pushed;
+}
+
+template <std::size_t N, std::size_t M>
+template <typename T, typename Stats>
+std::size_t BoardSearch<N, M>::run_task(const Trie& dictionary, const task_t& task,
+                                        Workspace& workspace, FoundWords& found,
+                                        WorkQueue<task_t>& queue, std::vector<T>& words,
+                                        Stats& stats) const {
+	if (task.length == 2) {
+		search(dictionary, task.path, 2, task.node, task.id, workspace, found, words, stats);
+		return 0;
+	}
+
+	// Split the starting square into its neighbours. A single square is never a word. The set of
+	// squares of the workspace's search is empty between tasks, so it holds the square meanwhile.
+	std::size_t square = task.path[0];
+	std::uint32_t id = 0;
+	Trie::node_t node = step(dictionary, 0, board_[square], id, stats);
+	if (node == 0) {
+		return 0;
+	}
+	stats.expand(square);
+
+	auto& visited = workspace.cursor_.visited;
+	neighbours_.insert(visited, square);
+	auto cursor = neighbours_.begin(square, visited);
+	std::size_t neighbour;
+	std::size_t n_subtasks = 0;
+	while (neighbours_.next(square, cursor, visited, neighbour)) {
+		std::uint32_t next_id = id;
+		Trie::node_t next = step(dictionary, node, board_[neighbour], next_id, stats);
+		if (next != 0) {
+			queue.push(task_t{{square, neighbour}, 2, next, next_id});
+			++n_subtasks;
+		}
+	}
+	neighbours_.erase(visited, square);
+	return n_subtasks;
+}
+
+template <std::size_t N, std::size_t M>
+void BoardSearch<N, M>::prepare(Workspace& workspace) const {
+	workspace.cursor_.reset(neighbours_);
+	for (auto& cursor : workspace.cursors_) {
+		cursor.reset(neighbours_);
+	}
+	if (workspace.filtered_) {
+		workspace.filter_.reset(board_, neighbours_);
+	}
+}
+
+template <std::size_t N, std::size_t M>
+typename BoardSearch<N, M>::Workspace& BoardSearch<N, M>::thread_workspace() {
+	thread_local Workspace workspace;
+	return workspace;
+}
+
+template <std::size_t N, std::size_t M>
+template <typename Stats>
+Trie::node_t BoardSearch<N, M>::step(const Trie& dictionary, Trie::node_t node, char c,
+                                     std::uint32_t& id, Stats& stats) {
+	node = dictionary.child(node, c, id);
+	if (c == 'Q' and node != 0) {
+		stats.pass(node);
+		node = dictionary.child(node, 'U', id);
+	}
+	stats.step(node);
+	return node;
+}
+
+template <std::size_t N, std::size_t M>
+template <typename Stats>
+bool BoardSearch<N, M>::claim(FoundWords& found, std::uint32_t id, Stats& stats) {
+	bool first = found.claim(id);
+	stats.hit(first);
+	return first;
+}
+
+template <std::size_t N, std::size_t M>
+double BoardSearch<N, M>::seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <std::size_t N, std::size_t M>
+std::size_t BoardSearch<N, M>::push_letters(char *word, std::size_t length, char c) {
+	word[length++] = c;
+	if (c == 'Q') {
+		word[length++] = 'U';
+	}
+	return length;
+}
+
+template <std::size_t N, std::size_t M>
+bool BoardSearch<N, M>::add_result(std::vector<std::string>& words, const char *word,
+                                   std::size_t length, std::uint32_t,
+                                   const typename Workspace::frame_t *, std::size_t) {
+	words.emplace_back(word, length);
+	return true;
+}
+
+template <std::size_t N, std::size_t M>
+bool BoardSearch<N, M>::add_result(std::vector<std::uint32_t>& ids, const char *, std::size_t,
+                                   std::uint32_t id, const typename Workspace::frame_t *,
+                                   std::size_t) {
+	ids.push_back(id);
+	return true;
+}
+
+template <std::size_t N, std::size_t M>
+template <typename Visitor>
+bool BoardSearch<N, M>::add_result(Visitor& visitor, const char *word, std::size_t length,
+                                   std::uint32_t id, const typename Workspace::frame_t *frames,
+                                   std::size_t path_length) {
+	return visitor(Match{word, length, id, path_length, frames});
+}
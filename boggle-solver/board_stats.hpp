@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "boggle.hpp"
+#include "counter_rng.hpp"
+#include "dice.hpp"
+#include "histogram.hpp"
+#include "scoring.hpp"
+#include "thread_pool.hpp"
+#include "trie.hpp"
+
+/*
+ * The distributions of the number of words, the score and the length of the longest word of a
+ * sample of random boards.
+ *
+ * Boards are rolled from a DiceSet and solved in parallel, each thread rolling and solving boards
+ * with a workspace of its own and adding them to histograms of its own, which are merged once it
+ * runs out of boards. No word list is ever stored, so the memory needed does not grow with the
+ * number of boards. The ith board of a sample is rolled with the stream of a CounterRng keyed by
+ * the seed and i, and merging histograms is addition, so a sample only depends on the dice, the
+ * seed, the number of boards and the dictionary, not on the number of threads or how the boards
+ * were shared out between them.
+ */
+struct BoardStats {
+	std::uint64_t boards = 0; // The number of boards.
+	Histogram words; // The number of words of each board.
+	Histogram score; // The score of each board under the standard rules.
+	Histogram longest; // The number of letters of the longest word of each board, 'QU' being two.
+
+	/*
+	 * Add the statistics of the given sample.
+	 */
+	void merge(const BoardStats& other) {
+		boards += other.boards;
+		words.merge(other.words);
+		score.merge(other.score);
+		longest.merge(other.longest);
+	}
+
+	/*
+	 * Return the statistics of the given number of boards rolled from the given dice with the given
+	 * seed, solved with the given dictionary on the threads of the given pool. Throws
+	 * std::invalid_argument if the number of dice is not N * M.
+	 */
+	template <std::size_t N, std::size_t M = N>
+	static BoardStats sample(const DiceSet& dice, std::uint64_t n_boards, std::uint64_t seed,
+	                         const Trie& dictionary, ThreadPool& pool);
+
+	/*
+	 * As above, using the dictionary loaded with Boggle<N, M>::load_dictionary and the threads of
+	 * the process-wide pool.
+	 */
+	template <std::size_t N, std::size_t M = N>
+	static BoardStats sample(const DiceSet& dice, std::uint64_t n_boards, std::uint64_t seed);
+};
+
+template <std::size_t N, std::size_t M>
+BoardStats BoardStats::sample(const DiceSet& dice, std::uint64_t n_boards, std::uint64_t seed,
+                              const Trie& dictionary, ThreadPool& pool) {
+	if (dice.size() != N * M) {
+		throw std::invalid_argument(std::to_string(dice.size()) + " dice can not fill a " +
+		                            std::to_string(N) + " by " + std::to_string(M) + " board");
+	}
+
+	// Boards are taken in batches to keep the shared counter out of the way.
+	constexpr std::uint64_t batch = 1024;
+	BoardStats stats;
+	std::mutex lock;
+	std::atomic<std::uint64_t> next(0);
+	auto job = [&](std::size_t) {
+		BoardStats local;
+		typename Boggle<N, M>::Workspace workspace;
+		Boggle<N, M> boggle;
+		for (std::uint64_t first = next.fetch_add(batch); first < n_boards;
+		     first = next.fetch_add(batch)) {
+			for (std::uint64_t i = first; i < std::min(first + batch, n_boards); ++i) {
+				CounterRng rng(seed, i);
+				dice.roll(rng, boggle[0]);
+				std::size_t n_words = 0;
+				std::size_t score = 0;
+				std::size_t longest = 0;
+				boggle.visit(dictionary, workspace, [&](const typename Boggle<N, M>::Match& m) {
+					++n_words;
+					score += word_score(m.length);
+					longest = std::max(longest, m.length);
+					return true;
+				});
+				++local.boards;
+				local.words.add(n_words);
+				local.score.add(score);
+				local.longest.add(longest);
+			}
+		}
+		std::lock_guard<std::mutex> guard(lock);
+		stats.merge(local);
+	};
+	pool.run(job);
+	return stats;
+}
+
+template <std::size_t N, std::size_t M>
+BoardStats BoardStats::sample(const DiceSet& dice, std::uint64_t n_boards, std::uint64_t seed) {
+	return sample<N, M>(dice, n_boards, seed, Boggle<N, M>::dictionary(), ThreadPool::global());
+}
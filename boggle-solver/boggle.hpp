@@ -2,15 +2,18 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
 #include <fstream>
-#include <functional>
-#include <mutex>
-#include <stack>
 #include <string>
-#include <thread>
 #include <vector>
-#include <boost/container/static_vector.hpp>
 
+#include "board_search.hpp"
+#include "neighbours.hpp"
+#include "result_sink.hpp"
+#include "search_stats.hpp"
+#include "thread_pool.hpp"
 #include "trie.hpp"
 
 /*
@@ -55,89 +58,176 @@ public:
 	std::vector<std::string> solve() const;
 
 	/*
-	 * Load the words from file, transform them to uppercase, and insert them into the trie. Words
-	 * containing non-ASCII letters are ignored.
+	 * Return the words in the Boggle board that are in the given dictionary rather than in the one
+	 * loaded with load_dictionary. The dictionary may have been minimized.
 	 */
-	static void load_dictionary(const std::string& file);
+	std::vector<std::string> solve(const Trie& dictionary) const;
 
-protected:
-	std::array<char, N * M> board_; // The N by M Boggle board. Must contain only uppercase ASCII
-	// characters. Note that the QU boggle piece is represented simply by the character Q.
+	/*
+	 * Return the words in the Boggle board that are in the given dictionary, searching on the
+	 * threads of the given pool. The other overloads use the process-wide pool,
+	 * ThreadPool::global(). Threads that run out of work steal unexplored parts of the search from
+	 * busy threads, so the work is balanced however it is spread over the board. The threads share
+	 * one set of found words, so each word is found by exactly one thread and the results of the
+	 * threads are simply concatenated.
+	 */
+	std::vector<std::string> solve(const Trie& dictionary, ThreadPool& pool) const;
 
-	static Trie trie; // Trie containing the words in a dictionary in uppercase letters.
+	/*
+	 * As above, also counting the work done by the search, and by each thread, in the given stats,
+	 * which are reset first. See SearchStats.
+	 */
+	std::vector<std::string> solve(const Trie& dictionary, ThreadPool& pool,
+	                               SearchStats& stats) const;
 
 	/*
-	 * Lookup table to find the neighbours of a square on the Boggle board.
+	 * Return the IDs of the words in the Boggle board in the dictionary loaded with
+	 * load_dictionary, rather than the words themselves. See Trie for how words are numbered. IDs
+	 * take 4 bytes per word and need no allocation of their own, and can be turned back into words
+	 * with Trie::word once and if the text is needed.
 	 */
-	class NeighbourTable {
-		friend Boggle;
-	public:
-		NeighbourTable() {
-			// Find the range of rows and columns constituting the neighbours of each Boggle square.
-			for (std::size_t i = 0; i < neighbours_.size(); ++i) {
-				std::size_t min_row, max_row, min_col, max_col;
-				min_row = i / M == 0 ? 0 : i / M - 1;
-				max_row = i / M == N - 1 ? N - 1 : i / M + 1;
-				min_col = i % M == 0 ? 0 : i % M - 1;
-				max_col = i % M == M - 1 ? M - 1 : i % M + 1;
-
-				for (std::size_t row = min_row; row <= max_row; ++row) {
-					for (std::size_t col = min_col; col <= max_col; ++col) {
-						// Make sure not to add the square itself.
-						if (row * M + col != i) {
-							neighbours_[i].push_back(row * M + col);
-						}
-					}
-				}
-			}
-		}
+	std::vector<std::uint32_t> solve_ids() const;
 
-		boost::container::static_vector<std::size_t, 8> operator[](std::size_t i) const {
-			return neighbours_[i];
-		}
+	/*
+	 * As above, using the given dictionary and searching on the threads of the given pool.
+	 */
+	std::vector<std::uint32_t> solve_ids(const Trie& dictionary, ThreadPool& pool) const;
 
-		boost::container::static_vector<std::size_t, 8>& operator[](std::size_t i) {
-			return neighbours_[i];
-		}
+	/*
+	 * Scratch memory used by a single thread to search a board, see BoardSearch::Workspace.
+	 */
+	using Workspace = typename BoardSearch<N, M>::Workspace;
 
-	private:
-		std::array<boost::container::static_vector<std::size_t, 8>, N * M> neighbours_; // The ith
-		// element contains the neighbours of the ith Boggle square.
-	};
+	/*
+	 * Find the words in the Boggle board using only the calling thread and place them in the given
+	 * vector, in no particular order, which is cleared first. Once the workspace and the vector have
+	 * been used for a previous solve, the call does not allocate unless the board has more words
+	 * than any before it or has a word too long for the small string optimization.
+	 */
+	void solve(Workspace& workspace, std::vector<std::string>& words) const;
+
+	/*
+	 * As above, using the given dictionary rather than the one loaded with load_dictionary.
+	 */
+	void solve(const Trie& dictionary, Workspace& workspace, std::vector<std::string>& words) const;
 
-	static const NeighbourTable neighbour_table;
+	/*
+	 * As above, also counting the work done by the search in the given stats, which are reset
+	 * first: a SearchStats, or any class with the same members, such as TrieProfile.
+	 */
+	template <typename Stats>
+	void solve(const Trie& dictionary, Workspace& workspace, std::vector<std::string>& words,
+	           Stats& stats) const;
 
 	/*
-	 * Find all words that start from the ith element of the Boggle board and place them in the
-	 * given vector. No bounds checks are made and duplicates are not removed. Not thread safe.
+	 * As above, but place the IDs of the words in the given dictionary in the given vector. Does
+	 * not allocate once the vector has held as many IDs.
 	 */
-	void solve_starting_at(std::size_t i, std::vector<std::string>& words) const;
+	void solve_ids(const Trie& dictionary, Workspace& workspace,
+	               std::vector<std::uint32_t>& ids) const;
 
 	/*
-	 * Find all the words that start from squares in the range [start, end) and place them in the
-	 * given vector without duplication. The function is thread safe. No bounds checks are made.
+	 * A word found by visit: its letters, its ID in the dictionary, and the squares of the path
+	 * that spells it out, see BoardSearch::Match.
 	 */
-	void solve_between(std::size_t start, std::size_t end, std::vector<std::string>& words) const;
+	using Match = typename BoardSearch<N, M>::Match;
 
 	/*
-	 * Return the word formed by following the given path through the Boggle board.
+	 * Call the given visitor with a Match for each word of the given dictionary in the Boggle
+	 * board as soon as the search finds it, on the calling thread and using the given workspace.
+	 * Each word is visited once, with the first path found for it. If the visitor returns false
+	 * the search stops there and visit returns false; otherwise visit returns true once every word
+	 * has been visited. The visitor is a template parameter, so it is inlined into the search and
+	 * nothing is stored or allocated on its behalf.
 	 */
-	template <typename T>
-	std::string path2word(const T& path) const;
+	template <typename Visitor>
+	bool visit(const Trie& dictionary, Workspace& workspace, Visitor&& visitor) const;
+
+	/*
+	 * As above, using the dictionary loaded with load_dictionary and the workspace of the calling
+	 * thread.
+	 */
+	template <typename Visitor>
+	bool visit(Visitor&& visitor) const;
+
+	/*
+	 * Solve the given number of boards and store the words of boards[i] as board i of the given
+	 * sink, which is reset first. The threads of the process-wide pool each take whole boards from
+	 * a shared counter and search them on their own, reusing their workspace from board to board,
+	 * which for boards as small as 4 by 4 is much faster than splitting every board between threads.
+	 */
+	static void solve_many(const Boggle *boards, std::size_t count, ResultSink& sink);
+
+	/*
+	 * As above, using the given dictionary and the threads of the given pool.
+	 */
+	static void solve_many(const Trie& dictionary, const Boggle *boards, std::size_t count,
+	                       ResultSink& sink, ThreadPool& pool);
+
+	/*
+	 * Replace the dictionary used by solve with the words in the given file. If 'minimize' is true,
+	 * the dictionary is minimized into a DAWG.
+	 */
+	static void load_dictionary(const std::string& file, bool minimize = false);
+
+	/*
+	 * Load the words from file, transform them to uppercase, and build a new trie of them with
+	 * Trie::build on the threads of the process-wide pool, which is minimized into a DAWG if
+	 * 'minimize' is true. Words containing non-ASCII letters are ignored. Any number of
+	 * dictionaries can be read this way and passed to solve.
+	 */
+	static Trie read_dictionary(const std::string& file, bool minimize = false);
+
+	/*
+	 * As above, building the trie on the threads of the given pool.
+	 */
+	static Trie read_dictionary(const std::string& file, bool minimize, ThreadPool& pool);
+
+	/*
+	 * Save the dictionary used by solve to the given file in the binary format of Trie::save, for
+	 * later use with map_dictionary.
+	 */
+	static void save_dictionary(const std::string& file);
+
+	/*
+	 * Replace the dictionary used by solve with one saved by save_dictionary, mapped read-only
+	 * from the given file. Throws std::runtime_error if the file is missing, was written by an
+	 * incompatible version or is corrupt.
+	 */
+	static void map_dictionary(const std::string& file);
 
 	/*
-	 * Return true if string contains only ASCII letters.
+	 * Return the dictionary used by solve.
 	 */
-	static bool ascii_word(const std::string& s);
+	static const Trie& dictionary();
+
+protected:
+	std::array<char, N * M> board_; // The N by M Boggle board. Must contain only uppercase ASCII
+	// characters. Note that the QU boggle piece is represented simply by the character Q.
+
+	static Trie trie; // Trie containing the words in a dictionary in uppercase letters.
+
+	/*
+	 * Return the search of the Boggle board, see BoardSearch.
+	 */
+	BoardSearch<N, M> search() const;
+
+	/*
+	 * Return the number of seconds since the given time.
+	 */
+	static double seconds_since(std::chrono::steady_clock::time_point start);
+
+	/*
+	 * Uppercase the given null-terminated string in place and return true if it contains only
+	 * ASCII letters. The string is left partly uppercased otherwise.
+	 */
+	static bool ascii_word(char *s);
 };
 
 /* Redeclaration of static data members. */
 template <std::size_t N, std::size_t M>
 Trie Boggle<N, M>::trie;
 
-template <std::size_t N, std::size_t M>
-const typename Boggle<N, M>::NeighbourTable Boggle<N, M>::neighbour_table;
-
 template <std::size_t N, std::size_t M>
 Boggle<N, M>::Boggle() :
 		board_() { };
@@ -165,129 +255,196 @@ char *Boggle<N, M>::operator[](std::size_t i) {
 
 template <std::size_t N, std::size_t M>
 std::vector<std::string> Boggle<N, M>::solve() const {
-	std::vector<std::string> words;
-	words.reserve(512); // There is typically at most 500 words in a 4 by 4 Boggle board.
-
-	auto n_threads = std::thread::hardware_concurrency();
-	auto squares_per_thread = board_.size() / n_threads;
-	std::vector<std::thread> threads(n_threads - 1);
-
-	// Create n - 1 threads, where n is the number of hardware threads supported. Divide the Boggle
-	// board into n groups of squares and assign each group to a thread. A thread finds all the
-	// words starting from the squares in its group and places them into 'words'.
-	for (unsigned int i = 0; i < n_threads - 1; ++i) {
-		std::size_t start_square = squares_per_thread * i;
-		std::size_t end_square = squares_per_thread * (i + 1);
-		threads[i] = std::thread(
-				&Boggle<N, M>::solve_between, this, start_square, end_square, std::ref(words));
-	}
+	return solve(trie);
+}
+
+template <std::size_t N, std::size_t M>
+std::vector<std::string> Boggle<N, M>::solve(const Trie& dictionary) const {
+	return solve(dictionary, ThreadPool::global());
+}
+
+template <std::size_t N, std::size_t M>
+std::vector<std::string> Boggle<N, M>::solve(const Trie& dictionary, ThreadPool& pool) const {
+	NoSearchStats stats;
+	return search().template solve_parallel<std::string>(dictionary, pool, stats);
+}
+
+template <std::size_t N, std::size_t M>
+std::vector<std::string> Boggle<N, M>::solve(const Trie& dictionary, ThreadPool& pool,
+                                             SearchStats& stats) const {
+	return search().template solve_parallel<std::string>(dictionary, pool, stats);
+}
+
+template <std::size_t N, std::size_t M>
+std::vector<std::uint32_t> Boggle<N, M>::solve_ids() const {
+	return solve_ids(trie, ThreadPool::global());
+}
+
+template <std::size_t N, std::size_t M>
+std::vector<std::uint32_t> Boggle<N, M>::solve_ids(const Trie& dictionary,
+                                                   ThreadPool& pool) const {
+	NoSearchStats stats;
+	return search().template solve_parallel<std::uint32_t>(dictionary, pool, stats);
+}
+
+template <std::size_t N, std::size_t M>
+void Boggle<N, M>::load_dictionary(const std::string& file, bool minimize) {
+	trie = read_dictionary(file, minimize);
+}
+
+template <std::size_t N, std::size_t M>
+void Boggle<N, M>::save_dictionary(const std::string& file) {
+	trie.save(file);
+}
 
-	// Main thread takes care of last remaining squares.
-	solve_between(squares_per_thread * (n_threads - 1), board_.size(), words);
+template <std::size_t N, std::size_t M>
+void Boggle<N, M>::map_dictionary(const std::string& file) {
+	trie = Trie::map(file);
+}
 
-	std::for_each(threads.begin(), threads.end(), std::mem_fn(&std::thread::join));
+template <std::size_t N, std::size_t M>
+const Trie& Boggle<N, M>::dictionary() {
+	return trie;
+}
 
-	return words;
+template <std::size_t N, std::size_t M>
+Trie Boggle<N, M>::read_dictionary(const std::string& file, bool minimize) {
+	return read_dictionary(file, minimize, ThreadPool::global());
 }
 
 template <std::size_t N, std::size_t M>
-void Boggle<N, M>::load_dictionary(const std::string& file) {
-	std::vector<std::string> words;
-	std::ifstream infile(file);
-	std::string line;
-
-	while (std::getline(infile, line)) {
-		if (not ascii_word(line)) {
-			continue;
+Trie Boggle<N, M>::read_dictionary(const std::string& file, bool minimize, ThreadPool& pool) {
+	// The file is read in chunks into a single buffer, and each line is turned into a word where it
+	// lies: its letters are uppercased and the newline after it is replaced by a null character,
+	// so the words are pointers into the buffer and nothing is allocated per word. Word lists are
+	// normally sorted already, but uppercasing can move words of mixed case, so they are only
+	// sorted if need be before the trie is built from them with Trie::build.
+	constexpr std::size_t chunk_size = 1 << 20;
+	std::vector<char> text;
+	std::ifstream infile(file, std::ios::binary);
+	while (infile) {
+		std::size_t size = text.size();
+		text.resize(size + chunk_size);
+		infile.read(text.data() + size, static_cast<std::streamsize>(chunk_size));
+		text.resize(size + static_cast<std::size_t>(infile.gcount()));
+	}
+	if (not text.empty() and text.back() != '\n') {
+		text.push_back('\n');
+	}
+
+	std::vector<const char *> words;
+	for (char *line = text.data(), *end = text.data() + text.size(); line != end; ) {
+		auto length = static_cast<std::size_t>(end - line);
+		auto *newline = static_cast<char *>(std::memchr(line, '\n', length));
+		*newline = '\0';
+		if (ascii_word(line)) {
+			words.push_back(line);
 		}
-		std::transform(line.begin(), line.end(), line.begin(), ::toupper);
-		words.push_back(std::move(line));
+		line = newline + 1;
 	}
+	auto less = [](const char *a, const char *b) {
+		return std::strcmp(a, b) < 0;
+	};
+	if (not std::is_sorted(words.begin(), words.end(), less)) {
+		std::sort(words.begin(), words.end(), less);
+	}
+	words.erase(std::unique(words.begin(), words.end(), [](const char *a, const char *b) {
+		return std::strcmp(a, b) == 0;
+	}), words.end());
 
-	for (const auto& word : words) {
-		trie.insert(word.c_str());
+	Trie dictionary = Trie::build(words.data(), words.size(), pool);
+	if (minimize) {
+		dictionary.minimize();
 	}
+	return dictionary;
 }
 
 template <std::size_t N, std::size_t M>
-void Boggle<N, M>::solve_starting_at(std::size_t i, std::vector<std::string>& words) const {
-	// A modified DFS algorithm is used to find all words in the Boggle board.
-	// A typical non-recursive DFS uses a stack to hold the nodes of a graph that need to be
-	// visited, and a separate data structure keeps track of which nodes have been visited.
-	// In this implementation, a stack is used to hold the *paths* through the Boggle board that
-	// need to be analyzed and extended. Analysis means 1) checking whether the path makes a valid
-	// word; and 2) whether the path forms the prefix of a valid word (if not, path is discarded).
-	// Paths are extended by joining the neighbours of the last square of the path that are not
-	// already in the path.
-
-	using path_t = boost::container::static_vector<std::size_t, N * M>;
-
-	std::stack<path_t> paths;
-	paths.emplace(1, i);
-
-	while (not paths.empty()) {
-		path_t path = paths.top();
-		paths.pop();
-
-		std::string word = path2word(path);
-		if (not trie.has_prefix(word.c_str())) {
-			continue;
-		}
-		if (word.size() >= 3 and trie.has_string(word.c_str())) {
-			words.push_back(std::move(word));
-		}
+void Boggle<N, M>::solve(Workspace& workspace, std::vector<std::string>& words) const {
+	solve(trie, workspace, words);
+}
 
-		std::size_t last_square = path.back();
-		auto neighbours = neighbour_table[last_square];
-		for (std::size_t neighbour : neighbours) {
-			if (std::find(path.begin(), path.end(), neighbour) == path.end()) {
-				path_t new_path = path;
-				new_path.push_back(neighbour);
-				paths.push(std::move(new_path));
-			}
-		}
-	}
+template <std::size_t N, std::size_t M>
+void Boggle<N, M>::solve(const Trie& dictionary, Workspace& workspace,
+                         std::vector<std::string>& words) const {
+	words.clear();
+	NoSearchStats stats;
+	search().solve_serial(dictionary, workspace, words, stats);
 }
 
 template <std::size_t N, std::size_t M>
-void Boggle<N, M>::solve_between(std::size_t start, std::size_t end,
-                                 std::vector<std::string>& words) const {
-	// Place the words in a temporary buffer first and transfer them into 'words' after all words
-	// have been found. This avoids having to keep `words` locked for the entire function call.
-	static std::mutex words_lock;
-	std::vector<std::string> tmp_buffer;
-	tmp_buffer.reserve(words.capacity());
-
-	for (auto i = start; i < end; ++i) {
-		solve_starting_at(i, tmp_buffer);
-	}
+template <typename Stats>
+void Boggle<N, M>::solve(const Trie& dictionary, Workspace& workspace,
+                         std::vector<std::string>& words, Stats& stats) const {
+	words.clear();
+	auto start = std::chrono::steady_clock::now();
+	stats.reset(board_.size());
+	search().solve_serial(dictionary, workspace, words, stats);
+	stats.busy(0, seconds_since(start));
+}
+
+template <std::size_t N, std::size_t M>
+void Boggle<N, M>::solve_ids(const Trie& dictionary, Workspace& workspace,
+                             std::vector<std::uint32_t>& ids) const {
+	ids.clear();
+	NoSearchStats stats;
+	search().solve_serial(dictionary, workspace, ids, stats);
+}
+
+template <std::size_t N, std::size_t M>
+template <typename Visitor>
+bool Boggle<N, M>::visit(const Trie& dictionary, Workspace& workspace, Visitor&& visitor) const {
+	NoSearchStats stats;
+	return search().solve_serial(dictionary, workspace, visitor, stats);
+}
 
-	std::lock_guard<std::mutex> guard(words_lock);
-	for (auto& word : tmp_buffer) {
-		if (std::find(words.begin(), words.end(), word) == words.end()) {
-			words.push_back(std::move(word));
+template <std::size_t N, std::size_t M>
+template <typename Visitor>
+bool Boggle<N, M>::visit(Visitor&& visitor) const {
+	NoSearchStats stats;
+	return search().solve_serial(trie, BoardSearch<N, M>::thread_workspace(), visitor, stats);
+}
+
+template <std::size_t N, std::size_t M>
+void Boggle<N, M>::solve_many(const Boggle *boards, std::size_t count, ResultSink& sink) {
+	solve_many(trie, boards, count, sink, ThreadPool::global());
+}
+
+template <std::size_t N, std::size_t M>
+void Boggle<N, M>::solve_many(const Trie& dictionary, const Boggle *boards, std::size_t count,
+                              ResultSink& sink, ThreadPool& pool) {
+	sink.reset(count);
+	std::atomic<std::size_t> next(0);
+	auto job = [&](std::size_t) {
+		Workspace& workspace = BoardSearch<N, M>::thread_workspace();
+		for (std::size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+			auto& words = workspace.template results<std::string>();
+			boards[i].solve(dictionary, workspace, words);
+			sink.append(i, words);
 		}
-	}
-};
+	};
+	pool.run(job);
+}
 
 template <std::size_t N, std::size_t M>
-bool Boggle<N, M>::ascii_word(const std::string& s) {
-	return std::all_of(s.begin(), s.end(), [](char c) {
-		return (c >= 'A' and c <= 'Z') or (c >= 'a' and c <= 'z');
-	});
+BoardSearch<N, M> Boggle<N, M>::search() const {
+	static const Neighbours<N, M> neighbours{};
+	return BoardSearch<N, M>(board_.data(), neighbours);
 }
 
 template <std::size_t N, std::size_t M>
-template <typename T>
-std::string Boggle<N, M>::path2word(const T& path) const {
-	std::string word;
-	word.reserve(path.size() + 2);
-	for (auto i : path) {
-		char c = board_[i];
-		word.push_back(c);
-		if (c == 'Q') {
-			word.push_back('U');
+double Boggle<N, M>::seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <std::size_t N, std::size_t M>
+bool Boggle<N, M>::ascii_word(char *s) {
+	for (; *s != '\0'; ++s) {
+		if (*s >= 'a' and *s <= 'z') {
+			*s = static_cast<char>(*s - 'a' + 'A');
+		} else if (*s < 'A' or *s > 'Z') {
+			return false;
 		}
 	}
-	return word;
+	return true;
 }
@@ -0,0 +1,277 @@
+/*
+ * boggle-anneal: search for high-scoring Boggle boards with simulated annealing.
+ *
+ * Runs many independent annealing chains on the threads of a pool. Each chain starts from a board
+ * of random letters and repeatedly either changes one square to a random letter or swaps two
+ * squares, keeping the change if it raises the score of the board and otherwise with a probability
+ * that falls as the chain cools. Boards are scored under the standard rules with Boggle::visit, on
+ * a workspace kept by each thread for all the chains it runs, so every step is a full solve by the
+ * same engine as everything else. The best boards found are printed with their scores, followed by
+ * the number of boards evaluated per second.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "boggle.hpp"
+#include "command_line.hpp"
+#include "scoring.hpp"
+#include "solve_cache.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+/*
+ * The settings of a run, set from the command line.
+ */
+struct options_t {
+	std::size_t size = 4; // The number of rows and columns of the boards.
+	std::size_t n_chains = 0; // The number of chains, or 0 for four per thread.
+	std::size_t n_steps = 20000; // The number of steps of each chain.
+	std::size_t n_threads = ThreadPool::default_size(); // The number of threads.
+	std::size_t n_best = 10; // The number of boards printed.
+	double start_temperature = 10; // The temperature of the first step.
+	double end_temperature = 0.1; // The temperature of the last step.
+	std::uint64_t seed = 0; // The seed of the first chain; chain i uses seed + i.
+	std::string dictionary = DICT_PATH; // The word list.
+};
+
+/*
+ * The best board found by a chain.
+ */
+struct result_t {
+	std::string letters; // The letters of the board in row-major order.
+	unsigned score; // The score of the board.
+};
+
+/*
+ * Print how to use the program to the given stream.
+ */
+void usage(std::ostream& out, const char *program) {
+	options_t defaults;
+	out << "usage: " << program << " [options]\n"
+	    << "  -n SIZE     rows and columns of the boards: 4, 5, 6 or 8 (default 4)\n"
+	    << "  -c CHAINS   number of annealing chains (default 4 per thread)\n"
+	    << "  -s STEPS    steps per chain (default " << defaults.n_steps << ")\n"
+	    << "  -t THREADS  number of threads (default " << defaults.n_threads << ")\n"
+	    << "  -k BEST     number of best boards to print (default " << defaults.n_best << ")\n"
+	    << "  -T START    temperature of the first step (default " << defaults.start_temperature
+	    << ")\n"
+	    << "  -E END      temperature of the last step (default " << defaults.end_temperature
+	    << ")\n"
+	    << "  -r SEED     seed of the first chain (default 0)\n"
+	    << "  -d FILE     dictionary, one word per line (default " << defaults.dictionary << ")\n";
+}
+
+/*
+ * Return the score of the given board under the standard rules, solving it in the given dictionary
+ * with the given workspace.
+ */
+template <std::size_t N>
+unsigned score(const Boggle<N>& boggle, const Trie& dictionary,
+               typename Boggle<N>::Workspace& workspace) {
+	unsigned total = 0;
+	boggle.visit(dictionary, workspace, [&total](const typename Boggle<N>::Match& m) {
+		total += word_score(m.length);
+		return true;
+	});
+	return total;
+}
+
+/*
+ * Run one annealing chain from a random board with the given seed, evaluating boards in the given
+ * dictionary with the given workspace, and return the best board it finds.
+ */
+template <std::size_t N>
+result_t anneal(const options_t& options, std::uint64_t seed, const Trie& dictionary,
+                typename Boggle<N>::Workspace& workspace) {
+	std::mt19937_64 eng(seed);
+	std::uniform_int_distribution<std::size_t> square(0, N * N - 1);
+	std::uniform_int_distribution<int> letter(0, 25);
+	std::uniform_real_distribution<double> uniform(0, 1);
+
+	Boggle<N> boggle;
+	for (std::size_t i = 0; i < N * N; ++i) {
+		boggle[i / N][i % N] = static_cast<char>('A' + letter(eng));
+	}
+	unsigned current = score(boggle, dictionary, workspace);
+	result_t best{std::string(boggle[0], N * N), current};
+
+	// The temperature falls geometrically from the first step to the last.
+	double cooling = std::pow(options.end_temperature / options.start_temperature,
+	                          1.0 / static_cast<double>(std::max<std::size_t>(options.n_steps, 1)));
+	double temperature = options.start_temperature;
+	for (std::size_t step = 0; step < options.n_steps; ++step, temperature *= cooling) {
+		std::size_t a = square(eng);
+		std::size_t b = square(eng);
+		char *letters = boggle[0];
+		char old = letters[a];
+		bool swap = uniform(eng) < 0.5;
+		if (swap) {
+			std::swap(letters[a], letters[b]);
+		} else {
+			letters[a] = static_cast<char>('A' + letter(eng));
+		}
+
+		unsigned next = score(boggle, dictionary, workspace);
+		double gain = static_cast<double>(next) - static_cast<double>(current);
+		if (gain >= 0 or uniform(eng) < std::exp(gain / temperature)) {
+			current = next;
+			if (current > best.score) {
+				best = result_t{std::string(letters, N * N), current};
+			}
+		} else if (swap) {
+			std::swap(letters[a], letters[b]);
+		} else {
+			letters[a] = old;
+		}
+	}
+	return best;
+}
+
+/*
+ * Run the chains on the threads of a pool, which also builds the dictionary, and print the best
+ * boards and the throughput.
+ */
+template <std::size_t N>
+void run(const options_t& options) {
+	ThreadPool pool(options.n_threads);
+	Trie dictionary = open_dictionary(options.dictionary, "", false, pool);
+	std::size_t n_chains = options.n_chains != 0 ? options.n_chains : 4 * pool.size();
+	std::vector<result_t> results(n_chains);
+	std::atomic<std::size_t> next(0);
+	auto start = std::chrono::steady_clock::now();
+	auto job = [&](std::size_t) {
+		typename Boggle<N>::Workspace workspace;
+		for (std::size_t i = next.fetch_add(1); i < n_chains; i = next.fetch_add(1)) {
+			results[i] = anneal<N>(options, options.seed + i, dictionary, workspace);
+		}
+	};
+	pool.run(job);
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	// Chains often converge on the same board or on rotations and reflections of it, which are
+	// only printed once.
+	std::sort(results.begin(), results.end(), [](const result_t& a, const result_t& b) {
+		return a.score > b.score or (a.score == b.score and a.letters < b.letters);
+	});
+	std::vector<std::string> printed;
+	typename Boggle<N>::Workspace workspace;
+	std::vector<std::string> words;
+	std::cout << "score  words  board\n";
+	for (const auto& result : results) {
+		if (printed.size() == options.n_best) {
+			break;
+		}
+		Boggle<N> boggle(result.letters);
+		std::string canonical = SolveCache<N>::canonical(boggle);
+		if (std::find(printed.begin(), printed.end(), canonical) != printed.end()) {
+			continue;
+		}
+		printed.push_back(canonical);
+		boggle.solve(dictionary, workspace, words);
+		std::cout << std::setw(5) << result.score << "  " << std::setw(5) << words.size() << "  ";
+		for (std::size_t row = 0; row < N; ++row) {
+			std::cout << (row == 0 ? "" : " ") << std::string(boggle[row], N);
+		}
+		std::cout << "\n";
+	}
+
+	std::uint64_t n_boards = n_chains * (options.n_steps + 1);
+	std::cout << "\n" << n_chains << " chains of " << options.n_steps << " steps on " << pool.size()
+	          << " threads: " << n_boards << " boards in " << std::fixed << std::setprecision(2)
+	          << elapsed.count() << " s, " << std::setprecision(0)
+	          << static_cast<double>(n_boards) / elapsed.count() << " boards/s\n";
+}
+
+/*
+ * Parse the given temperature option, or exit with the usage.
+ */
+double parse_temperature(const char *program, const char *arg) {
+	char *end;
+	double value = std::strtod(arg, &end);
+	if (*arg == '\0' or *end != '\0' or not (value > 0)) {
+		usage(std::cerr, program);
+		std::exit(EXIT_FAILURE);
+	}
+	return value;
+}
+}
+
+int main(int argc, char *argv[]) {
+	options_t options;
+	int option;
+	while ((option = getopt(argc, argv, "n:c:s:t:k:T:E:r:d:h")) != -1) {
+		switch (option) {
+			case 'n':
+				options.size = parse_number(argv[0], optarg, usage);
+				break;
+			case 'c':
+				options.n_chains = parse_number(argv[0], optarg, usage);
+				break;
+			case 's':
+				options.n_steps = parse_number(argv[0], optarg, usage);
+				break;
+			case 't':
+				options.n_threads = parse_number(argv[0], optarg, usage);
+				break;
+			case 'k':
+				options.n_best = parse_number(argv[0], optarg, usage);
+				break;
+			case 'T':
+				options.start_temperature = parse_temperature(argv[0], optarg);
+				break;
+			case 'E':
+				options.end_temperature = parse_temperature(argv[0], optarg);
+				break;
+			case 'r':
+				options.seed = parse_number(argv[0], optarg, usage);
+				break;
+			case 'd':
+				options.dictionary = optarg;
+				break;
+			case 'h':
+				usage(std::cout, argv[0]);
+				return EXIT_SUCCESS;
+			default:
+				usage(std::cerr, argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+	if (optind != argc) {
+		usage(std::cerr, argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	try {
+		switch (options.size) {
+			case 4:
+				run<4>(options);
+				break;
+			case 5:
+				run<5>(options);
+				break;
+			case 6:
+				run<6>(options);
+				break;
+			case 8:
+				run<8>(options);
+				break;
+			default:
+				usage(std::cerr, argv[0]);
+				return EXIT_FAILURE;
+		}
+	} catch (const std::exception& e) {
+		std::cerr << argv[0] << ": " << e.what() << "\n";
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
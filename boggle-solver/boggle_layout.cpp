@@ -0,0 +1,194 @@
+/*
+ * boggle-layout: lay a dictionary out by how often the search of sample boards visits its nodes,
+ * and save it for Trie::map.
+ *
+ * The sample is either the boards of the files given, one per line as read by boggle-solve with
+ * parse_board, such as tests/data/boggle_4x4.csv, or boards rolled from a set of dice. Every board
+ * is solved with a TrieProfile counting the visits of each node, and the dictionary is then laid
+ * out with Trie::layout_by_heat, the nodes the sample visited first and hottest first, and saved.
+ * A dictionary profiled on boards like the ones it will solve keeps the nodes a search visits in
+ * far fewer cache lines than the breadth-first layout it is built in. Boards of a file must all be
+ * 4 by 4 or all be 5 by 5.
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "boggle.hpp"
+#include "command_line.hpp"
+#include "counter_rng.hpp"
+#include "dice.hpp"
+#include "thread_pool.hpp"
+#include "trie.hpp"
+#include "trie_profile.hpp"
+
+namespace {
+/*
+ * The settings of a run, set from the command line.
+ */
+struct options_t {
+	std::string output; // The file the laid out dictionary is saved to.
+	std::string dice = "modern"; // The name of the dice set boards are rolled from.
+	std::uint64_t n_boards = 10000; // The number of boards rolled, if no files are given.
+	std::uint64_t seed = 0; // The seed of the boards rolled.
+	bool minimize = false; // Whether to minimize the dictionary into a DAWG.
+	std::string dictionary = DICT_PATH; // The word list.
+	std::string trie; // A dictionary saved with Trie::save, used instead of the word list if set.
+	std::vector<std::string> inputs; // The files of boards.
+};
+
+/*
+ * Print how to use the program to the given stream.
+ */
+void usage(std::ostream& out, const char *program) {
+	options_t defaults;
+	out << "usage: " << program << " -o OUTPUT [options] [FILE...]\n"
+	    << "  -o FILE     save the laid out dictionary to FILE, for Trie::map\n"
+	    << "  -s DICE     dice set boards are rolled from if no FILE is given: classic or modern\n"
+	    << "              (4x4), or big (5x5) (default " << defaults.dice << ")\n"
+	    << "  -n BOARDS   number of boards rolled (default " << defaults.n_boards << ")\n"
+	    << "  -r SEED     seed of the boards rolled (default 0)\n"
+	    << "  -M          minimize the dictionary into a DAWG\n"
+	    << "  -d FILE     dictionary, one word per line (default " << defaults.dictionary << ")\n"
+	    << "  -m FILE     dictionary saved with Trie::save, mapped instead of reading -d\n";
+}
+
+/*
+ * Read the boards of the given files, which must all have the same number of letters.
+ */
+std::vector<std::string> read_boards(const std::vector<std::string>& inputs) {
+	std::vector<std::string> boards;
+	for (const auto& input : inputs) {
+		std::ifstream in(input);
+		if (not in) {
+			throw std::runtime_error("cannot open " + input);
+		}
+		std::string line;
+		std::string letters;
+		for (std::size_t number = 1; std::getline(in, line); ++number) {
+			try {
+				if (not parse_board(line.data(), line.data() + line.size(), letters)) {
+					continue;
+				}
+				if (not boards.empty() and letters.size() != boards.front().size()) {
+					throw std::invalid_argument("board of " + std::to_string(letters.size()) +
+					                            " letters among boards of " +
+					                            std::to_string(boards.front().size()));
+				}
+				boards.push_back(std::move(letters));
+			} catch (const std::invalid_argument& e) {
+				throw std::runtime_error(input + ":" + std::to_string(number) + ": " + e.what());
+			}
+		}
+	}
+	if (boards.empty()) {
+		throw std::runtime_error("no boards to profile");
+	}
+	return boards;
+}
+
+/*
+ * Count the visits of solving the given boards, or if there are none, the boards rolled from the
+ * dice of the options, on N by N boards.
+ */
+template <std::size_t N>
+void profile(const options_t& options, const std::vector<std::string>& boards,
+             const Trie& dictionary, TrieProfile& profile) {
+	typename Boggle<N>::Workspace workspace;
+	Boggle<N> boggle;
+	if (not boards.empty()) {
+		for (const auto& letters : boards) {
+			std::copy(letters.begin(), letters.end(), boggle[0]);
+			profile.add(dictionary, boggle, workspace);
+		}
+		return;
+	}
+	const DiceSet& dice = DiceSet::named(options.dice);
+	for (std::uint64_t i = 0; i < options.n_boards; ++i) {
+		CounterRng rng(options.seed, i);
+		dice.roll(rng, boggle[0]);
+		profile.add(dictionary, boggle, workspace);
+	}
+}
+}
+
+int main(int argc, char *argv[]) {
+	options_t options;
+	int option;
+	while ((option = getopt(argc, argv, "o:s:n:r:Md:m:h")) != -1) {
+		switch (option) {
+			case 'o':
+				options.output = optarg;
+				break;
+			case 's':
+				options.dice = optarg;
+				break;
+			case 'n':
+				options.n_boards = parse_number(argv[0], optarg, usage);
+				break;
+			case 'r':
+				options.seed = parse_number(argv[0], optarg, usage);
+				break;
+			case 'M':
+				options.minimize = true;
+				break;
+			case 'd':
+				options.dictionary = optarg;
+				break;
+			case 'm':
+				options.trie = optarg;
+				break;
+			case 'h':
+				usage(std::cout, argv[0]);
+				return EXIT_SUCCESS;
+			default:
+				usage(std::cerr, argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+	if (options.output.empty()) {
+		usage(std::cerr, argv[0]);
+		return EXIT_FAILURE;
+	}
+	options.inputs.assign(argv + optind, argv + argc);
+
+	try {
+		Trie dictionary = open_dictionary(options.dictionary, options.trie, options.minimize,
+		                                  ThreadPool::global());
+
+		std::vector<std::string> boards;
+		std::size_t n_squares = DiceSet::named(options.dice).size();
+		if (not options.inputs.empty()) {
+			boards = read_boards(options.inputs);
+			n_squares = boards.front().size();
+		}
+		TrieProfile trie_profile(dictionary);
+		switch (n_squares) {
+			case 16:
+				profile<4>(options, boards, dictionary, trie_profile);
+				break;
+			case 25:
+				profile<5>(options, boards, dictionary, trie_profile);
+				break;
+			default:
+				throw std::invalid_argument("boards of " + std::to_string(n_squares) +
+				                            " squares are not supported");
+		}
+
+		dictionary.layout_by_heat(trie_profile.visits());
+		dictionary.save(options.output);
+		std::cout << trie_profile.boards() << " boards visited " << trie_profile.nodes_visited()
+		          << " of " << trie_profile.visits().size() << " nodes; " << dictionary.hot_nodes()
+		          << " nodes (" << dictionary.hot_nodes() * sizeof(Trie::Node) / 1024
+		          << " KiB) laid out hot, " << dictionary.size() << " in all\n";
+	} catch (const std::exception& e) {
+		std::cerr << argv[0] << ": " << e.what() << "\n";
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
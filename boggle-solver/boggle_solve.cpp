@@ -0,0 +1,458 @@
+/*
+ * boggle-solve: solve a stream of Boggle boards and write their words, word counts or scores.
+ *
+ * Boards are read one per line from the files given, which are memory-mapped, or from standard
+ * input. A line is either just the letters of a board or a CSV record whose first field is, as in
+ * tests/data/boggle_4x4.csv, so that file can be fed in as is. The letters are in row-major order,
+ * read by parse_board, so 'Q' and 'Qu' in either case stand for the square 'QU'; a board is square
+ * unless its dimensions are given. Empty lines are skipped.
+ *
+ * Input is taken a block of whole lines at a time, without copying it out of the mapping or the
+ * read buffer. The lines of a block are split into chunks which the threads of a pool parse, solve
+ * and format into a buffer per chunk, each thread reusing its solver workspace from board to board.
+ * Once the block is done the buffers are written out in input order, so the output has one line per
+ * board, in the same order as the input: the letters of the board, a comma and its words in
+ * alphabetical order separated by spaces, its number of words or its score under the standard
+ * rules. The counts of the test data come out exactly as the file has them.
+ */
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "any_boggle.hpp"
+#include "boggle.hpp"
+#include "command_line.hpp"
+#include "scoring.hpp"
+#include "thread_pool.hpp"
+#include "trie.hpp"
+
+namespace {
+/*
+ * What is written for each board.
+ */
+enum class format_t {
+	words, // The words of the board, in alphabetical order.
+	count, // The number of words of the board.
+	score // The score of the board.
+};
+
+/*
+ * The settings of a run, set from the command line.
+ */
+struct options_t {
+	std::size_t rows = 0; // The number of rows of the boards, or 0 for square boards.
+	std::size_t cols = 0; // The number of columns of the boards, or 0 for square boards.
+	format_t format = format_t::words; // What is written for each board.
+	std::size_t n_threads = ThreadPool::default_size(); // The number of threads.
+	std::size_t block_size = 1 << 20; // The number of bytes of input taken at a time.
+	std::string dictionary = DICT_PATH; // The word list.
+	std::string trie; // A dictionary saved with Trie::save, used instead of the word list if set.
+	std::vector<std::string> inputs; // The input files, "-" being standard input.
+};
+
+/*
+ * The lines of an input, handed out a block of whole lines at a time.
+ *
+ * A file is mapped read-only and its blocks point into the mapping. Standard input, or anything
+ * else that can not be mapped, is read into a buffer, and the part of its last line that has not
+ * been read yet is carried over to the next block, the buffer growing if a line does not fit.
+ */
+class LineReader {
+public:
+	/*
+	 * Open the given file, or standard input if it is "-". Throws std::runtime_error if the file
+	 * can not be opened.
+	 */
+	LineReader(const std::string& file, std::size_t block_size);
+
+	/*
+	 * Close the file.
+	 */
+	~LineReader();
+
+	// Delete copy constructor and copy assignment.
+	LineReader(const LineReader&) = delete;
+
+	LineReader& operator=(const LineReader&) = delete;
+
+	/*
+	 * Point 'begin' and 'end' to the next block of whole lines, each but possibly the last ending
+	 * with a newline, and return true, or return false at the end of the input. The block stays
+	 * valid until the next call. Throws std::runtime_error if the input can not be read.
+	 */
+	bool next(const char *&begin, const char *&end);
+
+private:
+	std::string name_; // The name of the input, for errors.
+	int fd_; // The file descriptor, or -1 once the input is mapped or closed.
+	std::size_t block_size_;
+	const char *mapping_; // The mapped file, or null if it is read into buffer_.
+	std::size_t length_; // The length of the mapped file.
+	std::size_t offset_; // The offset of the next block in the mapped file.
+	std::vector<char> buffer_; // The data read but not handed out, from buffer_[start_] to
+	// buffer_[end_], if the input is not mapped.
+	std::size_t start_;
+	std::size_t end_;
+
+	/*
+	 * Read more of the input after buffer_[end_], moving the data not yet handed out to the front
+	 * of the buffer and growing it if it is full. Return false at the end of the input.
+	 */
+	bool fill();
+};
+
+LineReader::LineReader(const std::string& file, std::size_t block_size) :
+		name_(file == "-" ? "standard input" : file),
+		fd_(file == "-" ? STDIN_FILENO : ::open(file.c_str(), O_RDONLY)),
+		block_size_(std::max<std::size_t>(block_size, 1)),
+		mapping_(nullptr),
+		length_(0),
+		offset_(0),
+		buffer_(),
+		start_(0),
+		end_(0) {
+	if (fd_ == -1) {
+		throw std::runtime_error("cannot open " + file);
+	}
+	struct stat st;
+	if (::fstat(fd_, &st) == 0 and S_ISREG(st.st_mode) and st.st_size > 0) {
+		length_ = static_cast<std::size_t>(st.st_size);
+		void *address = ::mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd_, 0);
+		if (address != MAP_FAILED) {
+			::madvise(address, length_, MADV_SEQUENTIAL);
+			mapping_ = static_cast<const char *>(address);
+			if (fd_ != STDIN_FILENO) {
+				::close(fd_);
+			}
+			fd_ = -1;
+			return;
+		}
+	}
+	buffer_.resize(block_size_);
+}
+
+LineReader::~LineReader() {
+	if (mapping_ != nullptr) {
+		::munmap(const_cast<char *>(mapping_), length_);
+	}
+	if (fd_ != -1 and fd_ != STDIN_FILENO) {
+		::close(fd_);
+	}
+}
+
+bool LineReader::next(const char *&begin, const char *&end) {
+	if (mapping_ != nullptr) {
+		if (offset_ == length_) {
+			return false;
+		}
+		// End the block after the first newline at or past block_size_ bytes.
+		std::size_t stop = std::min(offset_ + block_size_, length_);
+		const void *newline = std::memchr(mapping_ + stop - 1, '\n', length_ - stop + 1);
+		stop = newline == nullptr ? length_ :
+		       static_cast<std::size_t>(static_cast<const char *>(newline) - mapping_) + 1;
+		begin = mapping_ + offset_;
+		end = mapping_ + stop;
+		offset_ = stop;
+		return true;
+	}
+
+	// Read until a block's worth of data is buffered, then hand out its whole lines, reading on
+	// if there is not a single one.
+	bool more = fd_ != -1;
+	while (more and end_ - start_ < block_size_) {
+		more = fill();
+	}
+	const void *last;
+	while ((last = ::memrchr(buffer_.data() + start_, '\n', end_ - start_)) == nullptr and more) {
+		more = fill();
+	}
+	auto newline = static_cast<const char *>(last);
+	if (newline == nullptr and start_ == end_) {
+		return false;
+	}
+	begin = buffer_.data() + start_;
+	end = newline == nullptr ? buffer_.data() + end_ : newline + 1;
+	start_ = static_cast<std::size_t>(end - buffer_.data());
+	return true;
+}
+
+bool LineReader::fill() {
+	if (fd_ == -1) {
+		return false;
+	}
+	if (start_ != 0) {
+		std::memmove(buffer_.data(), buffer_.data() + start_, end_ - start_);
+		end_ -= start_;
+		start_ = 0;
+	}
+	if (end_ == buffer_.size()) {
+		buffer_.resize(2 * buffer_.size());
+	}
+	ssize_t n;
+	do {
+		n = ::read(fd_, buffer_.data() + end_, buffer_.size() - end_);
+	} while (n == -1 and errno == EINTR);
+	if (n == -1) {
+		throw std::runtime_error("cannot read " + name_ + ": " + std::strerror(errno));
+	}
+	if (n == 0) {
+		if (fd_ != STDIN_FILENO) {
+			::close(fd_);
+		}
+		fd_ = -1;
+		return false;
+	}
+	end_ += static_cast<std::size_t>(n);
+	return true;
+}
+
+/*
+ * Solves the blocks of lines of an input on the threads of a pool and writes out the results in
+ * order.
+ */
+class BatchSolver {
+public:
+	/*
+	 * Create a solver finding words in the given dictionary with the given settings, on the
+	 * threads of the given pool.
+	 */
+	BatchSolver(const Trie& dictionary, const options_t& options, ThreadPool& pool) :
+			dictionary_(dictionary),
+			options_(options),
+			pool_(pool),
+			lines_(),
+			chunks_() { }
+
+	// Delete copy constructor and copy assignment.
+	BatchSolver(const BatchSolver&) = delete;
+
+	BatchSolver& operator=(const BatchSolver&) = delete;
+
+	/*
+	 * Solve the boards of the given input and write out the results. Throws std::runtime_error,
+	 * giving the line number, if a line is not a board, or if the input can not be read.
+	 */
+	void run(const std::string& input) {
+		LineReader reader(input, options_.block_size);
+		std::size_t first_line = 1; // The number of the first line of the block.
+		const char *begin;
+		const char *end;
+		while (reader.next(begin, end)) {
+			lines_.clear();
+			for (const char *line = begin; line != end;) {
+				auto length = static_cast<std::size_t>(end - line);
+				auto newline = static_cast<const char *>(std::memchr(line, '\n', length));
+				const char *next = newline == nullptr ? end : newline + 1;
+				lines_.emplace_back(line, newline == nullptr ? end : newline);
+				line = next;
+			}
+			solve(input, first_line);
+			for (std::size_t c = 0; c < n_chunks(); ++c) {
+				write(chunks_[c]);
+			}
+			first_line += lines_.size();
+		}
+	}
+
+private:
+	static constexpr std::size_t chunk_size = 256; // The number of lines a thread takes at a time.
+
+	const Trie& dictionary_;
+	const options_t& options_;
+	ThreadPool& pool_;
+	std::vector<std::pair<const char *, const char *>> lines_; // The lines of the current block,
+	// without their newlines.
+	std::vector<std::string> chunks_; // The output of each chunk of lines of the block.
+
+	std::size_t n_chunks() const {
+		return (lines_.size() + chunk_size - 1) / chunk_size;
+	}
+
+	/*
+	 * Solve the boards of the current block and place the output of each chunk of lines in
+	 * chunks_. The given input and line number are for errors.
+	 */
+	void solve(const std::string& input, std::size_t first_line) {
+		if (chunks_.size() < n_chunks()) {
+			chunks_.resize(n_chunks());
+		}
+		std::atomic<std::size_t> next(0);
+		auto job = [&](std::size_t) {
+			std::string letters;
+			std::vector<std::string> words;
+			for (std::size_t c = next.fetch_add(1); c < n_chunks(); c = next.fetch_add(1)) {
+				std::string& out = chunks_[c];
+				out.clear();
+				std::size_t last = std::min((c + 1) * chunk_size, lines_.size());
+				for (std::size_t i = c * chunk_size; i < last; ++i) {
+					try {
+						if (parse_board(lines_[i].first, lines_[i].second, letters)) {
+							format(make_board(letters), words, out);
+						}
+					} catch (const std::invalid_argument& e) {
+						throw std::runtime_error(input + ":" + std::to_string(first_line + i) +
+						                         ": " + e.what());
+					}
+				}
+			}
+		};
+		pool_.run(job);
+	}
+
+	/*
+	 * Return the board with the given letters, which is square unless its dimensions are set.
+	 */
+	AnyBoggle make_board(const std::string& letters) const {
+		if (options_.rows != 0) {
+			return AnyBoggle(options_.rows, options_.cols, letters);
+		}
+		auto side = static_cast<std::size_t>(std::lround(std::sqrt(letters.size())));
+		if (side * side != letters.size()) {
+			throw std::invalid_argument(std::to_string(letters.size()) + " letters do not make a "
+			                            "square board; give the dimensions with -r and -c");
+		}
+		return AnyBoggle(side, side, letters);
+	}
+
+	/*
+	 * Solve the given board and append its line of output to 'out', using 'words' for its words.
+	 */
+	void format(const AnyBoggle& board, std::vector<std::string>& words, std::string& out) const {
+		out += board.letters();
+		out += ',';
+		if (options_.format == format_t::words) {
+			board.solve(dictionary_, words);
+			std::sort(words.begin(), words.end());
+			for (std::size_t i = 0; i < words.size(); ++i) {
+				if (i != 0) {
+					out += ' ';
+				}
+				out += words[i];
+			}
+		} else {
+			bool score = options_.format == format_t::score;
+			std::size_t total = 0;
+			board.visit(dictionary_, [score, &total](const auto& m) {
+				total += score ? word_score(m.length) : 1;
+				return true;
+			});
+			out += std::to_string(total);
+		}
+		out += '\n';
+	}
+
+	/*
+	 * Write the given output to standard output. Throws std::runtime_error if it fails.
+	 */
+	static void write(const std::string& out) {
+		if (std::fwrite(out.data(), 1, out.size(), stdout) != out.size()) {
+			throw std::runtime_error(std::string("cannot write output: ") + std::strerror(errno));
+		}
+	}
+};
+
+/*
+ * Print how to use the program to the given stream.
+ */
+void usage(std::ostream& out, const char *program) {
+	options_t defaults;
+	out << "usage: " << program << " [options] [FILE...]\n"
+	    << "Solve the boards in the given files, or standard input if there are none or a file is\n"
+	    << "'-', one board per line, optionally followed by a comma and anything else.\n"
+	    << "  -o FORMAT   output for each board: words, count or score (default words)\n"
+	    << "  -r ROWS     rows of the boards (default: square boards)\n"
+	    << "  -c COLS     columns of the boards (default: square boards)\n"
+	    << "  -t THREADS  number of threads (default " << defaults.n_threads << ")\n"
+	    << "  -b BYTES    bytes of input taken at a time (default " << defaults.block_size << ")\n"
+	    << "  -d FILE     dictionary, one word per line (default " << defaults.dictionary << ")\n"
+	    << "  -m FILE     dictionary saved with Trie::save, mapped instead of reading -d\n";
+}
+}
+
+int main(int argc, char *argv[]) {
+	options_t options;
+	int option;
+	while ((option = getopt(argc, argv, "o:r:c:t:b:d:m:h")) != -1) {
+		switch (option) {
+			case 'o':
+				if (std::strcmp(optarg, "words") == 0) {
+					options.format = format_t::words;
+				} else if (std::strcmp(optarg, "count") == 0) {
+					options.format = format_t::count;
+				} else if (std::strcmp(optarg, "score") == 0) {
+					options.format = format_t::score;
+				} else {
+					usage(std::cerr, argv[0]);
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'r':
+				options.rows = parse_number(argv[0], optarg, usage);
+				break;
+			case 'c':
+				options.cols = parse_number(argv[0], optarg, usage);
+				break;
+			case 't':
+				options.n_threads = parse_number(argv[0], optarg, usage);
+				break;
+			case 'b':
+				options.block_size = parse_number(argv[0], optarg, usage);
+				break;
+			case 'd':
+				options.dictionary = optarg;
+				break;
+			case 'm':
+				options.trie = optarg;
+				break;
+			case 'h':
+				usage(std::cout, argv[0]);
+				return EXIT_SUCCESS;
+			default:
+				usage(std::cerr, argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+	if ((options.rows == 0) != (options.cols == 0)) {
+		usage(std::cerr, argv[0]);
+		return EXIT_FAILURE;
+	}
+	options.inputs.assign(argv + optind, argv + argc);
+	if (options.inputs.empty()) {
+		options.inputs.emplace_back("-");
+	}
+
+	try {
+		// The one pool of the program both builds the dictionary and solves the boards.
+		ThreadPool pool(options.n_threads);
+		Trie dictionary = open_dictionary(options.dictionary, options.trie, false, pool);
+
+		// Results are written a chunk at a time, so stdout gets a buffer much larger than a chunk.
+		static char buffer[1 << 20];
+		std::setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+		BatchSolver solver(dictionary, options, pool);
+		for (const auto& input : options.inputs) {
+			solver.run(input);
+		}
+		if (std::fflush(stdout) != 0) {
+			throw std::runtime_error(std::string("cannot write output: ") + std::strerror(errno));
+		}
+	} catch (const std::exception& e) {
+		std::fflush(stdout);
+		std::cerr << argv[0] << ": " << e.what() << "\n";
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
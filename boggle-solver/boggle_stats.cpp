@@ -0,0 +1,167 @@
+/*
+ * boggle-stats: the distributions of the number of words, the score and the longest word of random
+ * boards rolled from a set of Boggle dice.
+ *
+ * Boards are rolled and solved in parallel by BoardStats::sample, which keeps only histograms, so
+ * the number of boards is only limited by time. A run is reproducible: the same dice, seed, number
+ * of boards and dictionary give the same statistics on any number of threads. The summary has the
+ * mean, quantiles and extremes of each distribution and the number of boards solved per second;
+ * with -H the histograms themselves are written instead, as CSV.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+#include "board_stats.hpp"
+#include "boggle.hpp"
+#include "command_line.hpp"
+#include "dice.hpp"
+#include "thread_pool.hpp"
+#include "trie.hpp"
+
+namespace {
+/*
+ * The settings of a run, set from the command line.
+ */
+struct options_t {
+	std::string dice = "modern"; // The name of the dice set.
+	std::uint64_t n_boards = 100000; // The number of boards.
+	std::uint64_t seed = 0; // The seed of the run.
+	std::size_t n_threads = ThreadPool::default_size(); // The number of threads.
+	bool histograms = false; // Whether to write the histograms rather than the summary.
+	std::string dictionary = DICT_PATH; // The word list.
+	std::string trie; // A dictionary saved with Trie::save, used instead of the word list if set.
+};
+
+/*
+ * Print how to use the program to the given stream.
+ */
+void usage(std::ostream& out, const char *program) {
+	options_t defaults;
+	out << "usage: " << program << " [options]\n"
+	    << "  -s DICE     dice set: classic or modern (4x4), or big (5x5) (default "
+	    << defaults.dice << ")\n"
+	    << "  -n BOARDS   number of boards (default " << defaults.n_boards << ")\n"
+	    << "  -r SEED     seed of the run (default 0)\n"
+	    << "  -t THREADS  number of threads (default " << defaults.n_threads << ")\n"
+	    << "  -H          write the histograms as CSV rather than a summary\n"
+	    << "  -d FILE     dictionary, one word per line (default " << defaults.dictionary << ")\n"
+	    << "  -m FILE     dictionary saved with Trie::save, mapped instead of reading -d\n";
+}
+
+/*
+ * Write a line of the summary for the given histogram.
+ */
+void summarize(const char *name, const Histogram& histogram) {
+	std::cout << std::left << std::setw(8) << name << std::right << std::fixed
+	          << std::setprecision(2) << std::setw(10) << histogram.mean();
+	for (std::size_t value : {histogram.min(), histogram.quantile(0.5), histogram.quantile(0.9),
+	                          histogram.quantile(0.99), histogram.max()}) {
+		std::cout << std::setw(8) << value;
+	}
+	std::cout << "\n";
+}
+
+/*
+ * Write the histograms as CSV, one row for each value up to the largest of any of them.
+ */
+void write_histograms(const BoardStats& stats) {
+	std::cout << "value,words,score,longest\n";
+	std::size_t max = std::max(stats.words.max(), std::max(stats.score.max(), stats.longest.max()));
+	for (std::size_t value = 0; value <= max; ++value) {
+		std::cout << value << "," << stats.words.count(value) << "," << stats.score.count(value)
+		          << "," << stats.longest.count(value) << "\n";
+	}
+}
+
+/*
+ * Sample the boards of the given dice on N by N boards on the threads of the given pool and write
+ * the statistics.
+ */
+template <std::size_t N>
+void run(const options_t& options, const DiceSet& dice, const Trie& dictionary, ThreadPool& pool) {
+	auto start = std::chrono::steady_clock::now();
+	BoardStats stats = BoardStats::sample<N>(dice, options.n_boards, options.seed, dictionary,
+	                                         pool);
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	if (options.histograms) {
+		write_histograms(stats);
+		return;
+	}
+
+	std::cout << stats.boards << " boards of " << options.dice << " dice, seed " << options.seed
+	          << "\n\n"
+	          << "              mean     min     p50     p90     p99     max\n";
+	summarize("words", stats.words);
+	summarize("score", stats.score);
+	summarize("longest", stats.longest);
+	std::cout << "\n" << stats.boards << " boards in " << std::setprecision(2) << elapsed.count()
+	          << " s on " << pool.size() << " threads, " << std::setprecision(0)
+	          << static_cast<double>(stats.boards) / elapsed.count() << " boards/s\n";
+}
+}
+
+int main(int argc, char *argv[]) {
+	options_t options;
+	int option;
+	while ((option = getopt(argc, argv, "s:n:r:t:Hd:m:h")) != -1) {
+		switch (option) {
+			case 's':
+				options.dice = optarg;
+				break;
+			case 'n':
+				options.n_boards = parse_number(argv[0], optarg, usage);
+				break;
+			case 'r':
+				options.seed = parse_number(argv[0], optarg, usage);
+				break;
+			case 't':
+				options.n_threads = parse_number(argv[0], optarg, usage);
+				break;
+			case 'H':
+				options.histograms = true;
+				break;
+			case 'd':
+				options.dictionary = optarg;
+				break;
+			case 'm':
+				options.trie = optarg;
+				break;
+			case 'h':
+				usage(std::cout, argv[0]);
+				return EXIT_SUCCESS;
+			default:
+				usage(std::cerr, argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+	if (optind != argc) {
+		usage(std::cerr, argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	try {
+		const DiceSet& dice = DiceSet::named(options.dice);
+		ThreadPool pool(options.n_threads);
+		Trie dictionary = open_dictionary(options.dictionary, options.trie, false, pool);
+		switch (dice.size()) {
+			case 16:
+				run<4>(options, dice, dictionary, pool);
+				break;
+			case 25:
+				run<5>(options, dice, dictionary, pool);
+				break;
+			default:
+				throw std::invalid_argument("no board fits " + std::to_string(dice.size()) +
+				                            " dice");
+		}
+	} catch (const std::exception& e) {
+		std::cerr << argv[0] << ": " << e.what() << "\n";
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "boggle.hpp"
+#include "thread_pool.hpp"
+#include "trie.hpp"
+
+/*
+ * Return the number given as the argument of an option, or if it is not a number, print the usage
+ * of the program with the given function and exit.
+ */
+inline std::uint64_t parse_number(const char *program, const char *arg,
+                                  void (*usage)(std::ostream&, const char *)) {
+	char *end;
+	unsigned long long value = std::strtoull(arg, &end, 10);
+	if (*arg == '\0' or *end != '\0') {
+		usage(std::cerr, program);
+		std::exit(EXIT_FAILURE);
+	}
+	return value;
+}
+
+/*
+ * Return the dictionary of a tool: the word list in the file 'words', built on the threads of the
+ * given pool and minimized into a DAWG if 'minimize' is true, or if 'trie' is not empty, the
+ * dictionary saved with Trie::save that it names, mapped instead. Throws std::runtime_error if the
+ * saved dictionary can not be mapped or if the dictionary holds no words, naming the file read.
+ */
+inline Trie open_dictionary(const std::string& words, const std::string& trie, bool minimize,
+                            ThreadPool& pool) {
+	Trie dictionary = trie.empty() ? Boggle<>::read_dictionary(words, minimize, pool) :
+	                  Trie::map(trie);
+	if (dictionary.empty()) {
+		throw std::runtime_error("could not read any words from " + (trie.empty() ? words : trie));
+	}
+	return dictionary;
+}
+
+/*
+ * Place the letters of the board on the given line, from 'begin' to 'end', in 'letters', in
+ * uppercase, and return true, or return false if the line is empty. The letters are those before
+ * the first comma, so a CSV record such as those of tests/data/boggle_4x4.csv is read as is, and
+ * spaces, tabs and carriage returns are ignored. The square 'QU' is written 'Q', and a 'U' right
+ * after a 'Q' is part of it, in either case, so 'Q', 'Qu', 'QU', 'qu' and 'q' all stand for the
+ * one square. Throws std::invalid_argument if the line has anything else before the first comma.
+ */
+inline bool parse_board(const char *begin, const char *end, std::string& letters) {
+	letters.clear();
+	bool after_q = false; // Whether the last character was a 'Q'.
+	for (const char *c = begin; c != end and *c != ','; ++c) {
+		if (*c == '\r' or *c == ' ' or *c == '\t') {
+			after_q = false;
+			continue;
+		}
+		char letter = *c >= 'a' and *c <= 'z' ? static_cast<char>(*c - 'a' + 'A') : *c;
+		if (letter < 'A' or letter > 'Z') {
+			throw std::invalid_argument(std::string("invalid character '") + *c + "'");
+		}
+		if (letter == 'U' and after_q) {
+			after_q = false;
+			continue;
+		}
+		letters.push_back(letter);
+		after_q = letter == 'Q';
+	}
+	return not letters.empty();
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * A counter-based random number generator: the ith number of a stream is a hash of the key of the
+ * stream and i, with no other state.
+ *
+ * Any number of any stream can be computed directly, so work split between threads can give each
+ * unit of work, say each board of a sample, a stream keyed by the seed of the run and the index of
+ * the unit, and the numbers drawn do not depend on which thread does the work or in what order.
+ * The hash is the finalizer of SplitMix64 applied to the key and the counter combined with an odd
+ * multiplier, which passes the usual statistical test batteries and costs a few multiplications per
+ * number, far less than solving a board.
+ */
+class CounterRng {
+public:
+	using result_type = std::uint64_t;
+
+	/*
+	 * Create the stream with the given index derived from the given seed.
+	 */
+	CounterRng(std::uint64_t seed, std::uint64_t stream) :
+			key_(mix(seed ^ mix(stream + golden))),
+			counter_(0) { }
+
+	/*
+	 * Return the next number of the stream.
+	 */
+	std::uint64_t operator()() {
+		return mix(key_ + golden * ++counter_);
+	}
+
+	/*
+	 * Return a number in [0, n), for n > 0. The number is the high half of the product of n and 32
+	 * random bits, which is off from uniform by at most n / 2^32, far too little to matter for
+	 * picking dice and faces.
+	 */
+	std::uint32_t below(std::uint32_t n) {
+		return static_cast<std::uint32_t>(((*this)() >> 32) * n >> 32);
+	}
+
+	static constexpr std::uint64_t min() {
+		return 0;
+	}
+
+	static constexpr std::uint64_t max() {
+		return ~std::uint64_t{0};
+	}
+
+private:
+	static constexpr std::uint64_t golden = 0x9e3779b97f4a7c15; // 2^64 divided by the golden ratio.
+
+	std::uint64_t key_; // The key of the stream.
+	std::uint64_t counter_; // The number of numbers drawn.
+
+	/*
+	 * Return the SplitMix64 hash of the given number.
+	 */
+	static std::uint64_t mix(std::uint64_t x) {
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+		return x ^ (x >> 31);
+	}
+};
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * A set of Boggle dice, one for each square of the board, each with six faces.
+ *
+ * A board is rolled the way it is in the game: the dice are shaken into random squares and each
+ * shows a random face. Faces are uppercase letters, 'Q' standing for the face 'Qu' as it does for a
+ * square of a board. The sets of the published games are built in; others can be given face by
+ * face.
+ */
+class DiceSet {
+public:
+	using die_t = std::array<char, 6>; // The faces of a die.
+
+	/*
+	 * Create a set of the given dice, each given as a string of six uppercase letters. Throws
+	 * std::invalid_argument if there are no dice or a die does not have six letters.
+	 */
+	explicit DiceSet(const std::vector<std::string>& dice) :
+			dice_() {
+		if (dice.empty()) {
+			throw std::invalid_argument("a dice set needs at least one die");
+		}
+		dice_.reserve(dice.size());
+		for (const auto& faces : dice) {
+			if (faces.size() != 6) {
+				throw std::invalid_argument("a die needs six faces, not '" + faces + "'");
+			}
+			die_t die;
+			for (std::size_t i = 0; i < 6; ++i) {
+				if (faces[i] < 'A' or faces[i] > 'Z') {
+					throw std::invalid_argument("invalid face '" + faces.substr(i, 1) + "'");
+				}
+				die[i] = faces[i];
+			}
+			dice_.push_back(die);
+		}
+	}
+
+	/*
+	 * Return the number of dice, which is the number of squares of the boards rolled.
+	 */
+	std::size_t size() const {
+		return dice_.size();
+	}
+
+	/*
+	 * Return the ith die.
+	 */
+	const die_t& die(std::size_t i) const {
+		return dice_[i];
+	}
+
+	/*
+	 * Roll a board with the given random number generator, which has a member below(n) returning
+	 * a number in [0, n), such as CounterRng, and place its size() letters in 'board', in row-major
+	 * order.
+	 */
+	template <typename Rng>
+	void roll(Rng& rng, char *board) const {
+		// Rolling the dice in order and shuffling the letters with Fisher-Yates is the same as
+		// shaking the dice into random squares.
+		std::size_t n = dice_.size();
+		for (std::size_t i = 0; i < n; ++i) {
+			board[i] = dice_[i][rng.below(6)];
+		}
+		for (std::size_t i = n; i > 1; --i) {
+			std::swap(board[i - 1], board[rng.below(static_cast<std::uint32_t>(i))]);
+		}
+	}
+
+	/*
+	 * Return the 16 dice of classic 4 by 4 Boggle, sold until 1987.
+	 */
+	static const DiceSet& classic() {
+		static const DiceSet dice({
+			"AACIOT", "ABILTY", "ABJMOQ", "ACDEMP", "ACELRS", "ADENVZ", "AHMORS", "BIFORX",
+			"DENOSW", "DKNOTU", "EEFHIY", "EGKLUY", "EGINTV", "EHINPS", "ELPSTU", "GILRUW"
+		});
+		return dice;
+	}
+
+	/*
+	 * Return the 16 dice of 4 by 4 Boggle as sold since 1987.
+	 */
+	static const DiceSet& modern() {
+		static const DiceSet dice({
+			"AAEEGN", "ABBJOO", "ACHOPS", "AFFKPS", "AOOTTW", "CIMOTU", "DEILRX", "DELRVY",
+			"DISTTY", "EEGHNW", "EEINSU", "EHRTVW", "EIOSST", "ELRTTY", "HIMNQU", "HLNNRZ"
+		});
+		return dice;
+	}
+
+	/*
+	 * Return the 25 dice of 5 by 5 Big Boggle.
+	 */
+	static const DiceSet& big() {
+		static const DiceSet dice({
+			"AAAFRS", "AAEEEE", "AAFIRS", "ADENNN", "AEEEEM", "AEEGMU", "AEGMNN", "AFIRSY",
+			"BJKQXZ", "CCENST", "CEIILT", "CEILPT", "CEIPST", "DDHNOT", "DHHLOR", "DHLNOR",
+			"DHLNOR", "EIIITT", "EMOTTT", "ENSSSU", "FIPRSY", "GORRVW", "IPRRRY", "NOOTUW",
+			"OOOTTU"
+		});
+		return dice;
+	}
+
+	/*
+	 * Return the built-in set with the given name, "classic", "modern" or "big". Throws
+	 * std::invalid_argument if there is none.
+	 */
+	static const DiceSet& named(const std::string& name) {
+		if (name == "classic") {
+			return classic();
+		} else if (name == "modern") {
+			return modern();
+		} else if (name == "big") {
+			return big();
+		}
+		throw std::invalid_argument("no dice set named '" + name + "'");
+	}
+
+private:
+	std::vector<die_t> dice_;
+};
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "board_search.hpp"
+#include "neighbours.hpp"
+#include "search_stats.hpp"
+#include "thread_pool.hpp"
+#include "trie.hpp"
+
+/*
+ * A Boggle board whose dimensions are only known at run time.
+ *
+ * This is the generic kernel behind AnyBoggle, used for the sizes that have no Boggle<N, M>
+ * instantiation. It runs the search of Boggle<N, M>, BoardSearch, with the neighbours of each
+ * square kept in a table built when the board is created and the squares of the current path kept
+ * in a multiword bitset, so it filters the dictionary with the board, balances parallel solves
+ * with work stealing and interleaves searches on one thread just the same. It offers the same
+ * solve, solve_ids and visit overloads, and a Match of the same shape, so that the two can be used
+ * interchangeably in templates.
+ */
+class DynamicBoggle {
+public:
+	/*
+	 * Create a board with the given number of rows and columns from the given letters, in row-major
+	 * order. The letters must be uppercase ASCII letters, 'Q' standing for the square 'QU'. Throws
+	 * std::invalid_argument if a dimension is zero or the number of letters does not match them.
+	 */
+	DynamicBoggle(std::size_t rows, std::size_t cols, const std::string& letters);
+
+	/*
+	 * Return the number of rows of the board.
+	 */
+	std::size_t rows() const;
+
+	/*
+	 * Return the number of columns of the board.
+	 */
+	std::size_t cols() const;
+
+	/*
+	 * Return a constant pointer to the first element in the ith row. No bounds checks are made.
+	 */
+	const char *operator[](std::size_t i) const;
+
+	/*
+	 * Scratch memory used by a single thread to search a board, see BoardSearch::Workspace. The
+	 * buffers grow to fit the largest board searched with the workspace.
+	 */
+	using Workspace = BoardSearch<dynamic_size, dynamic_size>::Workspace;
+
+	/*
+	 * Return the words in the board that are in the given dictionary, searching on the threads of
+	 * the given pool, see Boggle<N, M>::solve.
+	 */
+	std::vector<std::string> solve(const Trie& dictionary, ThreadPool& pool) const;
+
+	/*
+	 * As above, also counting the work done by the search, and by each thread, in the given stats,
+	 * which are reset first. See SearchStats.
+	 */
+	std::vector<std::string> solve(const Trie& dictionary, ThreadPool& pool,
+	                               SearchStats& stats) const;
+
+	/*
+	 * As above, but return the IDs of the words in the dictionary.
+	 */
+	std::vector<std::uint32_t> solve_ids(const Trie& dictionary, ThreadPool& pool) const;
+
+	/*
+	 * Find the words in the board that are in the given dictionary using only the calling thread
+	 * and place them in the given vector, which is cleared first.
+	 */
+	void solve(const Trie& dictionary, Workspace& workspace, std::vector<std::string>& words) const;
+
+	/*
+	 * As above, also counting the work done by the search in the given stats, which are reset
+	 * first. See SearchStats.
+	 */
+	void solve(const Trie& dictionary, Workspace& workspace, std::vector<std::string>& words,
+	           SearchStats& stats) const;
+
+	/*
+	 * As above, but place the IDs of the words in the dictionary in the given vector.
+	 */
+	void solve_ids(const Trie& dictionary, Workspace& workspace,
+	               std::vector<std::uint32_t>& ids) const;
+
+	/*
+	 * A word found by visit, see Boggle<N, M>::Match.
+	 */
+	using Match = BoardSearch<dynamic_size, dynamic_size>::Match;
+
+	/*
+	 * Call the given visitor with a Match for each word of the given dictionary in the board, on
+	 * the calling thread, until it returns false. See Boggle<N, M>::visit.
+	 */
+	template <typename Visitor>
+	bool visit(const Trie& dictionary, Workspace& workspace, Visitor&& visitor) const;
+
+private:
+	std::size_t rows_;
+	std::size_t cols_;
+	std::string board_; // The letters of the board in row-major order.
+	Neighbours<dynamic_size, dynamic_size> neighbours_; // The neighbours of each square.
+
+	/*
+	 * Return the search of the board, see BoardSearch.
+	 */
+	BoardSearch<dynamic_size, dynamic_size> search() const;
+};
+
+inline DynamicBoggle::DynamicBoggle(std::size_t rows, std::size_t cols,
+                                    const std::string& letters) :
+		rows_(rows),
+		cols_(cols),
+		board_(letters),
+		neighbours_(rows, cols) {
+	if (rows == 0 or cols == 0 or letters.size() != rows * cols) {
+		throw std::invalid_argument("a " + std::to_string(rows) + " by " + std::to_string(cols) +
+		                            " board can not hold " + std::to_string(letters.size()) +
+		                            " letters");
+	}
+}
+
+inline std::size_t DynamicBoggle::rows() const {
+	return rows_;
+}
+
+inline std::size_t DynamicBoggle::cols() const {
+	return cols_;
+}
+
+inline const char *DynamicBoggle::operator[](std::size_t i) const {
+	return &board_[cols_ * i];
+}
+
+inline std::vector<std::string> DynamicBoggle::solve(const Trie& dictionary,
+                                                     ThreadPool& pool) const {
+	NoSearchStats stats;
+	return search().solve_parallel<std::string>(dictionary, pool, stats);
+}
+
+inline std::vector<std::string> DynamicBoggle::solve(const Trie& dictionary, ThreadPool& pool,
+                                                     SearchStats& stats) const {
+	return search().solve_parallel<std::string>(dictionary, pool, stats);
+}
+
+inline std::vector<std::uint32_t> DynamicBoggle::solve_ids(const Trie& dictionary,
+                                                           ThreadPool& pool) const {
+	NoSearchStats stats;
+	return search().solve_parallel<std::uint32_t>(dictionary, pool, stats);
+}
+
+inline void DynamicBoggle::solve(const Trie& dictionary, Workspace& workspace,
+                                 std::vector<std::string>& words) const {
+	words.clear();
+	NoSearchStats stats;
+	search().solve_serial(dictionary, workspace, words, stats);
+}
+
+inline void DynamicBoggle::solve(const Trie& dictionary, Workspace& workspace,
+                                 std::vector<std::string>& words, SearchStats& stats) const {
+	words.clear();
+	auto start = std::chrono::steady_clock::now();
+	stats.reset(board_.size());
+	search().solve_serial(dictionary, workspace, words, stats);
+	stats.busy(0, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+}
+
+inline void DynamicBoggle::solve_ids(const Trie& dictionary, Workspace& workspace,
+                                     std::vector<std::uint32_t>& ids) const {
+	ids.clear();
+	NoSearchStats stats;
+	search().solve_serial(dictionary, workspace, ids, stats);
+}
+
+template <typename Visitor>
+bool DynamicBoggle::visit(const Trie& dictionary, Workspace& workspace, Visitor&& visitor) const {
+	NoSearchStats stats;
+	return search().solve_serial(dictionary, workspace, visitor, stats);
+}
+
+inline BoardSearch<dynamic_size, dynamic_size> DynamicBoggle::search() const {
+	return BoardSearch<dynamic_size, dynamic_size>(board_.data(), neighbours_);
+}
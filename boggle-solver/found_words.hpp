@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/*
+ * The set of words already found on a board, used to report each word once however many paths
+ * spell it out.
+ *
+ * Words are identified by their ID in the dictionary, so the set is a table with one stamp per
+ * word. A word is in the set if its stamp equals the current epoch, so emptying the set for the
+ * next board only increments the epoch rather than clearing the table, and checking and inserting a
+ * word is a single atomic exchange. The table is only cleared when the epoch wraps around or the
+ * dictionary grows. Threads searching the same board can share a set, in which case exactly one of
+ * them claims each word.
+ */
+class FoundWords {
+public:
+	FoundWords() :
+			stamps_(),
+			size_(0),
+			epoch_(0) { }
+
+	// Delete copy constructor and copy assignment.
+	FoundWords(const FoundWords&) = delete;
+
+	FoundWords& operator=(const FoundWords&) = delete;
+
+	/*
+	 * Empty the set and make room for the IDs of a dictionary of the given number of words. Must not
+	 * be called while other threads use the set.
+	 */
+	void reset(std::size_t n_words) {
+		if (n_words > size_) {
+			stamps_.reset(new std::atomic<std::uint32_t>[n_words]);
+			size_ = n_words;
+			clear();
+		} else if (++epoch_ == 0) {
+			clear();
+		}
+	}
+
+	/*
+	 * Insert the word with the given ID into the set and return true if it was not already there.
+	 */
+	bool claim(std::uint32_t id) {
+		std::atomic<std::uint32_t>& stamp = stamps_[id];
+		// Most words are found once, but the load keeps the cache line shared for those that are not.
+		return stamp.load(std::memory_order_relaxed) != epoch_ and
+		       stamp.exchange(epoch_, std::memory_order_relaxed) != epoch_;
+	}
+
+private:
+	std::unique_ptr<std::atomic<std::uint32_t>[]> stamps_; // The epoch at which each word was last
+	// found.
+	std::size_t size_; // The number of stamps.
+	std::uint32_t epoch_; // The stamp of the words in the set. Never 0 once the set is reset.
+
+	/*
+	 * Set every stamp to 0 and start again from epoch 1.
+	 */
+	void clear() {
+		for (std::size_t i = 0; i < size_; ++i) {
+			stamps_[i].store(0, std::memory_order_relaxed);
+		}
+		epoch_ = 1;
+	}
+};
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/*
+ * The buckets of a histogram with one bucket for each value.
+ */
+struct LinearBuckets {
+	/*
+	 * Return the bucket of the given value.
+	 */
+	static std::size_t bucket(std::uint64_t value) {
+		return static_cast<std::size_t>(value);
+	}
+
+	/*
+	 * Return the largest value falling in the given bucket.
+	 */
+	static std::uint64_t highest(std::size_t i) {
+		return i;
+	}
+};
+
+/*
+ * The buckets of a histogram in the style of HdrHistogram: values below 128 each have a bucket of
+ * their own, and every power of two above that is split into 64 buckets, so a value is known to
+ * within 1/64 of itself whatever its size, and any value a 64-bit counter can hold fits in a few
+ * thousand buckets.
+ */
+struct LogBuckets {
+	static constexpr unsigned sub_bits = 6; // The log2 of the buckets per power of two.
+	static constexpr std::uint64_t sub_buckets = std::uint64_t{1} << sub_bits;
+
+	/*
+	 * Return the bucket of the given value. A value of 2 * sub_buckets or more is shifted right
+	 * until it is below that, leaving its top sub_bits + 1 bits, and the number of bits shifted
+	 * out picks out the run of sub_buckets buckets it falls in.
+	 */
+	static std::size_t bucket(std::uint64_t value) {
+		if (value < 2 * sub_buckets) {
+			return static_cast<std::size_t>(value);
+		}
+		auto shift = static_cast<unsigned>(63 - __builtin_clzll(value)) - sub_bits;
+		return static_cast<std::size_t>(shift * sub_buckets + (value >> shift));
+	}
+
+	/*
+	 * Return the largest value falling in the given bucket.
+	 */
+	static std::uint64_t highest(std::size_t i) {
+		if (i < 2 * sub_buckets) {
+			return i;
+		}
+		std::uint64_t shift = i / sub_buckets - 1;
+		return ((i - shift * sub_buckets + 1) << shift) - 1;
+	}
+};
+
+/*
+ * A histogram of non-negative integers, counting the values added in the buckets picked out by
+ * Buckets, which has the static functions 'bucket', returning the bucket of a value, and
+ * 'highest', returning the largest value of a bucket. The count, sum and extremes are kept
+ * exactly whatever the buckets.
+ */
+template <typename Buckets>
+class BasicHistogram {
+public:
+	/*
+	 * Create an empty histogram.
+	 */
+	BasicHistogram() :
+			buckets_(),
+			count_(0),
+			sum_(0),
+			min_(0),
+			max_(0) { }
+
+	/*
+	 * Add the given value the given number of times.
+	 */
+	void add(std::uint64_t value, std::uint64_t count = 1) {
+		if (count == 0) {
+			return;
+		}
+		std::size_t i = Buckets::bucket(value);
+		if (i >= buckets_.size()) {
+			buckets_.resize(i + 1);
+		}
+		buckets_[i] += count;
+		min_ = count_ == 0 ? value : std::min(min_, value);
+		max_ = std::max(max_, value);
+		count_ += count;
+		sum_ += value * count;
+	}
+
+	/*
+	 * Add the values of the given histogram.
+	 */
+	void merge(const BasicHistogram& other) {
+		if (other.count_ == 0) {
+			return;
+		}
+		if (other.buckets_.size() > buckets_.size()) {
+			buckets_.resize(other.buckets_.size());
+		}
+		for (std::size_t i = 0; i < other.buckets_.size(); ++i) {
+			buckets_[i] += other.buckets_[i];
+		}
+		min_ = count_ == 0 ? other.min_ : std::min(min_, other.min_);
+		max_ = std::max(max_, other.max_);
+		count_ += other.count_;
+		sum_ += other.sum_;
+	}
+
+	/*
+	 * Return the number of values added.
+	 */
+	std::uint64_t count() const {
+		return count_;
+	}
+
+	/*
+	 * Return the number of values added in the bucket of the given value, with LinearBuckets the
+	 * number of times the value was added.
+	 */
+	std::uint64_t count(std::uint64_t value) const {
+		std::size_t i = Buckets::bucket(value);
+		return i < buckets_.size() ? buckets_[i] : 0;
+	}
+
+	/*
+	 * Return the sum of the values added.
+	 */
+	std::uint64_t sum() const {
+		return sum_;
+	}
+
+	/*
+	 * Return the mean of the values added, or 0 if there are none.
+	 */
+	double mean() const {
+		return count_ == 0 ? 0 : static_cast<double>(sum_) / static_cast<double>(count_);
+	}
+
+	/*
+	 * Return the smallest value added, or 0 if there are none.
+	 */
+	std::uint64_t min() const {
+		return min_;
+	}
+
+	/*
+	 * Return the largest value added, or 0 if there are none.
+	 */
+	std::uint64_t max() const {
+		return max_;
+	}
+
+	/*
+	 * Return a value that at least the given fraction, in [0, 1], of the values added are less
+	 * than or equal to, or 0 if there are none. The value is the largest of its bucket, so the
+	 * quantile is never underestimated, except that it is kept between the smallest and largest
+	 * values added; with LinearBuckets it is exact.
+	 */
+	std::uint64_t quantile(double q) const {
+		auto rank = static_cast<std::uint64_t>(std::ceil(q * static_cast<double>(count_)));
+		std::uint64_t seen = 0;
+		for (std::size_t i = 0; i < buckets_.size(); ++i) {
+			seen += buckets_[i];
+			if (seen >= std::max<std::uint64_t>(rank, 1)) {
+				return std::max(min_, std::min(max_, Buckets::highest(i)));
+			}
+		}
+		return 0;
+	}
+
+private:
+	std::vector<std::uint64_t> buckets_; // The number of values added in each bucket.
+	std::uint64_t count_; // The number of values added.
+	std::uint64_t sum_; // The sum of the values added.
+	std::uint64_t min_; // The smallest value added.
+	std::uint64_t max_; // The largest value added.
+};
+
+/*
+ * A histogram with one bucket for each value up to the largest added.
+ */
+using Histogram = BasicHistogram<LinearBuckets>;
+
+/*
+ * A histogram of latencies in nanoseconds, known to within 1/64 of themselves.
+ */
+using LatencyHistogram = BasicHistogram<LogBuckets>;
@@ -0,0 +1,327 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "boggle.hpp"
+#include "neighbours.hpp"
+#include "prefix_index.hpp"
+#include "trie.hpp"
+
+/*
+ * Keeps the words of an N by M Boggle board up to date while its squares are changed one at a
+ * time, as in a hill climbing or annealing search for high-scoring boards.
+ *
+ * The solver counts, for every word of the dictionary, the number of paths through the board that
+ * spell it out, so a word is on the board while its count is positive. Changing a square only
+ * changes the paths through that square: the solver subtracts the paths through the square with
+ * its old letter, sets the new letter and adds the paths through the square with it, and reports
+ * the words whose count fell to zero or rose from zero. The paths through a square are grown from
+ * the square itself rather than found among all the paths of the board: first backwards, with the
+ * reversed prefixes of a PrefixIndex, to every path ending at the square that spells a prefix of a
+ * word, and then forwards from the square with the dictionary, so the work is proportional to the
+ * paths through the square.
+ *
+ * Words are identified by their ID in the dictionary, see Trie. Building the index of a dictionary
+ * takes far longer than solving a board, so solvers working on the same dictionary, say one per
+ * thread, should share one.
+ */
+template <std::size_t N = 4, std::size_t M = N>
+class IncrementalSolver {
+public:
+	/*
+	 * Find the words of the given board in the dictionary of the given index.
+	 */
+	IncrementalSolver(const Boggle<N, M>& boggle, std::shared_ptr<const PrefixIndex> index);
+
+	/*
+	 * As above, building an index of the given dictionary.
+	 */
+	explicit IncrementalSolver(const Boggle<N, M>& boggle,
+	                           const Trie& dictionary = Boggle<N, M>::dictionary());
+
+	/*
+	 * Return the current board.
+	 */
+	const Boggle<N, M>& board() const;
+
+	/*
+	 * Return the index of the dictionary.
+	 */
+	const std::shared_ptr<const PrefixIndex>& index() const;
+
+	/*
+	 * Return the number of words on the current board.
+	 */
+	std::size_t size() const;
+
+	/*
+	 * Return true if the word with the given ID is on the current board.
+	 */
+	bool contains(std::uint32_t id) const;
+
+	/*
+	 * Return the number of paths through the current board that spell out the word with the given
+	 * ID.
+	 */
+	std::uint32_t paths(std::uint32_t id) const;
+
+	/*
+	 * Return the IDs of the words on the current board, in increasing order.
+	 */
+	std::vector<std::uint32_t> words() const;
+
+	/*
+	 * Set the square at the given row and column to the given letter and place the IDs of the words
+	 * this adds to the board in 'added' and those it removes in 'removed', in no particular order.
+	 * Both vectors are cleared first.
+	 */
+	void set(std::size_t row, std::size_t col, char c, std::vector<std::uint32_t>& added,
+	         std::vector<std::uint32_t>& removed);
+
+	/*
+	 * Replace the board with the given one and find its words from scratch.
+	 */
+	void reset(const Boggle<N, M>& boggle);
+
+private:
+	using neighbours_t = Neighbours<N, M>;
+	using set_t = typename neighbours_t::set_t;
+
+	std::shared_ptr<const PrefixIndex> index_;
+	const Trie& dictionary_; // The dictionary of index_.
+	Boggle<N, M> board_; // The current board.
+	std::vector<std::uint32_t> counts_; // The number of paths spelling out each word.
+	std::vector<bool> pending_; // The words removed while changing a square, until it is done.
+	std::size_t n_words_; // The number of words with a positive count.
+
+	/*
+	 * Add 'delta' to the count of every word spelled out by a path through the given square. If
+	 * 'changed' is given, add the IDs of the words whose count falls to zero or rises from zero to
+	 * it.
+	 */
+	void count_through(std::size_t square, int delta, std::vector<std::uint32_t> *changed);
+
+	/*
+	 * Grow the path ending at the given square backwards from its first square, 'first'. The path
+	 * spells out in reverse the string reaching the given node of the reversed prefixes with the
+	 * given ID, and has the given length in letters. See count_through.
+	 */
+	void walk_back(std::size_t square, std::size_t first, Trie::node_t node, std::uint32_t id,
+	               std::size_t length, set_t& visited, int delta,
+	               std::vector<std::uint32_t> *changed);
+
+	/*
+	 * Add 'delta' to the count of the word spelled out by the path ending at the given square,
+	 * which reaches the given node of the dictionary with the given ID and length, if it is a word,
+	 * and to those of all its extensions. See count_through.
+	 */
+	void walk(std::size_t square, Trie::node_t node, std::uint32_t id, std::size_t length,
+	          set_t& visited, int delta, std::vector<std::uint32_t> *changed);
+
+	/*
+	 * Return the letter of the given square of the current board.
+	 */
+	char letter(std::size_t square) const;
+
+	/*
+	 * Return the node of the given trie reached from the given node by appending the letters of a
+	 * square with the given character, accumulating the ID in 'id', or 0. The letters are appended
+	 * backwards if 'reverse' is true.
+	 */
+	static Trie::node_t step(const Trie& trie, Trie::node_t node, char c, std::uint32_t& id,
+	                         bool reverse);
+
+	/*
+	 * Return the number of letters of a square with the given character.
+	 */
+	static std::size_t n_letters(char c);
+};
+
+template <std::size_t N, std::size_t M>
+IncrementalSolver<N, M>::IncrementalSolver(const Boggle<N, M>& boggle,
+                                           std::shared_ptr<const PrefixIndex> index) :
+		index_(std::move(index)),
+		dictionary_(index_->dictionary()),
+		board_(),
+		counts_(dictionary_.word_count()),
+		pending_(dictionary_.word_count()),
+		n_words_(0) {
+	reset(boggle);
+}
+
+template <std::size_t N, std::size_t M>
+IncrementalSolver<N, M>::IncrementalSolver(const Boggle<N, M>& boggle, const Trie& dictionary) :
+		IncrementalSolver(boggle, std::make_shared<const PrefixIndex>(dictionary)) { }
+
+template <std::size_t N, std::size_t M>
+const Boggle<N, M>& IncrementalSolver<N, M>::board() const {
+	return board_;
+}
+
+template <std::size_t N, std::size_t M>
+const std::shared_ptr<const PrefixIndex>& IncrementalSolver<N, M>::index() const {
+	return index_;
+}
+
+template <std::size_t N, std::size_t M>
+std::size_t IncrementalSolver<N, M>::size() const {
+	return n_words_;
+}
+
+template <std::size_t N, std::size_t M>
+bool IncrementalSolver<N, M>::contains(std::uint32_t id) const {
+	return counts_[id] != 0;
+}
+
+template <std::size_t N, std::size_t M>
+std::uint32_t IncrementalSolver<N, M>::paths(std::uint32_t id) const {
+	return counts_[id];
+}
+
+template <std::size_t N, std::size_t M>
+std::vector<std::uint32_t> IncrementalSolver<N, M>::words() const {
+	std::vector<std::uint32_t> ids;
+	ids.reserve(n_words_);
+	for (std::uint32_t id = 0; id < counts_.size(); ++id) {
+		if (counts_[id] != 0) {
+			ids.push_back(id);
+		}
+	}
+	return ids;
+}
+
+template <std::size_t N, std::size_t M>
+void IncrementalSolver<N, M>::set(std::size_t row, std::size_t col, char c,
+                                  std::vector<std::uint32_t>& added,
+                                  std::vector<std::uint32_t>& removed) {
+	added.clear();
+	removed.clear();
+	if (board_[row][col] == c) {
+		return;
+	}
+
+	// A word can lose all its paths through the square and gain new ones, in which case it is
+	// neither added nor removed. Such words are marked pending while they have no paths.
+	std::size_t square = row * M + col;
+	count_through(square, -1, &removed);
+	for (std::uint32_t id : removed) {
+		pending_[id] = true;
+	}
+	board_[row][col] = c;
+	count_through(square, 1, &added);
+
+	added.erase(std::remove_if(added.begin(), added.end(), [this](std::uint32_t id) {
+		return pending_[id];
+	}), added.end());
+	removed.erase(std::remove_if(removed.begin(), removed.end(), [this](std::uint32_t id) {
+		pending_[id] = false;
+		return counts_[id] != 0;
+	}), removed.end());
+}
+
+template <std::size_t N, std::size_t M>
+void IncrementalSolver<N, M>::reset(const Boggle<N, M>& boggle) {
+	board_ = boggle;
+	std::fill(counts_.begin(), counts_.end(), 0);
+	n_words_ = 0;
+
+	// Every path starts somewhere, so walking forwards from every square counts every path once.
+	set_t visited{};
+	for (std::size_t i = 0; i < N * M; ++i) {
+		std::uint32_t id = 0;
+		Trie::node_t node = step(dictionary_, 0, letter(i), id, false);
+		if (node != 0) {
+			neighbours_t::insert(visited, i);
+			walk(i, node, id, n_letters(letter(i)), visited, 1, nullptr);
+			neighbours_t::erase(visited, i);
+		}
+	}
+}
+
+template <std::size_t N, std::size_t M>
+void IncrementalSolver<N, M>::count_through(std::size_t square, int delta,
+                                            std::vector<std::uint32_t> *changed) {
+	std::uint32_t id = 0;
+	Trie::node_t node = step(index_->reversed(), 0, letter(square), id, true);
+	if (node != 0) {
+		set_t visited{};
+		neighbours_t::insert(visited, square);
+		walk_back(square, square, node, id, n_letters(letter(square)), visited, delta, changed);
+	}
+}
+
+template <std::size_t N, std::size_t M>
+void IncrementalSolver<N, M>::walk_back(std::size_t square, std::size_t first, Trie::node_t node,
+                                        std::uint32_t id, std::size_t length, set_t& visited,
+                                        int delta, std::vector<std::uint32_t> *changed) {
+	// Each path through the square is counted once: its squares up to the square here, and the
+	// rest by the forward walk from the square.
+	const Trie& reversed = index_->reversed();
+	if (reversed.terminal(node)) {
+		walk(square, index_->node(id), index_->id(id), length, visited, delta, changed);
+	}
+
+	auto cursor = neighbours_t::begin(first, visited);
+	std::size_t neighbour;
+	while (neighbours_t::next(first, cursor, visited, neighbour)) {
+		std::uint32_t next_id = id;
+		Trie::node_t next = step(reversed, node, letter(neighbour), next_id, true);
+		if (next != 0) {
+			neighbours_t::insert(visited, neighbour);
+			walk_back(square, neighbour, next, next_id, length + n_letters(letter(neighbour)),
+			          visited, delta, changed);
+			neighbours_t::erase(visited, neighbour);
+		}
+	}
+}
+
+template <std::size_t N, std::size_t M>
+void IncrementalSolver<N, M>::walk(std::size_t square, Trie::node_t node, std::uint32_t id,
+                                   std::size_t length, set_t& visited, int delta,
+                                   std::vector<std::uint32_t> *changed) {
+	if (length >= 3 and dictionary_.terminal(node)) {
+		std::uint32_t& count = counts_[id];
+		if (delta > 0 ? count++ == 0 : --count == 0) {
+			n_words_ = delta > 0 ? n_words_ + 1 : n_words_ - 1;
+			if (changed != nullptr) {
+				changed->push_back(id);
+			}
+		}
+	}
+
+	auto cursor = neighbours_t::begin(square, visited);
+	std::size_t neighbour;
+	while (neighbours_t::next(square, cursor, visited, neighbour)) {
+		std::uint32_t next_id = id;
+		Trie::node_t next = step(dictionary_, node, letter(neighbour), next_id, false);
+		if (next != 0) {
+			neighbours_t::insert(visited, neighbour);
+			walk(neighbour, next, next_id, length + n_letters(letter(neighbour)), visited, delta,
+			     changed);
+			neighbours_t::erase(visited, neighbour);
+		}
+	}
+}
+
+template <std::size_t N, std::size_t M>
+char IncrementalSolver<N, M>::letter(std::size_t square) const {
+	return board_[square / M][square % M];
+}
+
+template <std::size_t N, std::size_t M>
+Trie::node_t IncrementalSolver<N, M>::step(const Trie& trie, Trie::node_t node, char c,
+                                           std::uint32_t& id, bool reverse) {
+	if (c != 'Q') {
+		return trie.child(node, c, id);
+	}
+	node = trie.child(node, reverse ? 'U' : 'Q', id);
+	return node == 0 ? 0 : trie.child(node, reverse ? 'Q' : 'U', id);
+}
+
+template <std::size_t N, std::size_t M>
+std::size_t IncrementalSolver<N, M>::n_letters(char c) {
+	return c == 'Q' ? 2 : 1;
+}
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <boost/container/static_vector.hpp>
+
+/*
+ * The dimensions of a board that are only known at run time, see Neighbours<dynamic_size,
+ * dynamic_size>.
+ */
+constexpr std::size_t dynamic_size = 0;
+
+/*
+ * Adjacency of the squares of an N by M Boggle board, together with the set type used to mark the
+ * squares that are already part of a path.
+ *
+ * Boards with at most 64 squares use a 64-bit word as the set, and the neighbours of each square are
+ * a precomputed mask, so the neighbours still available to a path are 'mask & ~visited' and are
+ * visited with count-trailing-zeros. Larger boards use a multiword bitset for the set and iterate
+ * over a list of neighbours instead, since a mask of 8 squares out of thousands would be mostly
+ * empty words.
+ *
+ * Both specializations have the same static interface:
+ *     set_t       The set of squares in a path.
+ *     cursor_t    Position within the neighbours of a square that a path can still be extended to.
+ *     size        Return the number of squares of the board.
+ *     begin       Return a cursor to the neighbours of a square that are not in the given set.
+ *     next        Advance a cursor to the next neighbour not in the given set, or return false.
+ *     insert      Add a square to a set.
+ *     erase       Remove a square from a set.
+ *     clear       Empty a set.
+ *
+ * Neighbours<dynamic_size, dynamic_size> offers the same interface for a board whose dimensions
+ * are only known at run time, as members of a table built for the board, so code written against
+ * an instance works with all three.
+ */
+template <std::size_t N, std::size_t M, bool = (N * M <= 64)>
+class Neighbours;
+
+/*
+ * Boards with at most 64 squares.
+ */
+template <std::size_t N, std::size_t M>
+class Neighbours<N, M, true> {
+public:
+	using set_t = std::uint64_t;
+	using cursor_t = std::uint64_t; // The neighbours that are left to try.
+
+	static constexpr std::size_t size() {
+		return N * M;
+	}
+
+	static cursor_t begin(std::size_t square, set_t visited) {
+		return table_.masks[square] & ~visited;
+	}
+
+	static bool next(std::size_t, cursor_t& cursor, set_t, std::size_t& neighbour) {
+		if (cursor == 0) {
+			return false;
+		}
+		neighbour = static_cast<std::size_t>(__builtin_ctzll(cursor));
+		cursor &= cursor - 1;
+		return true;
+	}
+
+	static void insert(set_t& set, std::size_t square) {
+		set |= std::uint64_t{1} << square;
+	}
+
+	static void erase(set_t& set, std::size_t square) {
+		set &= ~(std::uint64_t{1} << square);
+	}
+
+	static void clear(set_t& set) {
+		set = 0;
+	}
+
+	/*
+	 * Return the mask of the neighbours of the given square.
+	 */
+	static constexpr std::uint64_t mask(std::size_t square) {
+		return table_.masks[square];
+	}
+
+private:
+	struct table_t {
+		std::uint64_t masks[N * M]; // The ith element has a bit set for each neighbour of square i.
+	};
+
+	static constexpr table_t make_table() {
+		table_t table{};
+		for (std::size_t i = 0; i < N * M; ++i) {
+			std::size_t min_row = i / M == 0 ? 0 : i / M - 1;
+			std::size_t max_row = i / M == N - 1 ? N - 1 : i / M + 1;
+			std::size_t min_col = i % M == 0 ? 0 : i % M - 1;
+			std::size_t max_col = i % M == M - 1 ? M - 1 : i % M + 1;
+
+			for (std::size_t row = min_row; row <= max_row; ++row) {
+				for (std::size_t col = min_col; col <= max_col; ++col) {
+					// Make sure not to add the square itself.
+					if (row * M + col != i) {
+						table.masks[i] |= std::uint64_t{1} << (row * M + col);
+					}
+				}
+			}
+		}
+		return table;
+	}
+
+	static constexpr table_t table_ = make_table();
+};
+
+template <std::size_t N, std::size_t M>
+constexpr typename Neighbours<N, M, true>::table_t Neighbours<N, M, true>::table_;
+
+/*
+ * Boards with more than 64 squares.
+ */
+template <std::size_t N, std::size_t M>
+class Neighbours<N, M, false> {
+public:
+	using set_t = std::array<std::uint64_t, (N * M + 63) / 64>;
+	using cursor_t = std::size_t; // Index of the next neighbour to try.
+
+	static constexpr std::size_t size() {
+		return N * M;
+	}
+
+	static cursor_t begin(std::size_t, const set_t&) {
+		return 0;
+	}
+
+	static bool next(std::size_t square, cursor_t& cursor, const set_t& visited,
+	                 std::size_t& neighbour) {
+		const auto& neighbours = table_.neighbours[square];
+		while (cursor < neighbours.size()) {
+			neighbour = neighbours[cursor++];
+			if ((visited[neighbour / 64] & (std::uint64_t{1} << (neighbour % 64))) == 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static void insert(set_t& set, std::size_t square) {
+		set[square / 64] |= std::uint64_t{1} << (square % 64);
+	}
+
+	static void erase(set_t& set, std::size_t square) {
+		set[square / 64] &= ~(std::uint64_t{1} << (square % 64));
+	}
+
+	static void clear(set_t& set) {
+		set.fill(0);
+	}
+
+private:
+	struct table_t {
+		table_t() {
+			// Find the range of rows and columns constituting the neighbours of each Boggle square.
+			for (std::size_t i = 0; i < neighbours.size(); ++i) {
+				std::size_t min_row, max_row, min_col, max_col;
+				min_row = i / M == 0 ? 0 : i / M - 1;
+				max_row = i / M == N - 1 ? N - 1 : i / M + 1;
+				min_col = i % M == 0 ? 0 : i % M - 1;
+				max_col = i % M == M - 1 ? M - 1 : i % M + 1;
+
+				for (std::size_t row = min_row; row <= max_row; ++row) {
+					for (std::size_t col = min_col; col <= max_col; ++col) {
+						// Make sure not to add the square itself.
+						if (row * M + col != i) {
+							neighbours[i].push_back(row * M + col);
+						}
+					}
+				}
+			}
+		}
+
+		std::array<boost::container::static_vector<std::size_t, 8>, N * M> neighbours; // The ith
+		// element contains the neighbours of the ith Boggle square.
+	};
+
+	static const table_t table_;
+};
+
+template <std::size_t N, std::size_t M>
+const typename Neighbours<N, M, false>::table_t Neighbours<N, M, false>::table_;
+
+/*
+ * Boards whose dimensions are only known at run time. The neighbours of each square are listed in
+ * a table built when the board is created, as for large boards, and the set is a multiword bitset
+ * sized by clear for the board.
+ */
+template <>
+class Neighbours<dynamic_size, dynamic_size> {
+public:
+	using set_t = std::vector<std::uint64_t>;
+	using cursor_t = std::size_t; // Index of the next neighbour to try.
+
+	/*
+	 * Build the table of the neighbours of the squares of a board with the given number of rows
+	 * and columns.
+	 */
+	Neighbours(std::size_t rows, std::size_t cols) :
+			neighbours_(rows * cols) {
+		for (std::size_t i = 0; i < neighbours_.size(); ++i) {
+			std::size_t min_row = i / cols == 0 ? 0 : i / cols - 1;
+			std::size_t max_row = i / cols == rows - 1 ? rows - 1 : i / cols + 1;
+			std::size_t min_col = i % cols == 0 ? 0 : i % cols - 1;
+			std::size_t max_col = i % cols == cols - 1 ? cols - 1 : i % cols + 1;
+
+			for (std::size_t row = min_row; row <= max_row; ++row) {
+				for (std::size_t col = min_col; col <= max_col; ++col) {
+					// Make sure not to add the square itself.
+					if (row * cols + col != i) {
+						neighbours_[i].push_back(static_cast<std::uint32_t>(row * cols + col));
+					}
+				}
+			}
+		}
+	}
+
+	std::size_t size() const {
+		return neighbours_.size();
+	}
+
+	cursor_t begin(std::size_t, const set_t&) const {
+		return 0;
+	}
+
+	bool next(std::size_t square, cursor_t& cursor, const set_t& visited,
+	          std::size_t& neighbour) const {
+		const auto& neighbours = neighbours_[square];
+		while (cursor < neighbours.size()) {
+			neighbour = neighbours[cursor++];
+			if ((visited[neighbour / 64] & (std::uint64_t{1} << (neighbour % 64))) == 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static void insert(set_t& set, std::size_t square) {
+		set[square / 64] |= std::uint64_t{1} << (square % 64);
+	}
+
+	static void erase(set_t& set, std::size_t square) {
+		set[square / 64] &= ~(std::uint64_t{1} << (square % 64));
+	}
+
+	void clear(set_t& set) const {
+		set.assign((size() + 63) / 64, 0);
+	}
+
+private:
+	std::vector<boost::container::static_vector<std::uint32_t, 8>> neighbours_; // The ith element
+	// contains the neighbours of the ith square.
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "trie.hpp"
+
+/*
+ * The prefixes of the words of a dictionary, spelled backwards, for searches that grow a word from
+ * the middle.
+ *
+ * A trie can only be walked from the first letter of a word, so finding the words whose paths pass
+ * through a given square of a board means trying every path into the square. The index instead
+ * holds, in a trie of its own, every prefix of every word of the dictionary reversed. Walking it
+ * from the square backwards, a letter at a time, spells out the part of a word up to and including
+ * the square in reverse, and is abandoned as soon as those letters are not the end of any prefix.
+ * Wherever the reversed trie is at a terminal node the letters are a prefix of a word, and the
+ * index maps the node to the node of the dictionary reached by that prefix and the word ID
+ * accumulated on the way, so the walk can carry on forwards from the square in the dictionary
+ * itself, see Trie::child.
+ *
+ * The index refers to the dictionary, which must outlive it and not change while it is in use.
+ */
+class PrefixIndex {
+public:
+	/*
+	 * Index the prefixes of the words of the given dictionary.
+	 */
+	explicit PrefixIndex(const Trie& dictionary);
+
+	// Delete copy constructor and copy assignment.
+	PrefixIndex(const PrefixIndex&) = delete;
+
+	PrefixIndex& operator=(const PrefixIndex&) = delete;
+
+	/*
+	 * Return the dictionary.
+	 */
+	const Trie& dictionary() const;
+
+	/*
+	 * Return the trie of the reversed prefixes. The string ending at a terminal node is a prefix
+	 * spelled backwards, and its ID in this trie identifies the prefix.
+	 */
+	const Trie& reversed() const;
+
+	/*
+	 * Return the node of the dictionary reached by the prefix with the given ID in reversed().
+	 */
+	Trie::node_t node(std::uint32_t prefix) const;
+
+	/*
+	 * Return the word ID accumulated on the way from the root of the dictionary to the prefix with
+	 * the given ID in reversed().
+	 */
+	std::uint32_t id(std::uint32_t prefix) const;
+
+private:
+	struct prefix_t {
+		std::string reversed; // The prefix spelled backwards.
+		Trie::node_t node; // The node of the dictionary reached by the prefix.
+		std::uint32_t id; // The word ID accumulated on the way to 'node'.
+	};
+
+	const Trie& dictionary_;
+	Trie reversed_; // The reversed prefixes.
+	std::vector<std::pair<Trie::node_t, std::uint32_t>> prefixes_; // The dictionary node and word
+	// ID of each prefix, by its ID in reversed_.
+
+	/*
+	 * Add the prefixes beginning with the given one, which reaches the given node with the given
+	 * ID, to the given vector.
+	 */
+	void collect(std::string& prefix, Trie::node_t node, std::uint32_t id,
+	             std::vector<prefix_t>& prefixes) const;
+};
+
+inline PrefixIndex::PrefixIndex(const Trie& dictionary) :
+		dictionary_(dictionary),
+		reversed_(),
+		prefixes_() {
+	std::vector<prefix_t> prefixes;
+	std::string prefix;
+	collect(prefix, 0, 0, prefixes);
+
+	// IDs are the alphabetical order of the strings, so sorting the reversed prefixes lines them
+	// up with their IDs.
+	std::sort(prefixes.begin(), prefixes.end(), [](const prefix_t& a, const prefix_t& b) {
+		return a.reversed < b.reversed;
+	});
+	prefixes_.reserve(prefixes.size());
+	for (const auto& p : prefixes) {
+		reversed_.insert(p.reversed.c_str());
+		prefixes_.emplace_back(p.node, p.id);
+	}
+	reversed_.shrink_to_fit();
+}
+
+inline const Trie& PrefixIndex::dictionary() const {
+	return dictionary_;
+}
+
+inline const Trie& PrefixIndex::reversed() const {
+	return reversed_;
+}
+
+inline Trie::node_t PrefixIndex::node(std::uint32_t prefix) const {
+	return prefixes_[prefix].first;
+}
+
+inline std::uint32_t PrefixIndex::id(std::uint32_t prefix) const {
+	return prefixes_[prefix].second;
+}
+
+inline void PrefixIndex::collect(std::string& prefix, Trie::node_t node, std::uint32_t id,
+                                 std::vector<prefix_t>& prefixes) const {
+	for (std::uint32_t letters = dictionary_.letters(node); letters != 0; letters &= letters - 1) {
+		char c = static_cast<char>('A' + __builtin_ctz(letters));
+		std::uint32_t next_id = id;
+		Trie::node_t next = dictionary_.child(node, c, next_id);
+		prefix.push_back(c);
+		prefixes.push_back(prefix_t{std::string(prefix.rbegin(), prefix.rend()), next, next_id});
+		collect(prefix, next, next_id, prefixes);
+		prefix.pop_back();
+	}
+}
@@ -1,29 +1,268 @@
 #include "pyboggle.hpp"
 
-PyBoggle::PyBoggle(const bpy::object& pyobject) {
-	for (std::size_t row = 0; row < 4; ++row) {
-		for (std::size_t col = 0; col < 4; ++col) {
-			boggle_[row][col] = bpy::extract<char>(pyobject[4 * row + col]);
-		}
-	}
-}
+std::shared_timed_mutex PyBoggle::lock_;
+std::mutex PyBoggle::turnstile_;
+
+PyBoggle::PyBoggle(const bpy::object& pyobject) :
+		boggle_(square_board(pyobject)) { }
+
+PyBoggle::PyBoggle(const bpy::object& pyobject, std::size_t rows, std::size_t cols) :
+		boggle_(rows, cols, letters(pyobject)) { }
 
 bpy::list PyBoggle::board() const {
 	bpy::list character_list;
-	for (std::size_t row = 0; row < 4; ++row) {
-		for (std::size_t col = 0; col < 4; ++col) {
-			character_list.append(boggle_[row][col]);
-		}
+	for (char c : boggle_.letters()) {
+		character_list.append(c);
 	}
 
 	return character_list;
 }
 
+std::size_t PyBoggle::rows() const {
+	return boggle_.rows();
+}
+
+std::size_t PyBoggle::cols() const {
+	return boggle_.cols();
+}
+
 std::vector<std::string> PyBoggle::solve() const {
-	std::vector<std::string> words = boggle_.solve();
+	GilRelease release;
+	shared_lock_t guard = share_lock();
+	std::vector<std::string> words = boggle_.solve(Boggle<4, 4>::dictionary());
 	return words;
 }
 
-void PyBoggle::load_dictionary(const std::string& dictionary_path) {
-	Boggle<4, 4>::load_dictionary(dictionary_path);
+bpy::tuple PyBoggle::solve_with_stats() const {
+	SearchStats stats;
+	std::vector<std::string> words;
+	{
+		GilRelease release;
+		shared_lock_t guard = share_lock();
+		words = boggle_.solve(Boggle<4, 4>::dictionary(), ThreadPool::global(), stats);
+	}
+
+	bpy::dict counts;
+	counts["nodes"] = stats.nodes;
+	counts["trie_steps"] = stats.trie_steps;
+	counts["prefix_rejections"] = stats.prefix_rejections;
+	counts["filter_rejections"] = stats.filter_rejections;
+	counts["terminal_hits"] = stats.terminal_hits;
+	counts["duplicate_hits"] = stats.duplicate_hits;
+	bpy::list square_nodes;
+	for (auto n : stats.square_nodes) {
+		square_nodes.append(n);
+	}
+	counts["square_nodes"] = square_nodes;
+	bpy::list thread_seconds;
+	for (auto seconds : stats.thread_seconds) {
+		thread_seconds.append(seconds);
+	}
+	counts["thread_seconds"] = thread_seconds;
+	return bpy::make_tuple(words, counts);
+}
+
+bpy::object PyBoggle::solve_bytes() const {
+	std::string text;
+	{
+		GilRelease release;
+		shared_lock_t guard = share_lock();
+		std::vector<std::string> words = boggle_.solve(Boggle<4, 4>::dictionary(),
+		                                               ThreadPool::global());
+		for (const auto& word : words) {
+			if (not text.empty()) {
+				text.push_back('\n');
+			}
+			text.append(word);
+		}
+	}
+	return make_bytes(text.data(), text.size());
+}
+
+bpy::object PyBoggle::solve_ids() const {
+	std::vector<std::uint32_t> ids;
+	{
+		GilRelease release;
+		shared_lock_t guard = share_lock();
+		ids = boggle_.solve_ids(Boggle<4, 4>::dictionary(), ThreadPool::global());
+	}
+	bpy::object bytes = make_bytes(reinterpret_cast<const char *>(ids.data()),
+	                               ids.size() * sizeof(std::uint32_t));
+	bpy::object view(bpy::handle<>(PyMemoryView_FromObject(bytes.ptr())));
+	return view.attr("cast")("I");
+}
+
+std::string PyBoggle::word(std::uint32_t id) {
+	shared_lock_t guard = share_lock();
+	return Boggle<4, 4>::dictionary().word(id);
+}
+
+bpy::list PyBoggle::solve_many(const bpy::object& boards, bool as_bytes) {
+	std::vector<AnyBoggle> boggles;
+	auto n_boards = static_cast<std::size_t>(bpy::len(boards));
+	boggles.reserve(n_boards);
+	for (std::size_t i = 0; i < n_boards; ++i) {
+		boggles.push_back(square_board(boards[i]));
+	}
+
+	ResultSink sink;
+	{
+		GilRelease release;
+		shared_lock_t guard = share_lock();
+		AnyBoggle::solve_many(Boggle<4, 4>::dictionary(), boggles.data(), boggles.size(), sink,
+		                      ThreadPool::global());
+	}
+
+	bpy::list results;
+	std::string text;
+	for (std::size_t i = 0; i < sink.size(); ++i) {
+		if (as_bytes) {
+			text.clear();
+			for (std::size_t j = 0; j < sink.word_count(i); ++j) {
+				if (j != 0) {
+					text.push_back('\n');
+				}
+				text.append(sink.word(i, j));
+			}
+			results.append(make_bytes(text.data(), text.size()));
+			continue;
+		}
+
+		bpy::list words;
+		for (std::size_t j = 0; j < sink.word_count(i); ++j) {
+			words.append(bpy::str(sink.word(i, j)));
+		}
+		results.append(words);
+	}
+	return results;
+}
+
+void PyBoggle::load_dictionary(const std::string& dictionary_path, bool minimize) {
+	GilRelease release;
+	unique_lock_t guard = own_lock();
+	Boggle<4, 4>::load_dictionary(dictionary_path, minimize);
+}
+
+void PyBoggle::save_dictionary(const std::string& path) {
+	GilRelease release;
+	shared_lock_t guard = share_lock();
+	Boggle<4, 4>::save_dictionary(path);
+}
+
+void PyBoggle::map_dictionary(const std::string& path) {
+	GilRelease release;
+	unique_lock_t guard = own_lock();
+	Boggle<4, 4>::map_dictionary(path);
+}
+
+void PyBoggle::set_threads(std::size_t n_threads, bool pin) {
+	GilRelease release;
+	unique_lock_t guard = own_lock();
+	ThreadPool::reset_global(n_threads, pin);
+}
+
+std::size_t PyBoggle::threads() {
+	shared_lock_t guard = share_lock();
+	return ThreadPool::global().size();
+}
+
+std::string PyBoggle::letters(const bpy::object& pyobject) {
+	std::string letters;
+	auto size = static_cast<std::size_t>(bpy::len(pyobject));
+	letters.reserve(size);
+	for (std::size_t i = 0; i < size; ++i) {
+		char c = bpy::extract<char>(pyobject[i]);
+		if (c >= 'a' and c <= 'z') {
+			c = static_cast<char>(c - 'a' + 'A');
+		} else if (c < 'A' or c > 'Z') {
+			throw std::invalid_argument("character " + std::to_string(i) + " of the board is not "
+			                            "a letter");
+		}
+		letters.push_back(c);
+	}
+	return letters;
+}
+
+AnyBoggle PyBoggle::square_board(const bpy::object& pyobject) {
+	std::string board = letters(pyobject);
+	std::size_t n = 0;
+	while (n * n < board.size()) {
+		++n;
+	}
+	if (n * n != board.size()) {
+		throw std::invalid_argument("a board of " + std::to_string(board.size()) +
+		                            " letters is not square");
+	}
+	return AnyBoggle(n, n, std::move(board));
+}
+
+bpy::object PyBoggle::make_bytes(const char *data, std::size_t size) {
+	return bpy::object(bpy::handle<>(
+			PyBytes_FromStringAndSize(data, static_cast<Py_ssize_t>(size))));
+}
+
+void PyTracer::enable(bool on) {
+	Tracer::global().enable(on);
+}
+
+bool PyTracer::enabled() {
+	return Tracer::global().enabled();
+}
+
+std::uint64_t PyTracer::now() {
+	return Tracer::now();
+}
+
+std::uint32_t PyTracer::name(const std::string& name) {
+	return Tracer::global().name(name);
+}
+
+void PyTracer::record(std::uint32_t name, std::uint64_t start, std::uint64_t end) {
+	Tracer::global().record(name, start, end);
+}
+
+void PyTracer::open(const std::string& path) {
+	Tracer::global().open(path);
+}
+
+void PyTracer::flush() {
+	GilRelease release;
+	Tracer::global().flush();
+}
+
+void PyTracer::close() {
+	GilRelease release;
+	Tracer::global().close();
+}
+
+bpy::dict PyTracer::histograms() {
+	std::vector<std::pair<std::string, LatencyHistogram>> histograms;
+	{
+		GilRelease release;
+		histograms = Tracer::global().histograms();
+	}
+
+	bpy::dict result;
+	for (const auto& entry : histograms) {
+		const LatencyHistogram& histogram = entry.second;
+		bpy::dict summary;
+		summary["count"] = histogram.count();
+		summary["mean"] = histogram.mean();
+		summary["min"] = histogram.min();
+		summary["p50"] = histogram.quantile(0.5);
+		summary["p90"] = histogram.quantile(0.9);
+		summary["p99"] = histogram.quantile(0.99);
+		summary["p999"] = histogram.quantile(0.999);
+		summary["max"] = histogram.max();
+		result[entry.first] = summary;
+	}
+	return result;
+}
+
+std::uint64_t PyTracer::dropped() {
+	return Tracer::global().dropped();
+}
+
+void PyTracer::reset() {
+	Tracer::global().reset();
 }
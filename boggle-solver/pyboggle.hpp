@@ -1,41 +1,259 @@
 #pragma once
 
+#include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <vector>
 #include <boost/python.hpp>
 #include <boost/python/suite/indexing/vector_indexing_suite.hpp>
 
+#include "any_boggle.hpp"
 #include "boggle.hpp"
+#include "trace.hpp"
 
 namespace bpy = boost::python;
 
 /*
- * Wraps Boggle<4, 4> in a Pythonic interface.
+ * Releases the Python GIL for its lifetime, so that other Python threads run while the calling
+ * thread solves. Nothing that touches Python objects may be done while it exists.
+ */
+class GilRelease {
+public:
+	GilRelease() :
+			state_(PyEval_SaveThread()) { }
+
+	~GilRelease() {
+		PyEval_RestoreThread(state_);
+	}
+
+	// Delete copy constructor and copy assignment.
+	GilRelease(const GilRelease&) = delete;
+
+	GilRelease& operator=(const GilRelease&) = delete;
+
+private:
+	PyThreadState *state_;
+};
+
+/*
+ * Wraps AnyBoggle in a Pythonic interface, so boards of any size can be solved. The dictionary is
+ * the one of Boggle<4, 4>.
+ *
+ * The GIL is released while boards are searched, so Python threads can solve boards or wait on the
+ * network in parallel. Every use of the dictionary and the global pool holds a lock shared, and
+ * replacing either holds it exclusively, so a dictionary or pool is never freed while another
+ * thread is solving with it: loading a dictionary or setting the number of threads waits for the
+ * solves running, and solves started meanwhile wait for it.
  */
 class PyBoggle {
 public:
 	/*
-	 * Create a Boggle object from a Python container of characters.
+	 * Create a Boggle object from a Python container of letters, which must hold a square number
+	 * of them. Lowercase letters are taken as uppercase. Raises ValueError otherwise.
 	 */
 	PyBoggle(const bpy::object& pyobject);
 
+	/*
+	 * Create a Boggle object with the given number of rows and columns from a Python container of
+	 * letters in row-major order. Lowercase letters are taken as uppercase. Raises ValueError if
+	 * the sizes do not match or a character is not a letter.
+	 */
+	PyBoggle(const bpy::object& pyobject, std::size_t rows, std::size_t cols);
+
 	/*
 	 * Return a Python list of characters in the Boggle board.
 	 */
 	bpy::list board() const;
 
+	/*
+	 * Return the number of rows of the Boggle board.
+	 */
+	std::size_t rows() const;
+
+	/*
+	 * Return the number of columns of the Boggle board.
+	 */
+	std::size_t cols() const;
+
 	/*
 	 * Return the words in the Boggle board.
 	 */
 	std::vector<std::string> solve() const;
 
 	/*
-	 * Load a dictionary. Must be called before 'solve'.
+	 * Solve the Boggle board as 'solve' does, counting the work done by the search, and return a
+	 * tuple of the words and a dict of the counts: the SearchStats counters under their names,
+	 * 'square_nodes', the nodes expanded from each starting square, and 'thread_seconds', the time
+	 * each thread spent searching.
+	 */
+	bpy::tuple solve_with_stats() const;
+
+	/*
+	 * Return the words in the Boggle board as one bytes object, separated by newlines, which is the
+	 * form wordplays.com takes answers in. The board is solved on the global thread pool, as
+	 * 'solve' does, and the words are joined in one buffer without creating an object per word.
+	 */
+	bpy::object solve_bytes() const;
+
+	/*
+	 * Return the IDs of the words in the Boggle board as a memoryview of unsigned 32-bit integers,
+	 * built from one block of memory rather than a string object per word. 'word' turns an ID back
+	 * into its word.
 	 */
-	static void load_dictionary(const std::string& dictionary_path);
+	bpy::object solve_ids() const;
+
+	/*
+	 * Return the word of the loaded dictionary with the given ID. Raises IndexError if there is no
+	 * such word.
+	 */
+	static std::string word(std::uint32_t id);
+
+	/*
+	 * Solve a Python sequence of boards, each a square container of characters like the one passed
+	 * to the constructor, on the threads used by 'solve', giving whole boards to each thread. The
+	 * boards may be of different sizes. Return a
+	 * Python list holding a list of the words of each board, or if 'as_bytes' is true, the words of
+	 * each board in the form returned by 'solve_bytes'.
+	 */
+	static bpy::list solve_many(const bpy::object& boards, bool as_bytes);
+
+	/*
+	 * Load a dictionary, minimizing it into a DAWG if 'minimize' is true. Must be called before
+	 * 'solve'. Waits for any solve running on another thread.
+	 */
+	static void load_dictionary(const std::string& dictionary_path, bool minimize);
+
+	/*
+	 * Save the loaded dictionary to a binary file that can be passed to 'map_dictionary'.
+	 */
+	static void save_dictionary(const std::string& path);
+
+	/*
+	 * Load a dictionary saved by 'save_dictionary' by mapping it into memory. Raises RuntimeError
+	 * if the file is missing, stale or corrupt. Can be called instead of 'load_dictionary'. Waits
+	 * for any solve running on another thread.
+	 */
+	static void map_dictionary(const std::string& path);
+
+	/*
+	 * Replace the pool of threads used by 'solve' with one of the given size, counting the calling
+	 * thread, optionally pinning its threads to CPUs. Waits for any solve running on another
+	 * thread.
+	 */
+	static void set_threads(std::size_t n_threads, bool pin);
+
+	/*
+	 * Return the number of threads used by 'solve', counting the calling thread.
+	 */
+	static std::size_t threads();
 
 private:
-	Boggle<4, 4> boggle_;
+	using shared_lock_t = std::shared_lock<std::shared_timed_mutex>;
+	using unique_lock_t = std::unique_lock<std::shared_timed_mutex>;
+
+	AnyBoggle boggle_;
+	static std::shared_timed_mutex lock_; // Held shared while the dictionary or the global pool is
+	// in use, and exclusively while either is replaced. Released before the GIL is taken back.
+	static std::mutex turnstile_; // Taken to acquire lock_, and held by a thread waiting to hold
+	// it exclusively, so that solves started meanwhile queue behind it rather than starve it.
+
+	/*
+	 * Return lock_ held shared, once no thread is waiting to replace the dictionary or the pool.
+	 */
+	static shared_lock_t share_lock() {
+		std::lock_guard<std::mutex> turn(turnstile_);
+		return shared_lock_t(lock_);
+	}
+
+	/*
+	 * Return lock_ held exclusively, once the solves running have finished.
+	 */
+	static unique_lock_t own_lock() {
+		std::lock_guard<std::mutex> turn(turnstile_);
+		return unique_lock_t(lock_);
+	}
+
+	/*
+	 * Return the characters of a Python container of letters as a string of uppercase letters.
+	 * Throws std::invalid_argument, which Python sees as ValueError, for any character that is not
+	 * a letter from A to Z in either case, since the search indexes tables by letter.
+	 */
+	static std::string letters(const bpy::object& pyobject);
+
+	/*
+	 * Return a board made from a Python container of a square number of characters.
+	 */
+	static AnyBoggle square_board(const bpy::object& pyobject);
+
+	/*
+	 * Return a bytes object holding the given characters.
+	 */
+	static bpy::object make_bytes(const char *data, std::size_t size);
+};
+
+/*
+ * Wraps the global Tracer, so the bot records the spans of its stages on the same clock and in the
+ * same trace as the native solver. Spans are recorded with names interned by 'name' and times
+ * returned by 'now', in nanoseconds.
+ */
+class PyTracer {
+public:
+	/*
+	 * Turn recording spans on or off.
+	 */
+	static void enable(bool on);
+
+	/*
+	 * Return True if spans are being recorded.
+	 */
+	static bool enabled();
+
+	/*
+	 * Return the current time in nanoseconds on the clock of the tracer.
+	 */
+	static std::uint64_t now();
+
+	/*
+	 * Return the ID of the given span name.
+	 */
+	static std::uint32_t name(const std::string& name);
+
+	/*
+	 * Record a span of the name with the given ID on the calling thread.
+	 */
+	static void record(std::uint32_t name, std::uint64_t start, std::uint64_t end);
+
+	/*
+	 * Start writing the trace to the given file in the Chrome trace event format. Raises
+	 * RuntimeError if the file cannot be written.
+	 */
+	static void open(const std::string& path);
+
+	/*
+	 * Drain the recorded spans into the histograms and the trace file.
+	 */
+	static void flush();
+
+	/*
+	 * Flush and close the trace file.
+	 */
+	static void close();
+
+	/*
+	 * Return a dict from each span name to a dict of the count, mean, min, max and the quantiles
+	 * 'p50', 'p90', 'p99' and 'p999' of its durations, in nanoseconds.
+	 */
+	static bpy::dict histograms();
+
+	/*
+	 * Return the number of spans lost because they were not flushed in time.
+	 */
+	static std::uint64_t dropped();
+
+	/*
+	 * Discard the spans and histograms recorded so far.
+	 */
+	static void reset();
 };
 
 BOOST_PYTHON_MODULE (boggle) {
@@ -48,7 +266,39 @@ BOOST_PYTHON_MODULE (boggle) {
 			.def(bpy::vector_indexing_suite<WordList>());
 
 	bpy::class_<PyBoggle>("Boggle", bpy::init<const bpy::object&>())
+			.def(bpy::init<const bpy::object&, std::size_t, std::size_t>(
+					(bpy::arg("board"), bpy::arg("rows"), bpy::arg("cols"))))
 			.def("board", &PyBoggle::board)
-			.def("load_dictionary", &PyBoggle::load_dictionary).staticmethod("load_dictionary")
-			.def("solve", &PyBoggle::solve);
+			.def("rows", &PyBoggle::rows)
+			.def("cols", &PyBoggle::cols)
+			.def("load_dictionary", &PyBoggle::load_dictionary,
+			     (bpy::arg("dictionary_path"), bpy::arg("minimize") = false))
+			.staticmethod("load_dictionary")
+			.def("save_dictionary", &PyBoggle::save_dictionary).staticmethod("save_dictionary")
+			.def("map_dictionary", &PyBoggle::map_dictionary).staticmethod("map_dictionary")
+			.def("set_threads", &PyBoggle::set_threads,
+			     (bpy::arg("n_threads"), bpy::arg("pin") = false))
+			.staticmethod("set_threads")
+			.def("threads", &PyBoggle::threads).staticmethod("threads")
+			.def("solve", &PyBoggle::solve)
+			.def("solve_with_stats", &PyBoggle::solve_with_stats)
+			.def("solve_bytes", &PyBoggle::solve_bytes)
+			.def("solve_ids", &PyBoggle::solve_ids)
+			.def("word", &PyBoggle::word).staticmethod("word")
+			.def("solve_many", &PyBoggle::solve_many,
+			     (bpy::arg("boards"), bpy::arg("as_bytes") = false))
+			.staticmethod("solve_many");
+
+	bpy::class_<PyTracer>("Tracer", bpy::no_init)
+			.def("enable", &PyTracer::enable, (bpy::arg("on") = true)).staticmethod("enable")
+			.def("enabled", &PyTracer::enabled).staticmethod("enabled")
+			.def("now", &PyTracer::now).staticmethod("now")
+			.def("name", &PyTracer::name).staticmethod("name")
+			.def("record", &PyTracer::record).staticmethod("record")
+			.def("open", &PyTracer::open).staticmethod("open")
+			.def("flush", &PyTracer::flush).staticmethod("flush")
+			.def("close", &PyTracer::close).staticmethod("close")
+			.def("histograms", &PyTracer::histograms).staticmethod("histograms")
+			.def("dropped", &PyTracer::dropped).staticmethod("dropped")
+			.def("reset", &PyTracer::reset).staticmethod("reset");
 }
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * Collects the words found on a batch of boards solved in parallel by Boggle::solve_many.
+ *
+ * The words of every board are stored back to back in one arena of characters, each followed by a
+ * null character, together with the offset of each word in the arena and, for each board, the
+ * range of its words. Boards are added in whatever order they finish, each as one contiguous
+ * append under a mutex, so the arena is only locked for the time it takes to copy a board's words.
+ * The arena keeps its capacity when the sink is reset, so a sink reused for batch after batch stops
+ * allocating once it has held the largest batch, and it can be given its capacity up front.
+ */
+class ResultSink {
+public:
+	/*
+	 * Create an empty sink with room for the given number of characters and words, counting one
+	 * null character per word.
+	 */
+	explicit ResultSink(std::size_t text_capacity = 0, std::size_t word_capacity = 0) :
+			text_(),
+			offsets_(),
+			boards_() {
+		text_.reserve(text_capacity);
+		offsets_.reserve(word_capacity);
+	}
+
+	// Delete copy constructor and copy assignment.
+	ResultSink(const ResultSink&) = delete;
+
+	ResultSink& operator=(const ResultSink&) = delete;
+
+	/*
+	 * Remove all words and make room for the given number of boards, which have no words until
+	 * they are appended. Must not be called while other threads append to the sink.
+	 */
+	void reset(std::size_t n_boards) {
+		text_.clear();
+		offsets_.clear();
+		boards_.assign(n_boards, board_t{0, 0});
+	}
+
+	/*
+	 * Store the given words as the words of the ith board. Thread safe.
+	 */
+	template <typename T>
+	void append(std::size_t i, const std::vector<T>& words) {
+		std::lock_guard<std::mutex> guard(lock_);
+		boards_[i] = board_t{offsets_.size(), words.size()};
+		for (const auto& word : words) {
+			offsets_.push_back(text_.size());
+			text_.insert(text_.end(), word.data(), word.data() + word.size());
+			text_.push_back('\0');
+		}
+	}
+
+	/*
+	 * Return the number of boards.
+	 */
+	std::size_t size() const {
+		return boards_.size();
+	}
+
+	/*
+	 * Return the number of words on the ith board.
+	 */
+	std::size_t word_count(std::size_t i) const {
+		return boards_[i].n_words;
+	}
+
+	/*
+	 * Return the jth word of the ith board as a null-terminated string. The pointer is valid until
+	 * the sink is next modified.
+	 */
+	const char *word(std::size_t i, std::size_t j) const {
+		return text_.data() + offsets_[boards_[i].first_word + j];
+	}
+
+	/*
+	 * Return a copy of the words of the ith board.
+	 */
+	std::vector<std::string> words(std::size_t i) const {
+		std::vector<std::string> words;
+		words.reserve(word_count(i));
+		for (std::size_t j = 0; j < word_count(i); ++j) {
+			words.emplace_back(word(i, j));
+		}
+		return words;
+	}
+
+private:
+	struct board_t {
+		std::size_t first_word; // Index in offsets_ of the first word of the board.
+		std::size_t n_words; // The number of words of the board.
+	};
+
+	std::mutex lock_; // Serializes appends.
+	std::vector<char> text_; // The words, each followed by a null character.
+	std::vector<std::size_t> offsets_; // The offset of each word in text_.
+	std::vector<board_t> boards_; // The range of words of each board.
+};
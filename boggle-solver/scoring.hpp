@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+
+/*
+ * Return the points scored by a word of the given number of letters under the standard Boggle
+ * rules: words of three or four letters score 1, five letters 2, six letters 3, seven letters 5 and
+ * eight letters or more 11. Shorter words score nothing. QU counts as two letters.
+ */
+inline unsigned word_score(std::size_t length) {
+	static constexpr unsigned scores[] = {0, 0, 0, 1, 1, 2, 3, 5};
+	return length < 8 ? scores[length] : 11;
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Counts of the work done by a search of a Boggle board, to find out why one board takes longer
+ * than another and how evenly the work is spread over the threads.
+ *
+ * The search takes its counters as a template parameter and calls the members below as it goes. A
+ * plain solve passes NoSearchStats, whose members are empty, so the calls and the clock reads
+ * around them are compiled out; only the overloads of solve taking a SearchStats pay for them. The
+ * threads of a parallel solve each count into their own SearchStats, which are merged once the
+ * search is done, so counting adds no contention. Which thread claims a word first, and in a
+ * parallel solve how the search is split into tasks, can change the counts slightly from one solve
+ * of a board to the next.
+ */
+struct SearchStats {
+	static constexpr bool enabled = true;
+
+	std::uint64_t nodes = 0; // The number of paths extended: DFS nodes expanded.
+	std::uint64_t trie_steps = 0; // The number of steps tried down the trie, one per square.
+	std::uint64_t prefix_rejections = 0; // Steps for which no word continues that way.
+	std::uint64_t filter_rejections = 0; // Steps ruled out by the filter of the board, see
+	// BoardFilter, which are only checked for being a word.
+	std::uint64_t terminal_hits = 0; // Paths of three letters or more that spell out a word.
+	std::uint64_t duplicate_hits = 0; // Terminal hits on a word already found on another path.
+	std::vector<std::uint64_t> square_nodes; // The nodes expanded from paths starting at each
+	// square.
+	std::vector<double> thread_seconds; // The time each thread spent searching, in seconds.
+
+	/*
+	 * Zero the counters for a board of the given number of squares.
+	 */
+	void reset(std::size_t n_squares) {
+		nodes = 0;
+		trie_steps = 0;
+		prefix_rejections = 0;
+		filter_rejections = 0;
+		terminal_hits = 0;
+		duplicate_hits = 0;
+		square_nodes.assign(n_squares, 0);
+		thread_seconds.clear();
+	}
+
+	/*
+	 * Add the counts of the given stats, square by square and thread by thread.
+	 */
+	void merge(const SearchStats& other) {
+		nodes += other.nodes;
+		trie_steps += other.trie_steps;
+		prefix_rejections += other.prefix_rejections;
+		filter_rejections += other.filter_rejections;
+		terminal_hits += other.terminal_hits;
+		duplicate_hits += other.duplicate_hits;
+		add(square_nodes, other.square_nodes);
+		add(thread_seconds, other.thread_seconds);
+	}
+
+	/*
+	 * Count a step down the trie into the given node, or 0 if no word continues that way.
+	 */
+	void step(std::uint32_t node) {
+		++trie_steps;
+		prefix_rejections += node == 0;
+	}
+
+	/*
+	 * Note the node of the Q passed through on a step onto a QU square, which is not counted as a
+	 * step of its own.
+	 */
+	void pass(std::uint32_t) { }
+
+	/*
+	 * Count a step ruled out by the filter of the board.
+	 */
+	void filtered() {
+		++filter_rejections;
+	}
+
+	/*
+	 * Count a node expanded on a path starting at the given square.
+	 */
+	void expand(std::size_t start) {
+		++nodes;
+		++square_nodes[start];
+	}
+
+	/*
+	 * Count a path spelling out a word, which is new if 'first' is true.
+	 */
+	void hit(bool first) {
+		++terminal_hits;
+		duplicate_hits += not first;
+	}
+
+	/*
+	 * Add the given time to the time spent searching by the given thread.
+	 */
+	void busy(std::size_t thread, double seconds) {
+		if (thread_seconds.size() <= thread) {
+			thread_seconds.resize(thread + 1);
+		}
+		thread_seconds[thread] += seconds;
+	}
+
+private:
+	template <typename T>
+	static void add(std::vector<T>& to, const std::vector<T>& from) {
+		to.resize(std::max(to.size(), from.size()));
+		for (std::size_t i = 0; i < from.size(); ++i) {
+			to[i] += from[i];
+		}
+	}
+};
+
+/*
+ * The counters of a search that does not count anything.
+ */
+struct NoSearchStats {
+	static constexpr bool enabled = false;
+
+	void reset(std::size_t) { }
+
+	void merge(const NoSearchStats&) { }
+
+	void step(std::uint32_t) { }
+
+	void pass(std::uint32_t) { }
+
+	void filtered() { }
+
+	void expand(std::size_t) { }
+
+	void hit(bool) { }
+
+	void busy(std::size_t, double) { }
+};
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "boggle.hpp"
+#include "trie.hpp"
+
+/*
+ * A bounded cache of the words of N by M Boggle boards, in front of Boggle<N, M>::solve.
+ *
+ * Rotating or reflecting a board does not change its words, so boards are cached under their
+ * canonical form, the lexicographically smallest of the boards they can be turned into: the eight
+ * rotations and reflections of a square board, or the four that keep the shape of a rectangular
+ * one. A board seen before in any orientation is a hit. The cache is split into shards, each a
+ * least recently used list and a hash map under its own mutex, and a board goes to the shard chosen
+ * by the hash of its canonical form, so threads looking up different boards rarely wait for each
+ * other. A hit costs the canonical form, one hash, and a lookup and a splice under the shard's
+ * lock, and the words are shared rather than copied. Each shard evicts its least recently used
+ * board once it is full.
+ *
+ * The cache belongs to one dictionary, which must not change while the cache is in use; clear the
+ * cache after replacing the dictionary.
+ */
+template <std::size_t N = 4, std::size_t M = N>
+class SolveCache {
+public:
+	using words_t = std::shared_ptr<const std::vector<std::string>>; // The words of a board.
+
+	/*
+	 * Create an empty cache of the words of at most about 'capacity' boards, found in the given
+	 * dictionary, split into the given number of shards. Each shard holds at least one board.
+	 */
+	explicit SolveCache(std::size_t capacity, const Trie& dictionary = Boggle<N, M>::dictionary(),
+	                    std::size_t n_shards = 16);
+
+	// Delete copy constructor and copy assignment.
+	SolveCache(const SolveCache&) = delete;
+
+	SolveCache& operator=(const SolveCache&) = delete;
+
+	/*
+	 * Return the words of the given board, from the cache if it holds the board or any rotation or
+	 * reflection of it, and otherwise solving it with Boggle<N, M>::solve and caching the words.
+	 * Thread safe.
+	 */
+	words_t solve(const Boggle<N, M>& boggle);
+
+	/*
+	 * Return the words cached for the given board or any rotation or reflection of it, or null if
+	 * there are none. Counts as a hit or a miss. Thread safe.
+	 */
+	words_t find(const Boggle<N, M>& boggle);
+
+	/*
+	 * Return the number of lookups that found the board in the cache.
+	 */
+	std::uint64_t hits() const;
+
+	/*
+	 * Return the number of lookups that did not find the board in the cache.
+	 */
+	std::uint64_t misses() const;
+
+	/*
+	 * Return the number of boards in the cache.
+	 */
+	std::size_t size() const;
+
+	/*
+	 * Remove every board from the cache and reset the counters.
+	 */
+	void clear();
+
+	/*
+	 * Return the canonical form of the given board: the letters, in row-major order, of the
+	 * lexicographically smallest of its rotations and reflections that have its shape.
+	 */
+	static std::string canonical(const Boggle<N, M>& boggle);
+
+private:
+	struct shard_t {
+		using entry_t = std::pair<std::string, words_t>; // A canonical board and its words.
+
+		mutable std::mutex lock; // Guards the rest of the shard.
+		std::list<entry_t> entries; // The boards of the shard, most recently used first.
+		std::unordered_map<std::string, typename std::list<entry_t>::iterator> index; // The entry
+		// of each board in 'entries'.
+		std::uint64_t hits = 0; // The number of lookups of the shard that were hits.
+		std::uint64_t misses = 0; // The number of lookups of the shard that were misses.
+	};
+
+	const Trie& dictionary_; // The dictionary the words are found in.
+	std::size_t shard_capacity_; // The number of boards each shard holds at most.
+	std::vector<shard_t> shards_;
+
+	using transforms_t = std::array<std::array<std::size_t, N * M>, 8>; // For each rotation and
+	// reflection, the square of the board that each square of the transformed board comes from.
+
+	/*
+	 * Return the rotations and reflections of the board, the last four of which only exist for
+	 * square boards.
+	 */
+	static transforms_t make_transforms();
+
+	/*
+	 * Look up the given canonical board in the given shard, counting a hit or a miss, and return
+	 * its words or null.
+	 */
+	static words_t lookup(shard_t& shard, const std::string& key);
+
+	/*
+	 * Return the shard holding the given canonical board.
+	 */
+	shard_t& shard(const std::string& key);
+};
+
+template <std::size_t N, std::size_t M>
+SolveCache<N, M>::SolveCache(std::size_t capacity, const Trie& dictionary, std::size_t n_shards) :
+		dictionary_(dictionary),
+		shard_capacity_(),
+		shards_(std::max<std::size_t>(n_shards, 1)) {
+	shard_capacity_ = std::max<std::size_t>((capacity + shards_.size() - 1) / shards_.size(), 1);
+}
+
+template <std::size_t N, std::size_t M>
+typename SolveCache<N, M>::words_t SolveCache<N, M>::solve(const Boggle<N, M>& boggle) {
+	std::string key = canonical(boggle);
+	shard_t& s = shard(key);
+	if (auto words = lookup(s, key)) {
+		return words;
+	}
+
+	// Solve without holding the lock. Threads that miss on the same board at the same time each
+	// solve it, and the first to finish caches the words.
+	auto words = std::make_shared<const std::vector<std::string>>(boggle.solve(dictionary_));
+	std::lock_guard<std::mutex> guard(s.lock);
+	auto it = s.index.find(key);
+	if (it != s.index.end()) {
+		return it->second->second;
+	}
+	if (s.entries.size() == shard_capacity_) {
+		s.index.erase(s.entries.back().first);
+		s.entries.pop_back();
+	}
+	s.entries.emplace_front(key, words);
+	s.index.emplace(std::move(key), s.entries.begin());
+	return words;
+}
+
+template <std::size_t N, std::size_t M>
+typename SolveCache<N, M>::words_t SolveCache<N, M>::find(const Boggle<N, M>& boggle) {
+	std::string key = canonical(boggle);
+	return lookup(shard(key), key);
+}
+
+template <std::size_t N, std::size_t M>
+std::uint64_t SolveCache<N, M>::hits() const {
+	std::uint64_t hits = 0;
+	for (const auto& s : shards_) {
+		std::lock_guard<std::mutex> guard(s.lock);
+		hits += s.hits;
+	}
+	return hits;
+}
+
+template <std::size_t N, std::size_t M>
+std::uint64_t SolveCache<N, M>::misses() const {
+	std::uint64_t misses = 0;
+	for (const auto& s : shards_) {
+		std::lock_guard<std::mutex> guard(s.lock);
+		misses += s.misses;
+	}
+	return misses;
+}
+
+template <std::size_t N, std::size_t M>
+std::size_t SolveCache<N, M>::size() const {
+	std::size_t size = 0;
+	for (const auto& s : shards_) {
+		std::lock_guard<std::mutex> guard(s.lock);
+		size += s.entries.size();
+	}
+	return size;
+}
+
+template <std::size_t N, std::size_t M>
+void SolveCache<N, M>::clear() {
+	for (auto& s : shards_) {
+		std::lock_guard<std::mutex> guard(s.lock);
+		s.entries.clear();
+		s.index.clear();
+		s.hits = 0;
+		s.misses = 0;
+	}
+}
+
+template <std::size_t N, std::size_t M>
+std::string SolveCache<N, M>::canonical(const Boggle<N, M>& boggle) {
+	// Only the transform giving the smallest board is written out. The others are compared with it
+	// square by square, which almost always stops at the first square.
+	static const auto transforms = make_transforms();
+	const char *letters = boggle[0];
+	std::size_t best = 0;
+	for (std::size_t t = 1; t < (N == M ? 8 : 4); ++t) {
+		std::size_t i = 0;
+		while (i < N * M and letters[transforms[t][i]] == letters[transforms[best][i]]) {
+			++i;
+		}
+		if (i < N * M and letters[transforms[t][i]] < letters[transforms[best][i]]) {
+			best = t;
+		}
+	}
+
+	std::string smallest(N * M, '\0');
+	for (std::size_t i = 0; i < N * M; ++i) {
+		smallest[i] = letters[transforms[best][i]];
+	}
+	return smallest;
+}
+
+template <std::size_t N, std::size_t M>
+typename SolveCache<N, M>::transforms_t SolveCache<N, M>::make_transforms() {
+	transforms_t transforms{};
+	for (std::size_t row = 0; row < N; ++row) {
+		for (std::size_t col = 0; col < M; ++col) {
+			std::size_t i = row * M + col;
+			transforms[0][i] = i;
+			transforms[1][i] = row * M + (M - 1 - col);
+			transforms[2][i] = (N - 1 - row) * M + col;
+			transforms[3][i] = (N - 1 - row) * M + (M - 1 - col);
+			if (N == M) {
+				transforms[4][i] = col * M + row;
+				transforms[5][i] = col * M + (M - 1 - row);
+				transforms[6][i] = (N - 1 - col) * M + row;
+				transforms[7][i] = (N - 1 - col) * M + (M - 1 - row);
+			}
+		}
+	}
+	return transforms;
+}
+
+template <std::size_t N, std::size_t M>
+typename SolveCache<N, M>::words_t SolveCache<N, M>::lookup(shard_t& shard,
+                                                            const std::string& key) {
+	std::lock_guard<std::mutex> guard(shard.lock);
+	auto it = shard.index.find(key);
+	if (it == shard.index.end()) {
+		++shard.misses;
+		return nullptr;
+	}
+	++shard.hits;
+	shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+	return it->second->second;
+}
+
+template <std::size_t N, std::size_t M>
+typename SolveCache<N, M>::shard_t& SolveCache<N, M>::shard(const std::string& key) {
+	return shards_[std::hash<std::string>()(key) % shards_.size()];
+}
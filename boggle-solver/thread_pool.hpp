@@ -0,0 +1,246 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+
+/*
+ * A fixed set of long-lived threads that run jobs in parallel with the calling thread.
+ *
+ * A job is a callable run once on every thread of the pool with the index of the thread, the
+ * calling thread taking index 0 and the n - 1 threads of the pool the rest. Between jobs the
+ * threads spin briefly and then sleep on a condition variable, so dispatching a job costs a wake-up
+ * rather than creating and joining threads. Jobs are passed by reference and never copied, so
+ * dispatching does not allocate.
+ *
+ * Threads can optionally be pinned to CPUs, thread i to CPU i modulo the number of CPUs. The
+ * calling thread is never pinned.
+ */
+class ThreadPool {
+public:
+	/*
+	 * Create a pool of the given number of threads, which includes the thread calling run, so a
+	 * pool of size 1 runs jobs on the calling thread alone. A size of 0 is treated as 1.
+	 */
+	explicit ThreadPool(std::size_t n_threads = default_size(), bool pin = false);
+
+	/*
+	 * Stop and join the threads of the pool. Must not be called while a job is running.
+	 */
+	~ThreadPool();
+
+	// Delete copy constructor and copy assignment.
+	ThreadPool(const ThreadPool&) = delete;
+
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/*
+	 * Return the number of threads that run a job, including the calling thread.
+	 */
+	std::size_t size() const;
+
+	/*
+	 * Return true if the threads of the pool are pinned to CPUs.
+	 */
+	bool pinned() const;
+
+	/*
+	 * Call job(i) for every i in [0, size()), each on a different thread, and return once every
+	 * call has returned. If any call throws, one of the exceptions is rethrown once every call has
+	 * finished. Jobs submitted from different threads run one after another.
+	 */
+	template <typename F>
+	void run(F& job);
+
+	/*
+	 * Return the number of threads a pool has by default: the number of hardware threads, or 1 if
+	 * that is unknown.
+	 */
+	static std::size_t default_size();
+
+	/*
+	 * Return the process-wide pool, which is created with the default size on first use.
+	 */
+	static ThreadPool& global();
+
+	/*
+	 * Replace the process-wide pool with one of the given size and pinning. Must not be called
+	 * while the process-wide pool is running a job.
+	 */
+	static void reset_global(std::size_t n_threads, bool pin = false);
+
+private:
+	std::vector<std::thread> threads_; // Threads 1 to n - 1 of the pool.
+	bool pinned_;
+
+	std::mutex run_lock_; // Serializes calls to run.
+	std::mutex lock_; // Protects the condition variables below.
+	std::condition_variable start_; // Signalled when a job is published or the pool stops.
+	std::condition_variable done_; // Signalled when the last thread finishes a job.
+
+	std::atomic<std::uint64_t> generation_; // Incremented each time a job is published.
+	std::atomic<std::size_t> pending_; // Threads of the pool still running the current job.
+	std::atomic<bool> stop_;
+
+	void (*invoke_)(void *, std::size_t); // Calls the current job with a thread index.
+	void *job_; // The current job.
+	std::exception_ptr error_; // The first exception thrown by the current job.
+
+	/*
+	 * Body of the ith thread of the pool.
+	 */
+	void work(std::size_t i);
+
+	/*
+	 * Run the current job on the ith thread, recording an exception if it throws.
+	 */
+	void run_job(std::size_t i);
+
+	static std::unique_ptr<ThreadPool>& global_instance();
+};
+
+inline ThreadPool::ThreadPool(std::size_t n_threads, bool pin) :
+		threads_(),
+		pinned_(pin),
+		generation_(0),
+		pending_(0),
+		stop_(false),
+		invoke_(nullptr),
+		job_(nullptr),
+		error_() {
+	n_threads = std::max<std::size_t>(n_threads, 1);
+	threads_.reserve(n_threads - 1);
+	for (std::size_t i = 1; i < n_threads; ++i) {
+		threads_.emplace_back(&ThreadPool::work, this, i);
+		if (pin) {
+			cpu_set_t cpus;
+			CPU_ZERO(&cpus);
+			CPU_SET(i % std::max<std::size_t>(std::thread::hardware_concurrency(), 1), &cpus);
+			pthread_setaffinity_np(threads_.back().native_handle(), sizeof(cpus), &cpus);
+		}
+	}
+}
+
+inline ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		stop_.store(true);
+	}
+	start_.notify_all();
+	for (auto& thread : threads_) {
+		thread.join();
+	}
+}
+
+inline std::size_t ThreadPool::size() const {
+	return threads_.size() + 1;
+}
+
+inline bool ThreadPool::pinned() const {
+	return pinned_;
+}
+
+template <typename F>
+void ThreadPool::run(F& job) {
+	std::lock_guard<std::mutex> run_guard(run_lock_);
+
+	if (not threads_.empty()) {
+		std::lock_guard<std::mutex> guard(lock_);
+		invoke_ = [](void *p, std::size_t i) {
+			(*static_cast<F *>(p))(i);
+		};
+		job_ = &job;
+		error_ = nullptr;
+		pending_.store(threads_.size());
+		generation_.fetch_add(1);
+	}
+	start_.notify_all();
+
+	std::exception_ptr error;
+	try {
+		job(std::size_t{0});
+	} catch (...) {
+		error = std::current_exception();
+	}
+
+	if (not threads_.empty()) {
+		std::unique_lock<std::mutex> guard(lock_);
+		done_.wait(guard, [this] {
+			return pending_.load() == 0;
+		});
+		if (not error) {
+			error = error_;
+		}
+	}
+
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+inline std::size_t ThreadPool::default_size() {
+	return std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+inline ThreadPool& ThreadPool::global() {
+	auto& instance = global_instance();
+	return *instance;
+}
+
+inline void ThreadPool::reset_global(std::size_t n_threads, bool pin) {
+	auto& instance = global_instance();
+	instance.reset();
+	instance = std::make_unique<ThreadPool>(n_threads, pin);
+}
+
+inline void ThreadPool::work(std::size_t i) {
+	std::uint64_t seen = 0;
+	while (true) {
+		// Spin for a short while before sleeping, since jobs often arrive back to back.
+		for (int spin = 0; spin < 256 and generation_.load() == seen and not stop_.load(); ++spin) {
+			std::this_thread::yield();
+		}
+
+		{
+			std::unique_lock<std::mutex> guard(lock_);
+			start_.wait(guard, [this, seen] {
+				return generation_.load() != seen or stop_.load();
+			});
+		}
+		if (stop_.load()) {
+			return;
+		}
+		seen = generation_.load();
+
+		run_job(i);
+
+		if (pending_.fetch_sub(1) == 1) {
+			std::lock_guard<std::mutex> guard(lock_);
+			done_.notify_one();
+		}
+	}
+}
+
+inline void ThreadPool::run_job(std::size_t i) {
+	try {
+		invoke_(job_, i);
+	} catch (...) {
+		std::lock_guard<std::mutex> guard(lock_);
+		if (not error_) {
+			error_ = std::current_exception();
+		}
+	}
+}
+
+inline std::unique_ptr<ThreadPool>& ThreadPool::global_instance() {
+	static std::unique_ptr<ThreadPool> instance = std::make_unique<ThreadPool>();
+	return instance;
+}
@@ -0,0 +1,452 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "histogram.hpp"
+
+/*
+ * A ring buffer of the spans recorded by one thread, read by one other thread at a time.
+ *
+ * Pushing a span is a handful of relaxed stores and a release store of the head, with no lock and
+ * no write to memory shared with other writers. The reader copies out the spans pushed since it
+ * last read and then checks the head again, like the reader of a seqlock: spans the writer may
+ * have overwritten while they were copied, and spans overwritten before the reader got to them
+ * because the ring filled up, are dropped and counted.
+ */
+class SpanRing {
+public:
+	/*
+	 * A span of time: its name, its start and its duration, in nanoseconds.
+	 */
+	struct span_t {
+		std::uint32_t name;
+		std::uint64_t start;
+		std::uint64_t duration;
+	};
+
+	/*
+	 * Create a ring holding the given number of spans, which must be a power of two.
+	 */
+	explicit SpanRing(std::size_t capacity) :
+			slots_(new slot_t[capacity]),
+			mask_(capacity - 1),
+			head_(0),
+			tail_(0),
+			retired_(false),
+			copy_() { }
+
+	// Delete copy constructor and copy assignment.
+	SpanRing(const SpanRing&) = delete;
+
+	SpanRing& operator=(const SpanRing&) = delete;
+
+	/*
+	 * Push a span. Must only be called by the thread owning the ring.
+	 */
+	void push(std::uint32_t name, std::uint64_t start, std::uint64_t duration) {
+		std::uint64_t head = head_.load(std::memory_order_relaxed);
+		slot_t& slot = slots_[head & mask_];
+		slot.name.store(name, std::memory_order_relaxed);
+		slot.start.store(start, std::memory_order_relaxed);
+		slot.duration.store(duration, std::memory_order_relaxed);
+		head_.store(head + 1, std::memory_order_release);
+	}
+
+	/*
+	 * Pass the spans pushed since the last call to the given function, oldest first, and return
+	 * the number of spans lost since then. Must not be called by two threads at once.
+	 */
+	template <typename F>
+	std::uint64_t drain(F f) {
+		std::uint64_t capacity = mask_ + 1;
+		std::uint64_t head = head_.load(std::memory_order_acquire);
+		std::uint64_t first = std::max(tail_, head > capacity ? head - capacity : 0);
+		copy_.clear();
+		for (std::uint64_t i = first; i < head; ++i) {
+			const slot_t& slot = slots_[i & mask_];
+			copy_.push_back(span_t{slot.name.load(std::memory_order_relaxed),
+			                       slot.start.load(std::memory_order_relaxed),
+			                       slot.duration.load(std::memory_order_relaxed)});
+		}
+
+		// The writer may have started overwriting any slot it has come back around to since.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		std::uint64_t now = head_.load(std::memory_order_relaxed);
+		std::uint64_t valid = std::max(first, now >= capacity ? now - capacity + 1 : 0);
+		for (std::uint64_t i = std::min(valid, head); i < head; ++i) {
+			f(copy_[i - first]);
+		}
+		std::uint64_t lost = std::min(valid, head) - tail_;
+		tail_ = head;
+		return lost;
+	}
+
+	/*
+	 * Mark that the thread owning the ring has exited and will push no more spans.
+	 */
+	void retire() {
+		retired_.store(true, std::memory_order_release);
+	}
+
+	/*
+	 * Return true if the thread owning the ring has exited, in which case every span it pushed is
+	 * visible to the calling thread.
+	 */
+	bool retired() const {
+		return retired_.load(std::memory_order_acquire);
+	}
+
+	/*
+	 * Mark the ring as owned again, by the thread it is about to be handed to.
+	 */
+	void revive() {
+		retired_.store(false, std::memory_order_relaxed);
+	}
+
+private:
+	struct slot_t {
+		std::atomic<std::uint32_t> name;
+		std::atomic<std::uint64_t> start;
+		std::atomic<std::uint64_t> duration;
+	};
+
+	std::unique_ptr<slot_t[]> slots_; // The spans, the ith pushed in slot i & mask_.
+	std::uint64_t mask_; // The capacity of the ring less one.
+	std::atomic<std::uint64_t> head_; // The number of spans pushed.
+	std::uint64_t tail_; // The number of spans pushed when the ring was last drained.
+	std::atomic<bool> retired_; // Whether the thread owning the ring has exited.
+	std::vector<span_t> copy_; // The spans copied out of the ring while draining it.
+};
+
+/*
+ * Records named spans of time from any thread of the process, for the native solver and the
+ * Python bot alike, and turns them into a latency histogram for each name and a trace in the
+ * Chrome trace event format, which chrome://tracing and Perfetto display as a timeline with a
+ * track per thread.
+ *
+ * Tracing is off until enabled, and a TraceSpan then costs one relaxed load. Once it is on, each
+ * thread pushes its spans to a SpanRing of its own, so recording never takes a lock or contends
+ * with another thread. Spans stay in the rings until 'flush' drains them into the histograms and,
+ * if a trace file is open, appends them to it; a thread recording more than a ring's worth of spans
+ * between flushes loses the oldest, which 'dropped' counts. A ring takes about 400 KB, and once its
+ * thread has exited and it has been flushed it is handed to the next thread to record a span, so
+ * the rings hold as many as the threads that recorded spans at the same time rather than every
+ * thread ever started; a thread given a ring takes over its thread number in the trace. Times are
+ * read from std::chrono::steady_clock, which is CLOCK_MONOTONIC on Linux, and names are interned to
+ * integers once, so a span only stores three integers.
+ */
+class Tracer {
+public:
+	static constexpr std::size_t ring_capacity = 1 << 14; // The spans each thread's ring holds.
+
+	// Delete copy constructor and copy assignment.
+	Tracer(const Tracer&) = delete;
+
+	Tracer& operator=(const Tracer&) = delete;
+
+	~Tracer() {
+		close();
+	}
+
+	/*
+	 * Return the tracer of the process.
+	 */
+	static Tracer& global() {
+		static Tracer tracer;
+		return tracer;
+	}
+
+	/*
+	 * Return the current time in nanoseconds, on the clock spans are timed with.
+	 */
+	static std::uint64_t now() {
+		return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	/*
+	 * Turn recording spans on or off.
+	 */
+	void enable(bool on) {
+		enabled_.store(on, std::memory_order_relaxed);
+	}
+
+	/*
+	 * Return true if spans are being recorded.
+	 */
+	bool enabled() const {
+		return enabled_.load(std::memory_order_relaxed);
+	}
+
+	/*
+	 * Return the ID of the given span name, the same every time for the same name.
+	 */
+	std::uint32_t name(const std::string& name) {
+		std::lock_guard<std::mutex> guard(lock_);
+		auto it = ids_.find(name);
+		if (it != ids_.end()) {
+			return it->second;
+		}
+		auto id = static_cast<std::uint32_t>(names_.size());
+		names_.push_back(name);
+		histograms_.emplace_back();
+		ids_.emplace(name, id);
+		return id;
+	}
+
+	/*
+	 * Record a span of the name with the given ID from the given start to the given end, as
+	 * returned by 'now', on the calling thread, whether or not tracing is enabled.
+	 */
+	void record(std::uint32_t name, std::uint64_t start, std::uint64_t end) {
+		thread_ring().push(name, start, end > start ? end - start : 0);
+	}
+
+	/*
+	 * Start writing the trace to the given file, replacing it, starting with the spans recorded
+	 * since the last flush. Any trace file already open is closed first. Throws
+	 * std::runtime_error if the file cannot be written.
+	 */
+	void open(const std::string& path) {
+		std::lock_guard<std::mutex> guard(lock_);
+		close_file();
+		file_ = std::fopen(path.c_str(), "w+");
+		if (file_ == nullptr) {
+			throw std::runtime_error("cannot write trace file " + path);
+		}
+		std::fputs("[\n]\n", file_);
+		std::fflush(file_);
+		n_written_ = 0;
+	}
+
+	/*
+	 * Drain the spans recorded by every thread into the histograms and the trace file, if one is
+	 * open. The file holds a complete JSON array of trace events after every flush.
+	 */
+	void flush() {
+		std::lock_guard<std::mutex> guard(lock_);
+		flush_rings();
+	}
+
+	/*
+	 * Flush, then finish and close the trace file, if one is open.
+	 */
+	void close() {
+		std::lock_guard<std::mutex> guard(lock_);
+		flush_rings();
+		close_file();
+	}
+
+	/*
+	 * Flush, then return the name and histogram of the durations of every name with spans
+	 * recorded, in the order the names were first seen.
+	 */
+	std::vector<std::pair<std::string, LatencyHistogram>> histograms() {
+		std::lock_guard<std::mutex> guard(lock_);
+		flush_rings();
+		std::vector<std::pair<std::string, LatencyHistogram>> histograms;
+		for (std::size_t i = 0; i < names_.size(); ++i) {
+			if (histograms_[i].count() != 0) {
+				histograms.emplace_back(names_[i], histograms_[i]);
+			}
+		}
+		return histograms;
+	}
+
+	/*
+	 * Return the number of spans lost because a ring filled up before it was flushed.
+	 */
+	std::uint64_t dropped() {
+		std::lock_guard<std::mutex> guard(lock_);
+		return dropped_;
+	}
+
+	/*
+	 * Discard the spans recorded so far, the histograms and the count of dropped spans. The trace
+	 * file, if one is open, is kept.
+	 */
+	void reset() {
+		std::lock_guard<std::mutex> guard(lock_);
+		for (std::size_t thread = 0; thread < rings_.size(); ++thread) {
+			drain_ring(thread, [](const SpanRing::span_t&) { });
+		}
+		for (auto& histogram : histograms_) {
+			histogram = LatencyHistogram();
+		}
+		dropped_ = 0;
+	}
+
+private:
+	std::atomic<bool> enabled_; // Whether spans are recorded.
+	std::mutex lock_; // Guards everything below.
+	std::deque<std::string> names_; // The span names, by ID.
+	std::unordered_map<std::string, std::uint32_t> ids_; // The ID of each span name.
+	std::vector<LatencyHistogram> histograms_; // The durations flushed, by name ID.
+	std::vector<std::shared_ptr<SpanRing>> rings_; // The ring of each thread, by thread number.
+	std::vector<std::size_t> idle_; // The numbers of the drained rings whose thread has exited.
+	std::uint64_t dropped_; // The number of spans lost.
+	std::FILE *file_; // The trace file, or nullptr.
+	std::uint64_t n_written_; // The number of events in the trace file.
+
+	Tracer() :
+			enabled_(false),
+			lock_(),
+			names_(),
+			ids_(),
+			histograms_(),
+			rings_(),
+			idle_(),
+			dropped_(0),
+			file_(nullptr),
+			n_written_(0) { }
+
+	/*
+	 * Holds the ring of a thread and retires it when the thread exits. The ring is shared with the
+	 * tracer, so it outlives whichever of the two goes first.
+	 */
+	struct ring_owner_t {
+		std::shared_ptr<SpanRing> ring;
+
+		~ring_owner_t() {
+			if (ring != nullptr) {
+				ring->retire();
+			}
+		}
+	};
+
+	/*
+	 * Return the ring of the calling thread, taking an idle one or creating one on its first span.
+	 * The ring stays with the tracer after the thread exits, so its spans are still flushed.
+	 */
+	SpanRing& thread_ring() {
+		thread_local ring_owner_t owner;
+		if (owner.ring == nullptr) {
+			std::lock_guard<std::mutex> guard(lock_);
+			if (idle_.empty()) {
+				rings_.push_back(std::make_shared<SpanRing>(ring_capacity));
+				owner.ring = rings_.back();
+			} else {
+				owner.ring = rings_[idle_.back()];
+				idle_.pop_back();
+			}
+		}
+		return *owner.ring;
+	}
+
+	/*
+	 * Drain the ring with the given thread number, passing its spans to the given function, and
+	 * make it idle if its thread has exited. Return the number of spans lost. The lock must be
+	 * held.
+	 */
+	template <typename F>
+	std::uint64_t drain_ring(std::size_t thread, F f) {
+		SpanRing& ring = *rings_[thread];
+		bool retired = ring.retired();
+		std::uint64_t lost = ring.drain(f);
+		if (retired) {
+			ring.revive();
+			idle_.push_back(thread);
+		}
+		return lost;
+	}
+
+	/*
+	 * Drain every ring. The lock must be held.
+	 */
+	void flush_rings() {
+		if (file_ != nullptr) {
+			// Write over the end of the array, and end it again after the new events.
+			std::fseek(file_, n_written_ == 0 ? -2 : -3, SEEK_END);
+		}
+		for (std::size_t thread = 0; thread < rings_.size(); ++thread) {
+			dropped_ += drain_ring(thread, [&](const SpanRing::span_t& span) {
+				histograms_[span.name].add(span.duration);
+				if (file_ != nullptr) {
+					write_event(thread, span);
+				}
+			});
+		}
+		if (file_ != nullptr) {
+			std::fputs(n_written_ == 0 ? "]\n" : "\n]\n", file_);
+			std::fflush(file_);
+		}
+	}
+
+	/*
+	 * Append a complete event for the given span of the given thread to the trace file, with its
+	 * times in microseconds as the format wants.
+	 */
+	void write_event(std::size_t thread, const SpanRing::span_t& span) {
+		std::fputs(n_written_++ == 0 ? "" : ",\n", file_);
+		std::fputs("{\"name\":\"", file_);
+		for (char c : names_[span.name]) {
+			if (c == '"' or c == '\\') {
+				std::fputc('\\', file_);
+				std::fputc(c, file_);
+			} else if (static_cast<unsigned char>(c) < 0x20) {
+				std::fprintf(file_, "\\u%04x", static_cast<unsigned>(c));
+			} else {
+				std::fputc(c, file_);
+			}
+		}
+		std::fprintf(file_, "\",\"ph\":\"X\",\"pid\":%ld,\"tid\":%zu,\"ts\":%llu.%03llu,"
+		                    "\"dur\":%llu.%03llu}",
+		             static_cast<long>(getpid()), thread,
+		             static_cast<unsigned long long>(span.start / 1000),
+		             static_cast<unsigned long long>(span.start % 1000),
+		             static_cast<unsigned long long>(span.duration / 1000),
+		             static_cast<unsigned long long>(span.duration % 1000));
+	}
+
+	/*
+	 * Close the trace file, if one is open. The lock must be held.
+	 */
+	void close_file() {
+		if (file_ != nullptr) {
+			std::fclose(file_);
+			file_ = nullptr;
+		}
+	}
+};
+
+/*
+ * Records a span of the global tracer from its creation to its destruction, if tracing is enabled
+ * when it is created.
+ */
+class TraceSpan {
+public:
+	/*
+	 * Start a span of the name with the given ID, as returned by Tracer::name.
+	 */
+	explicit TraceSpan(std::uint32_t name) :
+			name_(name),
+			start_(Tracer::global().enabled() ? Tracer::now() : 0) { }
+
+	~TraceSpan() {
+		if (start_ != 0) {
+			Tracer::global().record(name_, start_, Tracer::now());
+		}
+	}
+
+	// Delete copy constructor and copy assignment.
+	TraceSpan(const TraceSpan&) = delete;
+
+	TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+	std::uint32_t name_; // The ID of the name of the span.
+	std::uint64_t start_; // The start of the span, or 0 if tracing was disabled.
+};
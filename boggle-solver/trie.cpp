@@ -1,61 +1,712 @@
 #include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <fstream>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include "thread_pool.hpp"
 #include "trie.hpp"
 
+namespace {
+/*
+ * Header of the binary file format written by Trie::save. The nodes follow immediately after it.
+ */
+struct FileHeader {
+	char magic[8]; // Always file_magic.
+	std::uint32_t version; // Trie::file_version of the writer.
+	std::uint32_t node_size; // sizeof(Trie::Node) of the writer.
+	std::uint32_t flags; // Bit 0 is set if the trie is minimized.
+	std::uint32_t n_words; // Number of strings in the trie.
+	std::uint64_t n_nodes; // Number of nodes in the file.
+	std::uint64_t checksum; // checksum() of the nodes.
+	std::uint64_t hot_nodes; // Trie::hot_nodes() of the trie.
+	char padding[16]; // Pads the header to a cache line, so the mapped nodes start one.
+};
+
+static_assert(sizeof(FileHeader) == 64, "the header of a trie file must fill a cache line");
+
+constexpr char file_magic[8] = {'B', 'O', 'G', 'G', 'L', 'E', 'T', 'R'};
+constexpr std::uint32_t minimized_flag = 1;
+
+/*
+ * Return the number of children of a node with the given mask.
+ */
+std::size_t n_children(std::uint32_t mask) {
+	return static_cast<std::size_t>(__builtin_popcount(mask & ~Trie::terminal_bit));
+}
+
+/*
+ * The subtrie of the strings with a given first letter, built by Trie::build in an arena of its
+ * own, breadth first.
+ */
+struct subtrie_t {
+	std::vector<Trie::Node> nodes; // nodes[0] is the node of the first letter. The children of a
+	// node are indexed within 'nodes'.
+	std::vector<std::uint32_t> counts; // counts[i] is the number of strings in the subtrie of
+	// nodes[i].
+	std::vector<std::size_t> levels; // The nodes at depth d below nodes[0] are those from
+	// levels[d] up to levels[d + 1]. The last entry is the number of nodes.
+};
+
+/*
+ * Return the subtrie of the strings from 'begin' up to 'end', which all have the same first
+ * letter. Throws std::invalid_argument if the strings are not sorted and distinct or hold anything
+ * but uppercase ASCII letters.
+ */
+subtrie_t build_subtrie(const char *const *strings, std::uint32_t begin, std::uint32_t end) {
+	for (std::uint32_t i = begin + 1; i < end; ++i) {
+		if (std::strcmp(strings[i - 1], strings[i]) >= 0) {
+			throw std::invalid_argument("strings are not sorted and distinct");
+		}
+	}
+
+	// Every node stands for the range of strings that start with its prefix. In that range the
+	// string ending at the node, if any, comes first, and the others fall into the ranges of the
+	// children wherever the letter after the prefix changes. The nodes of a depth are split in
+	// order once all of them have been created, appending their blocks of children, which makes up
+	// the next depth, so every letter of every string is read once and the arena comes out in the
+	// breadth-first order of shrink_to_fit. 'ranges' is indexed like the nodes.
+	subtrie_t subtrie;
+	auto& nodes = subtrie.nodes;
+	auto& counts = subtrie.counts;
+	std::vector<std::pair<std::uint32_t, std::uint32_t>> ranges;
+	nodes.push_back(Trie::Node{0, 0, 0});
+	counts.push_back(end - begin);
+	ranges.emplace_back(begin, end);
+	subtrie.levels.push_back(0);
+	for (std::size_t depth = 1; subtrie.levels.back() != nodes.size(); ++depth) {
+		std::size_t level_end = nodes.size();
+		for (std::size_t i = subtrie.levels.back(); i < level_end; ++i) {
+			std::uint32_t lo = ranges[i].first;
+			std::uint32_t hi = ranges[i].second;
+			std::uint32_t mask = 0;
+			if (strings[lo][depth] == '\0') {
+				mask = Trie::terminal_bit;
+				++lo;
+			}
+			auto first = static_cast<Trie::node_t>(nodes.size());
+			std::uint32_t offset = 0;
+			while (lo < hi) {
+				char c = strings[lo][depth];
+				if (c < 'A' or c > 'Z') {
+					throw std::invalid_argument(std::string("invalid character '") + c + "'");
+				}
+				std::uint32_t next = lo + 1;
+				while (next < hi and strings[next][depth] == c) {
+					++next;
+				}
+				mask |= std::uint32_t{1} << (c - 'A');
+				nodes.push_back(Trie::Node{0, 0, offset});
+				counts.push_back(next - lo);
+				ranges.emplace_back(lo, next);
+				offset += next - lo;
+				lo = next;
+			}
+			nodes[i].mask = mask;
+			nodes[i].first_child = nodes.size() == first ? 0 : first;
+		}
+		subtrie.levels.push_back(level_end);
+	}
+	return subtrie;
+}
+
+/*
+ * Return the 64-bit FNV-1a hash of the given nodes, taken over their 32-bit fields rather than
+ * byte by byte.
+ */
+std::uint64_t checksum(const Trie::Node *nodes, std::size_t n_nodes) {
+	std::uint64_t hash = 0xcbf29ce484222325;
+	for (std::size_t i = 0; i < n_nodes; ++i) {
+		hash = (hash ^ nodes[i].mask) * 0x100000001b3;
+		hash = (hash ^ nodes[i].first_child) * 0x100000001b3;
+		hash = (hash ^ nodes[i].offset) * 0x100000001b3;
+	}
+	return hash;
+}
+}
+
+constexpr std::uint32_t Trie::terminal_bit;
+constexpr std::uint32_t Trie::file_version;
+
 Trie::Trie() :
-		children_() { }
+		nodes_(1, Node{0, 0, 0}),
+		data_(nodes_.data()),
+		size_(nodes_.size()),
+		mapping_(),
+		counts_(1, 0),
+		n_words_(0),
+		minimized_(false),
+		hot_nodes_(0) { }
 
 Trie::Trie(Trie&& other) :
-		children_(std::move(other.children_)) { }
+		nodes_(std::move(other.nodes_)),
+		data_(other.data_),
+		size_(other.size_),
+		mapping_(std::move(other.mapping_)),
+		counts_(std::move(other.counts_)),
+		n_words_(other.n_words_),
+		minimized_(other.minimized_),
+		hot_nodes_(other.hot_nodes_) {
+	other.nodes_.assign(1, Node{0, 0, 0});
+	other.reset_view();
+	other.counts_.assign(1, 0);
+	other.n_words_ = 0;
+	other.minimized_ = false;
+	other.hot_nodes_ = 0;
+}
 
 Trie& Trie::operator=(Trie&& other) {
-	children_ = std::move(other.children_);
+	nodes_ = std::move(other.nodes_);
+	data_ = other.data_;
+	size_ = other.size_;
+	mapping_ = std::move(other.mapping_);
+	counts_ = std::move(other.counts_);
+	n_words_ = other.n_words_;
+	minimized_ = other.minimized_;
+	hot_nodes_ = other.hot_nodes_;
+	other.nodes_.assign(1, Node{0, 0, 0});
+	other.reset_view();
+	other.counts_.assign(1, 0);
+	other.n_words_ = 0;
+	other.minimized_ = false;
+	other.hot_nodes_ = 0;
 	return *this;
 }
 
 bool Trie::empty() const {
-	return std::all_of(children_.begin(), children_.end(), [](const auto& p) {
-		return p == nullptr;
-	});
+	return data_[0].mask == 0;
 }
 
 bool Trie::has_string(const char *s) const {
-	const Trie *p_trie = this;
-	for (unsigned int i = 0; i < std::strlen(s); ++i) {
-		std::size_t child_index = static_cast<std::size_t>(s[i] - 'A');
-		if (not p_trie->children_[child_index]) {
+	node_t node = 0;
+	for (; *s != '\0'; ++s) {
+		node = child(node, *s);
+		if (node == 0) {
 			return false;
 		}
-		p_trie = p_trie->children_[child_index].get();
 	}
-
-	// Check null character.
-	return p_trie->children_.back() != nullptr;
+	return terminal(node);
 }
 
 bool Trie::has_prefix(const char *prefix) const {
-	const Trie *p_trie = this;
-	for (unsigned int i = 0; i < std::strlen(prefix); ++i) {
-		std::size_t child_index = static_cast<std::size_t>(prefix[i] - 'A');
-		if (not p_trie->children_[child_index]) {
+	node_t node = 0;
+	for (; *prefix != '\0'; ++prefix) {
+		node = child(node, *prefix);
+		if (node == 0) {
 			return false;
 		}
-		p_trie = p_trie->children_[child_index].get();
 	}
 	return true;
 }
 
 void Trie::insert(const char *s) {
-	Trie *p_trie = this;
-	for (unsigned int i = 0; i < std::strlen(s); ++i) {
-		std::size_t child_index = static_cast<std::size_t>(s[i] - 'A');
-		if (not p_trie->children_[child_index]) {
-			p_trie->children_[child_index] = std::make_unique<Trie>();
+	if (minimized_) {
+		throw std::logic_error("cannot insert into a minimized trie");
+	}
+	if (mapping_) {
+		throw std::logic_error("cannot insert into a trie mapped from a file");
+	}
+
+	node_t node = 0;
+	for (const char *p = s; *p != '\0'; ++p) {
+		auto letter = static_cast<std::uint32_t>(*p - 'A');
+		if ((nodes_[node].mask & (std::uint32_t{1} << letter)) == 0) {
+			add_child(node, letter);
 		}
-		p_trie = p_trie->children_[child_index].get();
+		node = child(node, *p);
 	}
+	if (terminal(node)) {
+		return;
+	}
+	nodes_[node].mask |= terminal_bit;
+	++n_words_;
 
-	// Add null character.
-	p_trie->children_.back() = std::make_unique<Trie>();
+	// Walk the path again now that it exists, counting the new string in the subtrie of every node
+	// on it and shifting the IDs of the strings in the subtries of the later siblings.
+	node = 0;
+	for (const char *p = s; ; ++p) {
+		++counts_[node];
+		if (*p == '\0') {
+			break;
+		}
+		node_t next = child(node, *p);
+		node_t end = nodes_[node].first_child + static_cast<node_t>(n_children(nodes_[node].mask));
+		for (node_t sibling = next + 1; sibling < end; ++sibling) {
+			++nodes_[sibling].offset;
+		}
+		node = next;
+	}
+}
+
+Trie Trie::build(const char *const *strings, std::size_t n, ThreadPool& pool) {
+	if (n > std::numeric_limits<std::uint32_t>::max()) {
+		throw std::invalid_argument("too many strings for 32-bit IDs");
+	}
+
+	// The strings are split by first letter, and the subtrie of each letter is built on its own.
+	// In breadth-first order the nodes at each depth are the nodes at that depth of the subtries
+	// of the letters, one after another in alphabetical order, so each subtrie is copied into the
+	// arena a depth at a time, the children of its nodes shifted to where the next depth of the
+	// subtrie lands. 'shifts[i][d]' is where the nodes at depth d of subtrie i land in the arena,
+	// less where they are in the subtrie.
+	Trie trie;
+	std::uint32_t begin = 0;
+	if (n != 0 and strings[0][0] == '\0') {
+		trie.nodes_[0].mask = terminal_bit;
+		begin = 1;
+	}
+	std::vector<std::pair<std::uint32_t, std::uint32_t>> parts;
+	for (auto i = begin; i < n; ) {
+		char c = strings[i][0];
+		if (c < 'A' or c > 'Z') {
+			throw std::invalid_argument(std::string("invalid character '") + c + "'");
+		}
+		if (not parts.empty() and c <= strings[parts.back().first][0]) {
+			throw std::invalid_argument("strings are not sorted and distinct");
+		}
+		auto next = i + 1;
+		while (next < n and strings[next][0] == c) {
+			++next;
+		}
+		trie.nodes_[0].mask |= std::uint32_t{1} << (c - 'A');
+		parts.emplace_back(i, next);
+		i = next;
+	}
+
+	std::vector<subtrie_t> subtries(parts.size());
+	std::atomic<std::size_t> next_part(0);
+	auto build_parts = [&](std::size_t) {
+		for (auto i = next_part.fetch_add(1); i < parts.size(); i = next_part.fetch_add(1)) {
+			subtries[i] = build_subtrie(strings, parts[i].first, parts[i].second);
+		}
+	};
+	pool.run(build_parts);
+
+	std::vector<std::vector<std::size_t>> shifts(subtries.size());
+	std::size_t n_nodes = 1;
+	for (std::size_t depth = 0, more = 1; more != 0; ++depth) {
+		more = 0;
+		for (std::size_t i = 0; i < subtries.size(); ++i) {
+			const auto& levels = subtries[i].levels;
+			if (depth + 1 < levels.size()) {
+				shifts[i].push_back(n_nodes - levels[depth]);
+				n_nodes += levels[depth + 1] - levels[depth];
+				more += depth + 2 < levels.size();
+			}
+		}
+	}
+
+	trie.nodes_.resize(n_nodes, Node{0, 0, 0});
+	trie.counts_.resize(n_nodes, 0);
+	trie.nodes_[0].first_child = subtries.empty() ? 0 : 1;
+	trie.counts_[0] = static_cast<std::uint32_t>(n);
+	next_part = 0;
+	auto copy_parts = [&](std::size_t) {
+		for (auto i = next_part.fetch_add(1); i < subtries.size(); i = next_part.fetch_add(1)) {
+			const subtrie_t& subtrie = subtries[i];
+			for (std::size_t depth = 0; depth < shifts[i].size(); ++depth) {
+				for (std::size_t j = subtrie.levels[depth]; j < subtrie.levels[depth + 1]; ++j) {
+					Node node = subtrie.nodes[j];
+					if (n_children(node.mask) != 0) {
+						node.first_child += static_cast<node_t>(shifts[i][depth + 1]);
+					}
+					trie.nodes_[j + shifts[i][depth]] = node;
+					trie.counts_[j + shifts[i][depth]] = subtrie.counts[j];
+				}
+			}
+			// The node of the first letter comes after the strings of the letters before it.
+			trie.nodes_[1 + i].offset = parts[i].first - begin;
+		}
+	};
+	pool.run(copy_parts);
+
+	trie.reset_view();
+	trie.n_words_ = n;
+	return trie;
+}
+
+Trie Trie::build(const char *const *strings, std::size_t n) {
+	ThreadPool pool(1);
+	return build(strings, n, pool);
+}
+
+void Trie::shrink_to_fit() {
+	// Copying every node's children into a block of their own would undo the sharing of blocks.
+	if (minimized_) {
+		return;
+	}
+
+	// Copy the root, then walk the copied nodes in order, appending the children of each one to the
+	// new arena as a block and pointing the node at its new block. The nodes being walked are the
+	// ones appended, so this is a breadth-first traversal with the new arena as the queue.
+	// A mapped trie is copied into an arena of its own. It has no counts to carry over, so they are
+	// counted again from the offsets once the arena is built, and it can then be inserted into.
+	bool keep_counts = not mapping_;
+	arena_t nodes;
+	std::vector<std::uint32_t> counts;
+	nodes.reserve(size_);
+	nodes.push_back(data_[0]);
+	if (keep_counts) {
+		counts.reserve(size_);
+		counts.push_back(counts_[0]);
+	}
+	for (std::size_t i = 0; i < nodes.size(); ++i) {
+		auto n = n_children(nodes[i].mask);
+		node_t first = nodes[i].first_child;
+		nodes[i].first_child = n == 0 ? 0 : static_cast<node_t>(nodes.size());
+		nodes.insert(nodes.end(), data_ + first, data_ + first + n);
+		if (keep_counts) {
+			counts.insert(counts.end(), counts_.data() + first, counts_.data() + first + n);
+		}
+	}
+	nodes.shrink_to_fit();
+	counts.shrink_to_fit();
+	nodes_ = std::move(nodes);
+	reset_view();
+	counts_ = std::move(counts);
+	if (not keep_counts) {
+		count_strings();
+	}
+	hot_nodes_ = 0;
+}
+
+void Trie::layout_by_heat(const std::vector<std::uint64_t>& heat) {
+	if (heat.size() != size_) {
+		throw std::invalid_argument("the heat of " + std::to_string(heat.size()) +
+		                            " nodes does not fit a trie of " + std::to_string(size_));
+	}
+
+	// A block is identified by the index of its first node, which is all the parents sharing a
+	// block in a minimized trie have in common. A block is queued once the block holding one of
+	// its parents has been placed, and the hottest queued block is placed next, the one queued
+	// first among blocks as hot, so blocks of equal heat, and in particular all the blocks never
+	// visited, are placed breadth first. The placed nodes keep pointing at their children in the
+	// old arena until every block has been placed and 'moved' tells where each one went.
+	// Heat, ~order, first node and size of a queued block.
+	using entry_t = std::tuple<std::uint64_t, std::uint64_t, node_t, std::size_t>;
+	std::priority_queue<entry_t> queue;
+	std::unordered_map<node_t, node_t> moved; // The new index of each block queued so far.
+	std::uint64_t n_queued = 0;
+	auto enqueue = [&](const Node& parent) {
+		auto n = n_children(parent.mask);
+		if (n == 0 or not moved.emplace(parent.first_child, 0).second) {
+			return;
+		}
+		std::uint64_t total = 0;
+		for (std::size_t i = 0; i < n; ++i) {
+			total += heat[parent.first_child + i];
+		}
+		queue.emplace(total, ~n_queued++, parent.first_child, n);
+	};
+
+	// As in shrink_to_fit, a mapped trie has no counts to carry over and they are counted again
+	// once the arena is built. A minimized trie needs none, since it can not be inserted into.
+	constexpr std::size_t line = CacheLineAllocator<Node>::alignment;
+	bool keep_counts = not mapping_ and not minimized_;
+	bool recount = mapping_ and not minimized_;
+	arena_t nodes;
+	std::vector<std::uint32_t> counts;
+	nodes.reserve(size_);
+	nodes.push_back(data_[0]);
+	if (keep_counts) {
+		counts.reserve(size_);
+		counts.push_back(counts_[0]);
+	}
+	std::size_t hot_nodes = 1;
+	enqueue(data_[0]);
+	while (not queue.empty()) {
+		bool hot = std::get<0>(queue.top()) != 0;
+		node_t first = std::get<2>(queue.top());
+		std::size_t n = std::get<3>(queue.top());
+		queue.pop();
+
+		// The arena starts a cache line, so the bytes of node i are at i * sizeof(Node) in it. A
+		// node need not divide a line, so the block is moved on a node at a time until it fits in
+		// one, which it does at the latest at the next line starting with a node.
+		if (hot and n * sizeof(Node) <= line) {
+			std::size_t start = nodes.size();
+			while (start * sizeof(Node) / line != ((start + n) * sizeof(Node) - 1) / line) {
+				++start;
+			}
+			nodes.resize(start, Node{0, 0, 0});
+			if (keep_counts) {
+				counts.resize(nodes.size(), 0);
+			}
+		}
+		moved[first] = static_cast<node_t>(nodes.size());
+		nodes.insert(nodes.end(), data_ + first, data_ + first + n);
+		if (keep_counts) {
+			counts.insert(counts.end(), counts_.data() + first, counts_.data() + first + n);
+		}
+		if (hot) {
+			hot_nodes = nodes.size();
+		}
+		for (std::size_t i = 0; i < n; ++i) {
+			enqueue(data_[first + i]);
+		}
+	}
+
+	for (auto& node : nodes) {
+		if (n_children(node.mask) != 0) {
+			node.first_child = moved[node.first_child];
+		}
+	}
+	nodes.shrink_to_fit();
+	counts.shrink_to_fit();
+	nodes_ = std::move(nodes);
+	reset_view();
+	counts_ = std::move(counts);
+	if (recount) {
+		count_strings();
+	}
+	hot_nodes_ = hot_nodes;
+}
+
+std::size_t Trie::hot_nodes() const {
+	return hot_nodes_;
+}
+
+void Trie::minimize() {
+	if (minimized_) {
+		return;
+	}
+
+	// Two nodes are equivalent if they have the same terminal bit and equivalent children for the
+	// same letters. Working bottom up, each node's children are first replaced by their canonical
+	// copies; the node is then equivalent to another exactly when their masks match and their
+	// blocks of children are identical byte for byte, so blocks are deduplicated through a hash map
+	// keyed by their bytes. The root keeps index 0, so no block is ever stored there.
+	arena_t nodes(1, Node{0, 0, 0});
+	std::unordered_map<std::string, node_t> blocks;
+
+	// Return the index of the canonical block holding the children of the given node.
+	auto canonical_block = [&](node_t node, auto& self) -> node_t {
+		auto n = n_children(data_[node].mask);
+		if (n == 0) {
+			return 0;
+		}
+
+		const Node *first = data_ + data_[node].first_child;
+		std::vector<Node> block(first, first + n);
+		for (std::size_t i = 0; i < n; ++i) {
+			block[i].first_child = self(static_cast<node_t>(data_[node].first_child + i), self);
+		}
+
+		std::string key(reinterpret_cast<const char *>(block.data()), n * sizeof(Node));
+		auto inserted = blocks.emplace(std::move(key), static_cast<node_t>(nodes.size()));
+		if (inserted.second) {
+			nodes.insert(nodes.end(), block.begin(), block.end());
+		}
+		return inserted.first->second;
+	};
+
+	node_t root_block = canonical_block(0, canonical_block);
+	nodes[0] = Node{data_[0].mask, root_block, 0};
+	nodes.shrink_to_fit();
+	nodes_ = std::move(nodes);
+	reset_view();
+	counts_.clear();
+	counts_.shrink_to_fit();
+	minimized_ = true;
+	hot_nodes_ = 0;
+}
+
+bool Trie::minimized() const {
+	return minimized_;
+}
+
+std::size_t Trie::word_count() const {
+	return n_words_;
+}
+
+std::string Trie::word(std::uint32_t id) const {
+	std::string s;
+	word(id, s);
+	return s;
+}
+
+void Trie::word(std::uint32_t id, std::string& s) const {
+	if (id >= n_words_) {
+		throw std::out_of_range("word ID " + std::to_string(id) + " is not in the trie");
+	}
+
+	// 'id' is the ID relative to the first string in the subtrie of 'node'.
+	s.clear();
+	node_t node = 0;
+	while (not terminal(node) or id != 0) {
+		if (terminal(node)) {
+			--id;
+		}
+		// The child to follow is the last one whose preceding siblings hold at most 'id' strings.
+		std::uint32_t mask = data_[node].mask & (terminal_bit - 1);
+		node_t next = data_[node].first_child;
+		std::uint32_t letter = static_cast<std::uint32_t>(__builtin_ctz(mask));
+		for (mask &= mask - 1; mask != 0 and data_[next + 1].offset <= id; mask &= mask - 1) {
+			++next;
+			letter = static_cast<std::uint32_t>(__builtin_ctz(mask));
+		}
+		id -= data_[next].offset;
+		s.push_back(static_cast<char>('A' + letter));
+		node = next;
+	}
+}
+
+std::size_t Trie::size() const {
+	return size_;
+}
+
+std::size_t Trie::memory_usage() const {
+	return mapping_ ? size_ * sizeof(Node) : nodes_.capacity() * sizeof(Node);
+}
+
+void Trie::save(const std::string& file) const {
+	FileHeader header{};
+	std::copy(std::begin(file_magic), std::end(file_magic), header.magic);
+	header.version = file_version;
+	header.node_size = sizeof(Node);
+	header.flags = minimized_ ? minimized_flag : 0;
+	header.n_words = static_cast<std::uint32_t>(n_words_);
+	header.n_nodes = size_;
+	header.checksum = checksum(data_, size_);
+	header.hot_nodes = hot_nodes_;
+
+	std::ofstream out(file, std::ios::binary | std::ios::trunc);
+	out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char *>(data_),
+	          static_cast<std::streamsize>(size_ * sizeof(Node)));
+	out.close();
+	if (not out) {
+		throw std::runtime_error("cannot write trie to " + file);
+	}
+}
+
+Trie Trie::map(const std::string& file) {
+	int fd = ::open(file.c_str(), O_RDONLY);
+	if (fd == -1) {
+		throw std::runtime_error("cannot open " + file);
+	}
+	struct stat st;
+	if (::fstat(fd, &st) == -1 or static_cast<std::size_t>(st.st_size) < sizeof(FileHeader)) {
+		::close(fd);
+		throw std::runtime_error(file + " is not a trie file");
+	}
+	auto length = static_cast<std::size_t>(st.st_size);
+	void *address = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (address == MAP_FAILED) {
+		throw std::runtime_error("cannot map " + file);
+	}
+	std::shared_ptr<const void> mapping(address, [length](const void *p) {
+		::munmap(const_cast<void *>(p), length);
+	});
+
+	FileHeader header;
+	std::memcpy(&header, address, sizeof(header));
+	if (not std::equal(std::begin(file_magic), std::end(file_magic), header.magic)) {
+		throw std::runtime_error(file + " is not a trie file");
+	}
+	if (header.version != file_version or header.node_size != sizeof(Node)) {
+		throw std::runtime_error(file + " was written by an incompatible version");
+	}
+	if (header.n_nodes == 0 or header.n_nodes != (length - sizeof(header)) / sizeof(Node) or
+	    (length - sizeof(header)) % sizeof(Node) != 0) {
+		throw std::runtime_error(file + " is truncated");
+	}
+
+	auto nodes = reinterpret_cast<const Node *>(static_cast<const char *>(address) + sizeof(header));
+	auto n_nodes = static_cast<std::size_t>(header.n_nodes);
+	if (checksum(nodes, n_nodes) != header.checksum) {
+		throw std::runtime_error(file + " is corrupt");
+	}
+
+	Trie trie;
+	trie.nodes_.clear();
+	trie.nodes_.shrink_to_fit();
+	trie.counts_.clear();
+	trie.counts_.shrink_to_fit();
+	trie.n_words_ = header.n_words;
+	trie.data_ = nodes;
+	trie.size_ = n_nodes;
+	trie.mapping_ = std::move(mapping);
+	trie.minimized_ = (header.flags & minimized_flag) != 0;
+	trie.hot_nodes_ = static_cast<std::size_t>(header.hot_nodes);
+	return trie;
+}
+
+void Trie::reset_view() {
+	data_ = nodes_.data();
+	size_ = nodes_.size();
+	mapping_.reset();
+}
+
+void Trie::count_strings() {
+	// The strings in the subtrie of a node are the one ending at the node, if any, and those in the
+	// subtries of its children, which are the offset of the last child plus the strings in its own
+	// subtrie. Every block of children comes after its parent, so walking the arena backwards counts
+	// the children of a node before the node.
+	counts_.assign(nodes_.size(), 0);
+	for (std::size_t i = nodes_.size(); i-- > 0; ) {
+		const Node& node = nodes_[i];
+		std::uint32_t count = (node.mask & terminal_bit) != 0 ? 1 : 0;
+		auto n = n_children(node.mask);
+		if (n != 0) {
+			auto last = node.first_child + static_cast<node_t>(n) - 1;
+			count += nodes_[last].offset + counts_[last];
+		}
+		counts_[i] = count;
+	}
+}
+
+void Trie::add_child(node_t node, std::uint32_t letter) {
+	std::uint32_t bit = std::uint32_t{1} << letter;
+	std::uint32_t mask = nodes_[node].mask;
+	auto n = static_cast<node_t>(n_children(mask));
+	auto position = static_cast<node_t>(__builtin_popcount(mask & (bit - 1)));
+	node_t first = nodes_[node].first_child;
+
+	if (n == 0 or first + n == nodes_.size()) {
+		// The children are already at the end of the arena, so the block can grow in place.
+		if (n == 0) {
+			first = static_cast<node_t>(nodes_.size());
+		}
+		nodes_.push_back(Node{0, 0, 0});
+		counts_.push_back(0);
+		std::copy_backward(nodes_.begin() + first + position, nodes_.end() - 1, nodes_.end());
+		std::copy_backward(counts_.begin() + first + position, counts_.end() - 1, counts_.end());
+	} else {
+		// Move the children to a new block at the end of the arena, leaving a gap for the new child.
+		node_t new_first = static_cast<node_t>(nodes_.size());
+		nodes_.resize(nodes_.size() + n + 1);
+		counts_.resize(counts_.size() + n + 1);
+		std::copy(nodes_.begin() + first, nodes_.begin() + first + position,
+		          nodes_.begin() + new_first);
+		std::copy(nodes_.begin() + first + position, nodes_.begin() + first + n,
+		          nodes_.begin() + new_first + position + 1);
+		std::copy(counts_.begin() + first, counts_.begin() + first + position,
+		          counts_.begin() + new_first);
+		std::copy(counts_.begin() + first + position, counts_.begin() + first + n,
+		          counts_.begin() + new_first + position + 1);
+		first = new_first;
+	}
+
+	// The new child has no strings yet, so the offsets of its later siblings stay the same.
+	node_t new_child = first + position;
+	std::uint32_t offset = 0;
+	if (position > 0) {
+		offset = nodes_[new_child - 1].offset + counts_[new_child - 1];
+	}
+	nodes_[new_child] = Node{0, 0, offset};
+	counts_[new_child] = 0;
+	nodes_[node].first_child = first;
+	nodes_[node].mask = mask | bit;
+	reset_view();
 }
@@ -1,7 +1,52 @@
 #pragma once
 
-#include <array>
+#include <cstdint>
+#include <cstdlib>
 #include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+/*
+ * An allocator of memory aligned to a cache line, for the arena of a trie: a trie laid out by heat
+ * packs its hottest nodes at the start of the arena, which then fill as few cache lines as they
+ * can.
+ */
+template <typename T>
+struct CacheLineAllocator {
+	using value_type = T;
+
+	static constexpr std::size_t alignment = 64; // The size of a cache line.
+
+	CacheLineAllocator() = default;
+
+	template <typename U>
+	CacheLineAllocator(const CacheLineAllocator<U>&) { }
+
+	T *allocate(std::size_t n) {
+		void *p = nullptr;
+		if (posix_memalign(&p, alignment, n * sizeof(T)) != 0) {
+			throw std::bad_alloc();
+		}
+		return static_cast<T *>(p);
+	}
+
+	void deallocate(T *p, std::size_t) {
+		std::free(p);
+	}
+};
+
+template <typename T, typename U>
+bool operator==(const CacheLineAllocator<T>&, const CacheLineAllocator<U>&) {
+	return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const CacheLineAllocator<T>&, const CacheLineAllocator<U>&) {
+	return false;
+}
+
+class ThreadPool;
 
 /*
  * The trie is a data structure serving as a dynamic set of strings. The trie can test for
@@ -10,12 +55,65 @@
  * This implementation of the trie only holds strings containing uppercase ASCII letters. Attempts
  * to use strings containing anything else will lead to undefined behaviour.
  *
+ * The nodes are stored in a single contiguous arena and refer to each other by index. Each node
+ * holds a bitmask of the letters it has children for, a bit marking the end of a string, and the
+ * index of its first child. The children of a node are stored next to each other in alphabetical
+ * order, so the child for a letter is found by counting the bits in the mask below that letter.
+ * Inserting a child into a node moves the node's children to the end of the arena, leaving a hole
+ * behind; shrink_to_fit() removes the holes once the strings have been inserted. A whole sorted
+ * list of strings is better turned into a trie with build(), which lays the nodes out in their
+ * final place straight away.
+ *
+ * A trie can also be minimized into a directed acyclic word graph (DAWG), in which equivalent
+ * subtries, such as the many copies of the suffixes "ING" or "NESS", are stored only once. A
+ * minimized trie answers lookups exactly like the trie it was made from, but strings can no longer
+ * be inserted into it.
+ *
+ * Since nodes refer to each other by index, the arena is position independent and can be saved to
+ * a binary file and later mapped back into memory read-only, without parsing or allocation. The
+ * file starts with a header holding a magic number, a format version, the node size and a checksum
+ * of the nodes, so that a file written by an incompatible version or damaged on disk is rejected
+ * rather than misread. The file uses the byte order of the machine that wrote it. Processes mapping
+ * the same file share its physical pages. Strings can not be inserted into a mapped trie.
+ *
+ * The search of a board only ever visits a small part of the trie, mostly its first levels and
+ * the subtries of common prefixes, but in a trie laid out breadth first those nodes are spread
+ * over the whole arena. layout_by_heat() lays the arena out again by how often each node was
+ * visited while solving a sample of boards, counted by a TrieProfile: the visited blocks of
+ * children come first, hottest first and never straddling a cache line needlessly, and the
+ * blocks never visited follow in breadth-first order. The layout is kept by save() and map().
+ *
+ * Every string in the trie has an ID, its index in the alphabetical order of the strings, so the
+ * IDs of a trie holding n strings are exactly [0, n). IDs are not stored at the nodes, since nodes
+ * of a minimized trie are shared by many strings. Instead each node stores the number of strings
+ * in the subtries of its preceding siblings, and the ID of a string is accumulated while walking
+ * down to it with the three-argument overload of child(). Inserting a string shifts the IDs of the
+ * strings after it.
+ *
  * Finally, note that Tries are not permitted to be copied, but can be moved.
  */
-//TODO bitwise trie?
 //TODO make case insensitive?
 class Trie {
 public:
+	using node_t = std::uint32_t; // Index of a node in the arena. The root has index 0.
+
+	/*
+	 * A node of the trie.
+	 */
+	struct Node {
+		std::uint32_t mask; // Bit i is set if the node has a child for the letter 'A' + i, and bit
+		// 26 is set if a string ends at the node.
+		node_t first_child; // Index of the child for the lowest letter in the mask. The other
+		// children follow it in alphabetical order.
+		std::uint32_t offset; // Number of strings in the subtries of the siblings before the node.
+	};
+
+	static constexpr std::uint32_t terminal_bit = std::uint32_t{1} << 26; // Bit of Node::mask
+	// marking the end of a string.
+
+	static constexpr std::uint32_t file_version = 3; // Version of the binary file format. Must be
+	// incremented whenever the layout of the file or of Node changes.
+
 	/*
 	 * Create an empty trie.
 	 */
@@ -52,11 +150,199 @@ public:
 	bool has_prefix(const char *prefix) const;
 
 	/*
-	 * Insert the given string into the trie.
+	 * Insert the given string into the trie. Throws std::logic_error if the trie has been
+	 * minimized or is mapped from a file.
 	 */
 	void insert(const char *s);
 
+	/*
+	 * Return a trie holding the given strings, which must be sorted in the order of std::strcmp
+	 * and distinct, built in a single pass over their letters rather than by inserting them one at
+	 * a time. The trie is exactly the one inserting the strings and calling shrink_to_fit() would
+	 * give, and strings can still be inserted into it. The subtries of the first letters are built
+	 * on the threads of the given pool, each in an arena of its own, and then copied into place.
+	 * Throws std::invalid_argument if the strings are not sorted and distinct or hold anything but
+	 * uppercase ASCII letters.
+	 */
+	static Trie build(const char *const *strings, std::size_t n, ThreadPool& pool);
+
+	/*
+	 * As above, on the calling thread alone.
+	 */
+	static Trie build(const char *const *strings, std::size_t n);
+
+	/*
+	 * Return the child of the given node for the given character, or 0 if the node has no such
+	 * child. 0 is the index of the root, which is never a child. Lets callers walk the trie one
+	 * character at a time instead of looking up every prefix from the root.
+	 */
+	node_t child(node_t node, char c) const;
+
+	/*
+	 * As above, and if there is a child, add to 'id' the difference between the smallest ID of the
+	 * strings in the child's subtrie and that of the strings in the node's subtrie. Starting from
+	 * the root with an 'id' of 0, 'id' is the ID of the string spelled out so far whenever the walk
+	 * is at a terminal node.
+	 */
+	node_t child(node_t node, char c, std::uint32_t& id) const;
+
+	/*
+	 * Return true if a string ends at the given node.
+	 */
+	bool terminal(node_t node) const;
+
+	/*
+	 * Return the letters the given node has children for, bit i standing for the letter 'A' + i.
+	 */
+	std::uint32_t letters(node_t node) const;
+
+	/*
+	 * Ask the processor to start loading the children of the given node into the cache, so that a
+	 * later step down from the node does not stall on them. Only a hint: does nothing else.
+	 */
+	void prefetch(node_t node) const;
+
+	/*
+	 * Return the number of strings in the trie. String IDs are in [0, word_count()).
+	 */
+	std::size_t word_count() const;
+
+	/*
+	 * Return the string with the given ID, found by walking down from the root along the children
+	 * whose subtries hold the ID. Throws std::out_of_range if the ID is not less than word_count().
+	 */
+	std::string word(std::uint32_t id) const;
+
+	/*
+	 * As above, but assign the string to 's' rather than returning a new one, so that resolving
+	 * many IDs into the same string does not allocate.
+	 */
+	void word(std::uint32_t id, std::string& s) const;
+
+	/*
+	 * Rebuild the arena in breadth-first order without the holes left behind by insertions, and
+	 * release any unused capacity, undoing any layout by heat. Does nothing if the trie has been
+	 * minimized. A trie mapped from a file is copied into an arena of its own, after which strings
+	 * can be inserted into it.
+	 */
+	void shrink_to_fit();
+
+	/*
+	 * Rebuild the arena with the blocks of children ordered by the given heat, the number of times
+	 * each node was visited, indexed like the arena, such as the visits counted by a TrieProfile.
+	 * Blocks are placed in order of the total heat of their nodes, hottest first, each as soon as
+	 * the block holding its parent has been placed, so a block never visited comes after every
+	 * block that was, in breadth-first order. A visited block small enough to fit in a cache line
+	 * is placed so it does not straddle two, leaving a hole before it if need be. The holes left
+	 * behind by insertions are removed, and a minimized trie stays minimized. As with
+	 * shrink_to_fit(), a trie mapped from a file is copied into an arena of its own. Throws
+	 * std::invalid_argument if the heat does not have one count per node.
+	 */
+	void layout_by_heat(const std::vector<std::uint64_t>& heat);
+
+	/*
+	 * Return the number of nodes at the start of the arena holding the blocks that were visited
+	 * when the trie was laid out by heat, or 0 if it was not.
+	 */
+	std::size_t hot_nodes() const;
+
+	/*
+	 * Minimize the trie into a DAWG by merging nodes that have the same children and the same
+	 * terminal bit, bottom up, so that equivalent subtries share a single block of nodes. Undoes
+	 * any layout by heat.
+	 */
+	void minimize();
+
+	/*
+	 * Return true if the trie has been minimized.
+	 */
+	bool minimized() const;
+
+	/*
+	 * Return the number of nodes in the arena, including holes left behind by insertions and by
+	 * layout_by_heat().
+	 */
+	std::size_t size() const;
+
+	/*
+	 * Return the number of bytes of memory held by the arena, or mapped from a file.
+	 */
+	std::size_t memory_usage() const;
+
+	/*
+	 * Write the trie to the given file in the binary format read by map(). Call shrink_to_fit()
+	 * first to leave the holes left behind by insertions out of the file. Throws
+	 * std::runtime_error if the file can not be written.
+	 */
+	void save(const std::string& file) const;
+
+	/*
+	 * Return a trie whose nodes are the contents of the given file, written by save(), mapped
+	 * read-only into memory. The file must not be modified while the trie is in use. Throws
+	 * std::runtime_error if the file can not be mapped or if its header or checksum do not match.
+	 */
+	static Trie map(const std::string& file);
+
 private:
-	std::array<std::unique_ptr<Trie>, 27> children_; // The children of the root of the trie, one
-	// child for each uppercase character plus the null character.
+	using arena_t = std::vector<Node, CacheLineAllocator<Node>>;
+
+	arena_t nodes_; // The arena, unless the trie is mapped from a file. nodes_[0] is the root.
+	const Node *data_; // The nodes used for lookups: either nodes_.data() or the mapped file.
+	std::size_t size_; // The number of nodes at data_.
+	std::shared_ptr<const void> mapping_; // Keeps the file mapped while the trie uses it.
+	std::vector<std::uint32_t> counts_; // counts_[i] is the number of strings in the subtrie of
+	// nodes_[i]. Only kept while strings can be inserted, to set the offsets of new nodes.
+	std::size_t n_words_; // The number of strings in the trie.
+	bool minimized_; // True if blocks of children may be shared between nodes.
+	std::size_t hot_nodes_; // The number of nodes laid out by heat at the start of the arena.
+
+	/*
+	 * Point data_ and size_ back at nodes_ after the arena has been modified.
+	 */
+	void reset_view();
+
+	/*
+	 * Count the strings in the subtrie of every node of the arena into counts_, from the offsets of
+	 * the nodes. Every block of children must come after its parent in the arena, as it does once
+	 * the arena has been rebuilt breadth first.
+	 */
+	void count_strings();
+
+	/*
+	 * Add a child for the given letter index to the given node, which must not already have one.
+	 */
+	void add_child(node_t node, std::uint32_t letter);
 };
+
+inline Trie::node_t Trie::child(node_t node, char c) const {
+	const Node& n = data_[node];
+	std::uint32_t bit = std::uint32_t{1} << (c - 'A');
+	if ((n.mask & bit) == 0) {
+		return 0;
+	}
+	return n.first_child + static_cast<node_t>(__builtin_popcount(n.mask & (bit - 1)));
+}
+
+inline Trie::node_t Trie::child(node_t node, char c, std::uint32_t& id) const {
+	const Node& n = data_[node];
+	std::uint32_t bit = std::uint32_t{1} << (c - 'A');
+	if ((n.mask & bit) == 0) {
+		return 0;
+	}
+	node_t next = n.first_child + static_cast<node_t>(__builtin_popcount(n.mask & (bit - 1)));
+	// The string ending at the node, if any, comes before all the strings in its children.
+	id += ((n.mask & terminal_bit) != 0 ? 1 : 0) + data_[next].offset;
+	return next;
+}
+
+inline bool Trie::terminal(node_t node) const {
+	return (data_[node].mask & terminal_bit) != 0;
+}
+
+inline std::uint32_t Trie::letters(node_t node) const {
+	return data_[node].mask & ~terminal_bit;
+}
+
+inline void Trie::prefetch(node_t node) const {
+	__builtin_prefetch(data_ + data_[node].first_child);
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "boggle.hpp"
+#include "trie.hpp"
+
+/*
+ * The number of times searches visited each node of a trie, counted over a sample of boards to lay
+ * the trie out by heat with Trie::layout_by_heat.
+ *
+ * A TrieProfile takes the place of a SearchStats in the overload of Boggle<N, M>::solve counting
+ * the work done, and counts every step down the trie into the node it reaches, as well as the node
+ * of the Q passed through on the way onto a QU square. Unlike a SearchStats it is not zeroed by
+ * each solve, so it adds up the visits of every board solved with it. A step that finds no child
+ * only reads the node it started from, which is counted when it is reached, so it adds nothing.
+ */
+class TrieProfile {
+public:
+	static constexpr bool enabled = false; // Solves are not timed.
+
+	/*
+	 * Create a profile of the given trie with no visits.
+	 */
+	explicit TrieProfile(const Trie& trie) :
+			visits_(trie.size(), 0),
+			n_boards_(0),
+			words_() { }
+
+	/*
+	 * Solve the given board with the given dictionary, the trie of the profile, and count the
+	 * visits of the search.
+	 */
+	template <std::size_t N, std::size_t M>
+	void add(const Trie& dictionary, const Boggle<N, M>& board,
+	         typename Boggle<N, M>::Workspace& workspace) {
+		board.solve(dictionary, workspace, words_, *this);
+	}
+
+	/*
+	 * Return the number of visits of each node, indexed like the arena of the trie.
+	 */
+	const std::vector<std::uint64_t>& visits() const {
+		return visits_;
+	}
+
+	/*
+	 * Return the number of boards solved.
+	 */
+	std::uint64_t boards() const {
+		return n_boards_;
+	}
+
+	/*
+	 * Return the number of nodes visited at least once.
+	 */
+	std::size_t nodes_visited() const {
+		return static_cast<std::size_t>(std::count_if(visits_.begin(), visits_.end(),
+		                                              [](std::uint64_t n) { return n != 0; }));
+	}
+
+	/*
+	 * Add the visits of the given profile of the same trie.
+	 */
+	void merge(const TrieProfile& other) {
+		for (std::size_t i = 0; i < visits_.size() and i < other.visits_.size(); ++i) {
+			visits_[i] += other.visits_[i];
+		}
+		n_boards_ += other.n_boards_;
+	}
+
+	/*
+	 * Start the search of a board: the counts are kept.
+	 */
+	void reset(std::size_t) {
+		++n_boards_;
+	}
+
+	/*
+	 * Count a step down the trie into the given node, or 0 if no word continues that way.
+	 */
+	void step(std::uint32_t node) {
+		if (node != 0) {
+			++visits_[node];
+		}
+	}
+
+	/*
+	 * Count the visit of the node of the Q on the way down a QU square, which the search reads as
+	 * often as the step itself.
+	 */
+	void pass(std::uint32_t node) {
+		++visits_[node];
+	}
+
+	void filtered() { }
+
+	void expand(std::size_t) { }
+
+	void hit(bool) { }
+
+	void busy(std::size_t, double) { }
+
+private:
+	std::vector<std::uint64_t> visits_; // The number of visits of each node.
+	std::uint64_t n_boards_; // The number of boards solved.
+	std::vector<std::string> words_; // The words of the last board solved by 'add'.
+};
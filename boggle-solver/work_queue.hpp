@@ -0,0 +1,83 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+/*
+ * A double-ended queue of tasks belonging to one thread of a work-stealing scheduler.
+ *
+ * The owning thread pushes and pops tasks at the back, so it works depth first on the tasks it
+ * created most recently. Idle threads steal from the front, taking the oldest tasks, which are
+ * usually the largest. The queue is a ring buffer of fixed capacity guarded by a mutex, which is
+ * only contended when another thread steals, and it does not allocate once created.
+ */
+template <typename T>
+class WorkQueue {
+public:
+	/*
+	 * Create a queue holding at most the given number of tasks.
+	 */
+	explicit WorkQueue(std::size_t capacity = 0) :
+			tasks_(capacity),
+			head_(0),
+			size_(0) { }
+
+	// Delete copy constructor and copy assignment.
+	WorkQueue(const WorkQueue&) = delete;
+
+	WorkQueue& operator=(const WorkQueue&) = delete;
+
+	/*
+	 * Empty the queue and change its capacity.
+	 */
+	void reset(std::size_t capacity) {
+		std::lock_guard<std::mutex> guard(lock_);
+		tasks_.resize(capacity);
+		head_ = 0;
+		size_ = 0;
+	}
+
+	/*
+	 * Add a task to the back of the queue. The queue must not be full.
+	 */
+	void push(const T& task) {
+		std::lock_guard<std::mutex> guard(lock_);
+		tasks_[(head_ + size_) % tasks_.size()] = task;
+		++size_;
+	}
+
+	/*
+	 * Remove the task at the back of the queue and return true, or return false if the queue is
+	 * empty.
+	 */
+	bool pop(T& task) {
+		std::lock_guard<std::mutex> guard(lock_);
+		if (size_ == 0) {
+			return false;
+		}
+		--size_;
+		task = tasks_[(head_ + size_) % tasks_.size()];
+		return true;
+	}
+
+	/*
+	 * Remove the task at the front of the queue and return true, or return false if the queue is
+	 * empty.
+	 */
+	bool steal(T& task) {
+		std::lock_guard<std::mutex> guard(lock_);
+		if (size_ == 0) {
+			return false;
+		}
+		task = tasks_[head_];
+		head_ = (head_ + 1) % tasks_.size();
+		--size_;
+		return true;
+	}
+
+private:
+	std::mutex lock_;
+	std::vector<T> tasks_; // Ring buffer holding the tasks.
+	std::size_t head_; // Index of the task at the front of the queue.
+	std::size_t size_; // Number of tasks in the queue.
+};
@@ -0,0 +1,135 @@
+/*
+ * Unit tests for the AnyBoggle class.
+ */
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "any_boggle.hpp"
+
+namespace {
+/*
+ * Return a string of the given number of random uppercase letters, the same for a given seed.
+ */
+std::string random_letters(std::size_t length, unsigned seed) {
+	std::minstd_rand eng(seed);
+	std::uniform_int_distribution<int> dist(0, 25);
+	std::string letters;
+	for (std::size_t i = 0; i < length; ++i) {
+		letters.push_back(static_cast<char>('A' + dist(eng)));
+	}
+	return letters;
+}
+
+/*
+ * Return the given words sorted.
+ */
+std::vector<std::string> sorted(std::vector<std::string> words) {
+	std::sort(words.begin(), words.end());
+	return words;
+}
+
+/*
+ * Return the words of the given board found by Boggle<N, N>.
+ */
+template <std::size_t N>
+std::vector<std::string> expected_words(const std::string& letters) {
+	return sorted(Boggle<N>(letters).solve(Boggle<4>::dictionary()));
+}
+}
+
+/*
+ * Test which sizes are dispatched to a Boggle instantiation, and that bad dimensions are rejected.
+ */
+TEST(AnyBoggleTest, Specialized) {
+	EXPECT_TRUE(AnyBoggle(4, 4, random_letters(16, 0)).specialized());
+	EXPECT_TRUE(AnyBoggle(5, 5, random_letters(25, 0)).specialized());
+	EXPECT_TRUE(AnyBoggle(6, 6, random_letters(36, 0)).specialized());
+	EXPECT_TRUE(AnyBoggle(8, 8, random_letters(64, 0)).specialized());
+	EXPECT_FALSE(AnyBoggle(7, 7, random_letters(49, 0)).specialized());
+	EXPECT_FALSE(AnyBoggle(4, 5, random_letters(20, 0)).specialized());
+
+	EXPECT_THROW(AnyBoggle(4, 4, "ABC"), std::invalid_argument);
+}
+
+/*
+ * Test that every size finds the same words as the matching Boggle instantiation.
+ */
+TEST(AnyBoggleTest, Solve) {
+	Boggle<4>::load_dictionary(DICT_PATH);
+	const Trie& dictionary = Boggle<4>::dictionary();
+	ThreadPool pool(2);
+
+	std::vector<std::string> words;
+	for (unsigned seed = 0; seed < 5; ++seed) {
+		std::vector<std::pair<AnyBoggle, std::vector<std::string>>> cases;
+		for (std::size_t n : {4, 5, 6, 7, 8}) {
+			std::string letters = random_letters(n * n, seed);
+			std::vector<std::string> expected;
+			switch (n) {
+				case 4:
+					expected = expected_words<4>(letters);
+					break;
+				case 5:
+					expected = expected_words<5>(letters);
+					break;
+				case 6:
+					expected = expected_words<6>(letters);
+					break;
+				case 7:
+					expected = expected_words<7>(letters);
+					break;
+				default:
+					expected = expected_words<8>(letters);
+					break;
+			}
+			cases.emplace_back(AnyBoggle(n, n, letters), expected);
+		}
+
+		for (const auto& c : cases) {
+			const AnyBoggle& boggle = c.first;
+			EXPECT_EQ(sorted(boggle.solve(dictionary)), c.second) << boggle.letters();
+			EXPECT_EQ(sorted(boggle.solve(dictionary, pool)), c.second) << boggle.letters();
+			boggle.solve(dictionary, words);
+			EXPECT_EQ(sorted(words), c.second) << boggle.letters();
+
+			words.clear();
+			boggle.visit(dictionary, [&](const auto& match) {
+				words.emplace_back(match.word, match.length);
+				return true;
+			});
+			EXPECT_EQ(sorted(words), c.second) << boggle.letters();
+
+			words.clear();
+			for (std::uint32_t id : boggle.solve_ids(dictionary, pool)) {
+				words.push_back(dictionary.word(id));
+			}
+			EXPECT_EQ(sorted(words), c.second) << boggle.letters();
+		}
+	}
+}
+
+/*
+ * Test solving a batch of boards of different sizes.
+ */
+TEST(AnyBoggleTest, SolveMany) {
+	Boggle<4>::load_dictionary(DICT_PATH);
+	const Trie& dictionary = Boggle<4>::dictionary();
+
+	std::vector<AnyBoggle> boggles;
+	for (unsigned seed = 0; seed < 40; ++seed) {
+		std::size_t n = 4 + seed % 5;
+		boggles.emplace_back(n, n, random_letters(n * n, seed));
+	}
+
+	ResultSink sink;
+	ThreadPool pool(3);
+	AnyBoggle::solve_many(dictionary, boggles.data(), boggles.size(), sink, pool);
+	ASSERT_EQ(sink.size(), boggles.size());
+	for (std::size_t i = 0; i < boggles.size(); ++i) {
+		EXPECT_EQ(sorted(sink.words(i)), sorted(boggles[i].solve(dictionary))) << i;
+	}
+}
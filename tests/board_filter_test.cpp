@@ -0,0 +1,124 @@
+/*
+ * Unit tests for the BoardFilter class.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "board_filter.hpp"
+
+namespace {
+/*
+ * Return the letters of the neighbours of the given square of an N by M board, found by checking
+ * every other square.
+ */
+template <std::size_t N, std::size_t M>
+std::uint32_t next_letters(const std::string& board, std::size_t square) {
+	std::uint32_t letters = 0;
+	for (std::size_t i = 0; i < N * M; ++i) {
+		std::size_t row_distance = i / M > square / M ? i / M - square / M : square / M - i / M;
+		std::size_t col_distance = i % M > square % M ? i % M - square % M : square % M - i % M;
+		if (i != square and row_distance <= 1 and col_distance <= 1) {
+			letters |= std::uint32_t{1} << (board[i] - 'A');
+		}
+	}
+	return letters;
+}
+
+/*
+ * Check the counts, the adjacent pairs and the neighbour letters of the filter of the given N by M
+ * board against those found by checking every square.
+ */
+template <std::size_t N, std::size_t M>
+void check_filter(const std::string& board) {
+	BoardFilter<N, M> filter(board.c_str());
+	for (char c = 'A'; c <= 'Z'; ++c) {
+		EXPECT_EQ(filter.count(c), std::count(board.begin(), board.end(), c)) << c;
+	}
+
+	std::uint32_t pairs[26] = {};
+	for (std::size_t i = 0; i < N * M; ++i) {
+		EXPECT_EQ(filter.next_letters(i), (next_letters<N, M>(board, i))) << "square " << i;
+		pairs[board[i] - 'A'] |= next_letters<N, M>(board, i);
+	}
+	for (char a = 'A'; a <= 'Z'; ++a) {
+		for (char b = 'A'; b <= 'Z'; ++b) {
+			EXPECT_EQ(filter.adjacent(a, b), (pairs[a - 'A'] >> (b - 'A') & 1) != 0) << a << b;
+		}
+	}
+}
+}
+
+/*
+ * Test the filters of boards built with 64-bit sets of squares, including full ones, one with a
+ * single column and one with a single row.
+ */
+TEST(BoardFilterTest, SmallBoards) {
+	check_filter<3, 4>("ABCDEFGHAIJK");
+	check_filter<4, 4>("QAHTOSREEBUNLNTI");
+	check_filter<6, 1>("ABCABC");
+	check_filter<8, 8>("SERSPATGLINESERSTATSGNILETEROPSERRITAESSETIDNALPERSETEMRAIOLINSD");
+	check_filter<1, 64>("SERSPATGLINESERSTATSGNILETEROPSERRITAESSETIDNALPERSETEMRAIOLINSD");
+}
+
+/*
+ * Test the filter of a board of more than 64 squares, built from the neighbours of each square.
+ */
+TEST(BoardFilterTest, LargeBoard) {
+	check_filter<9, 9>("SERSPATGLINESERSTATSGNILETEROPSERRITAESSETIDNALPERSETEMRAIOLINSD"
+	                   "QUARTZESXYLOPHONE");
+}
+
+/*
+ * Test that the filter of a board whose dimensions are only known at run time matches the filter of
+ * the same board of fixed size, and that it can be rebuilt for a board of another size.
+ */
+TEST(BoardFilterTest, DynamicBoard) {
+	using neighbours_t = Neighbours<dynamic_size, dynamic_size>;
+	const std::string large = "SERSPATGLINESERSTATSGNILETEROPSERRITAESSETIDNALPERSETEMRAIOLINSD"
+	                          "QUARTZESXYLOPHONE";
+	const std::string small = "ABCDEFGHAIJK";
+	BoardFilter<9, 9> large_filter(large.c_str());
+	BoardFilter<3, 4> small_filter(small.c_str());
+
+	BoardFilter<dynamic_size, dynamic_size> filter;
+	filter.reset(large.c_str(), neighbours_t(9, 9));
+	for (std::size_t i = 0; i < large.size(); ++i) {
+		EXPECT_EQ(filter.next_letters(i), large_filter.next_letters(i)) << "square " << i;
+	}
+	filter.reset(small.c_str(), neighbours_t(3, 4));
+	for (std::size_t i = 0; i < small.size(); ++i) {
+		EXPECT_EQ(filter.next_letters(i), small_filter.next_letters(i)) << "square " << i;
+	}
+	for (char a = 'A'; a <= 'Z'; ++a) {
+		EXPECT_EQ(filter.count(a), small_filter.count(a)) << a;
+		for (char b = 'A'; b <= 'Z'; ++b) {
+			EXPECT_EQ(filter.adjacent(a, b), small_filter.adjacent(a, b)) << a << b;
+		}
+	}
+}
+
+/*
+ * Test which words the filter admits.
+ */
+TEST(BoardFilterTest, Admits) {
+	// A B C D
+	// E F G H
+	// Q I J A
+	BoardFilter<3, 4> filter("ABCDEFGHQIJA");
+	EXPECT_TRUE(filter.admits("ABC"));
+	EXPECT_TRUE(filter.admits("FIJ"));
+	EXPECT_TRUE(filter.admits("AJA"));
+	EXPECT_TRUE(filter.admits("QUIE"));
+	EXPECT_TRUE(filter.admits("EQUI"));
+	// Admitted although the only B is used twice: only the counts of letters are checked.
+	EXPECT_TRUE(filter.admits("ABA"));
+	EXPECT_FALSE(filter.admits("ABAB"));
+	EXPECT_FALSE(filter.admits("AC"));
+	EXPECT_FALSE(filter.admits("ZA"));
+	EXPECT_FALSE(filter.admits("QI"));
+	EXPECT_FALSE(filter.admits("EQ"));
+	EXPECT_FALSE(filter.admits("UQ"));
+	EXPECT_FALSE(filter.admits("ab"));
+}
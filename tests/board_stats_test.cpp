@@ -0,0 +1,94 @@
+/*
+ * Unit tests for the Histogram and BoardStats classes.
+ */
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "board_stats.hpp"
+
+/*
+ * Test the counts, mean, extremes and quantiles of a histogram, and merging histograms.
+ */
+TEST(BoardStatsTest, Histogram) {
+	Histogram empty;
+	EXPECT_EQ(empty.count(), 0);
+	EXPECT_EQ(empty.mean(), 0);
+	EXPECT_EQ(empty.min(), 0);
+	EXPECT_EQ(empty.max(), 0);
+	EXPECT_EQ(empty.quantile(0.5), 0);
+
+	Histogram a;
+	for (std::size_t value = 1; value <= 10; ++value) {
+		a.add(value);
+	}
+	EXPECT_EQ(a.count(), 10);
+	EXPECT_EQ(a.sum(), 55);
+	EXPECT_DOUBLE_EQ(a.mean(), 5.5);
+	EXPECT_EQ(a.min(), 1);
+	EXPECT_EQ(a.max(), 10);
+	EXPECT_EQ(a.quantile(0), 1);
+	EXPECT_EQ(a.quantile(0.5), 5);
+	EXPECT_EQ(a.quantile(0.9), 9);
+	EXPECT_EQ(a.quantile(1), 10);
+
+	Histogram b;
+	b.add(3, 5);
+	b.add(20);
+	a.merge(b);
+	EXPECT_EQ(a.count(), 16);
+	EXPECT_EQ(a.count(3), 6);
+	EXPECT_EQ(a.count(20), 1);
+	EXPECT_EQ(a.count(21), 0);
+	EXPECT_EQ(a.sum(), 55 + 15 + 20);
+	EXPECT_EQ(a.max(), 20);
+}
+
+/*
+ * Test that a sample matches solving its boards one by one, and does not depend on the number of
+ * threads.
+ */
+TEST(BoardStatsTest, Sample) {
+	Boggle<4>::load_dictionary(DICT_PATH);
+	const DiceSet& dice = DiceSet::modern();
+	const std::uint64_t n_boards = 3000;
+
+	BoardStats expected;
+	for (std::uint64_t i = 0; i < n_boards; ++i) {
+		CounterRng rng(5, i);
+		Boggle<4> boggle;
+		dice.roll(rng, boggle[0]);
+		std::size_t score = 0;
+		std::size_t longest = 0;
+		auto words = boggle.solve();
+		for (const auto& word : words) {
+			score += word_score(word.size());
+			longest = std::max(longest, word.size());
+		}
+		++expected.boards;
+		expected.words.add(words.size());
+		expected.score.add(score);
+		expected.longest.add(longest);
+	}
+
+	for (std::size_t n_threads : {1, 3, 8}) {
+		ThreadPool pool(n_threads);
+		BoardStats stats = BoardStats::sample<4>(dice, n_boards, 5, Boggle<4>::dictionary(), pool);
+		EXPECT_EQ(stats.boards, n_boards);
+		for (auto histogram : {&BoardStats::words, &BoardStats::score, &BoardStats::longest}) {
+			const Histogram& h = stats.*histogram;
+			const Histogram& e = expected.*histogram;
+			EXPECT_EQ(h.count(), e.count());
+			EXPECT_EQ(h.sum(), e.sum());
+			ASSERT_EQ(h.max(), e.max());
+			for (std::size_t value = 0; value <= e.max(); ++value) {
+				EXPECT_EQ(h.count(value), e.count(value)) << n_threads << " threads";
+			}
+		}
+	}
+
+	BoardStats other = BoardStats::sample<4>(dice, n_boards, 6);
+	EXPECT_NE(other.score.sum(), expected.score.sum());
+	EXPECT_THROW(BoardStats::sample<5>(dice, 1, 0), std::invalid_argument);
+}
@@ -1,12 +1,48 @@
 /*
  * Unit tests for the Boggle class.
  */
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
 #include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "boggle.hpp"
 
+/*
+ * Read the test boards and their solution counts from a CSV file of "board,count" lines, dropping
+ * the lowercase 'u' that follows each 'Q' on a board.
+ */
+static std::vector<std::pair<std::string, std::size_t>> read_solutions(const std::string& path) {
+	std::vector<std::pair<std::string, std::size_t>> solutions;
+	std::ifstream file(path);
+	std::string line;
+	while (std::getline(file, line)) {
+		std::string boggle_board;
+		std::string n_solutions_str;
+
+		std::stringstream ss(line);
+		char c;
+		while (ss.peek() != ',') {
+			ss >> c;
+			if (c != 'u') {
+				boggle_board.push_back(c);
+			}
+		}
+		ss.ignore();
+		while (ss >> c) {
+			n_solutions_str.push_back(c);
+		}
+		solutions.emplace_back(boggle_board, std::stoul(n_solutions_str));
+	}
+	return solutions;
+}
+
 /*
  * Test the Boggle constructor.
  */
@@ -68,6 +104,29 @@ TEST(BoggleTest, LoadDictionary) {
 	Boggle<>::load_dictionary(DICT_PATH);
 }
 
+/*
+ * Test that reading a dictionary uppercases, sorts and deduplicates its words and skips the lines
+ * with anything but ASCII letters, whether or not the file ends with a newline.
+ */
+TEST(BoggleTest, ReadDictionary) {
+	std::string path = ::testing::TempDir() + "boggle_test_read_dictionary.txt";
+	for (const char *ending : {"", "\n"}) {
+		{
+			std::ofstream file(path, std::ios::binary);
+			file << "zebra\nApple\nAPPLE\nmango\nna\xc3\xafve\ndon't\nap\r\nap\nApples" << ending;
+		}
+		Trie dictionary = Boggle<>::read_dictionary(path);
+		EXPECT_EQ(dictionary.word_count(), 5);
+		const char *sorted[] = {"AP", "APPLE", "APPLES", "MANGO", "ZEBRA"};
+		for (std::uint32_t i = 0; i < 5; ++i) {
+			EXPECT_EQ(dictionary.word(i), sorted[i]);
+		}
+		EXPECT_FALSE(dictionary.has_prefix("NA"));
+		EXPECT_FALSE(dictionary.has_prefix("DON"));
+	}
+	std::remove(path.c_str());
+}
+
 /*
  * Test the solving of 100 4x4 Boggle boards. Test data extracted from wordplays.com, which uses the
  * TWL dictionary, and stored in a CSV file.
@@ -75,28 +134,336 @@ TEST(BoggleTest, LoadDictionary) {
 TEST(BoggleTest, Solve4x4) {
 	Boggle<4>::load_dictionary(DICT_PATH);
 
-	std::ifstream file(TEST_DATA_DIR"/boggle_4x4.csv");
-	std::string line;
-	while (std::getline(file, line)) {
-		std::string boggle_board;
-		std::string n_solutions_str;
+	for (const auto& test : read_solutions(TEST_DATA_DIR"/boggle_4x4.csv")) {
+		const std::string& boggle_board = test.first;
+		Boggle<4> boggle(boggle_board);
+		auto solution = boggle.solve();
+		EXPECT_EQ(solution.size(), test.second) << "Boggle board: " << boggle_board;
+	}
+}
 
-		std::stringstream ss(line);
-		char c;
-		while (ss.peek() != ',') {
-			ss >> c;
-			if (c != 'u') {
-				boggle_board.push_back(c);
+/*
+ * Test the single-threaded solve against the same test data as Solve4x4, reusing one workspace and
+ * one result vector for every board.
+ */
+TEST(BoggleTest, Solve4x4Workspace) {
+	Boggle<4>::load_dictionary(DICT_PATH);
+
+	Boggle<4>::Workspace workspace;
+	std::vector<std::string> solution;
+
+	for (const auto& test : read_solutions(TEST_DATA_DIR"/boggle_4x4.csv")) {
+		const std::string& boggle_board = test.first;
+		Boggle<4> boggle(boggle_board);
+		boggle.solve(workspace, solution);
+		EXPECT_EQ(solution.size(), test.second) << "Boggle board: " << boggle_board;
+	}
+}
+
+/*
+ * Test the solving of the 4x4 test data with a minimized dictionary passed to solve explicitly,
+ * alongside the dictionary loaded with load_dictionary.
+ */
+TEST(BoggleTest, Solve4x4MinimizedDictionary) {
+	Boggle<4>::load_dictionary(DICT_PATH);
+	Trie dawg = Boggle<4>::read_dictionary(DICT_PATH, true);
+	EXPECT_TRUE(dawg.minimized());
+
+	for (const auto& test : read_solutions(TEST_DATA_DIR"/boggle_4x4.csv")) {
+		const std::string& boggle_board = test.first;
+		Boggle<4> boggle(boggle_board);
+		auto solution = boggle.solve(dawg);
+		auto expected = boggle.solve();
+		std::sort(solution.begin(), solution.end());
+		std::sort(expected.begin(), expected.end());
+		EXPECT_EQ(solution, expected) << "Boggle board: " << boggle_board;
+		EXPECT_EQ(solution.size(), test.second) << "Boggle board: " << boggle_board;
+	}
+}
+
+/*
+ * Test that solving on pools of different sizes finds the same words.
+ */
+TEST(BoggleTest, SolveThreadPool) {
+	Boggle<8>::load_dictionary(DICT_PATH);
+	Boggle<8> boggle("SERSPATGLINESERSTATSGNILETEROPSERRITAESSETIDNALPERSETEMRAIOLINSD");
+
+	ThreadPool single(1);
+	auto expected = boggle.solve(Boggle<8>::dictionary(), single);
+	std::sort(expected.begin(), expected.end());
+	EXPECT_GT(expected.size(), 500);
+
+	for (std::size_t n_threads : {2, 3, 7}) {
+		ThreadPool pool(n_threads);
+		auto words = boggle.solve(Boggle<8>::dictionary(), pool);
+		std::sort(words.begin(), words.end());
+		EXPECT_EQ(words, expected) << n_threads << " threads";
+	}
+}
+
+/*
+ * Test solving the 4x4 test data as one batch on pools of different sizes.
+ */
+TEST(BoggleTest, SolveMany) {
+	Boggle<4>::load_dictionary(DICT_PATH);
+
+	std::vector<Boggle<4>> boggles;
+	std::vector<std::size_t> n_solutions;
+	for (const auto& test : read_solutions(TEST_DATA_DIR"/boggle_4x4.csv")) {
+		boggles.emplace_back(test.first);
+		n_solutions.push_back(test.second);
+	}
+	ASSERT_FALSE(boggles.empty());
+
+	ResultSink sink;
+	for (std::size_t n_threads : {1, 3}) {
+		ThreadPool pool(n_threads);
+		Boggle<4>::solve_many(Boggle<4>::dictionary(), boggles.data(), boggles.size(), sink, pool);
+		ASSERT_EQ(sink.size(), boggles.size());
+		for (std::size_t i = 0; i < boggles.size(); ++i) {
+			auto words = sink.words(i);
+			auto expected = boggles[i].solve();
+			std::sort(words.begin(), words.end());
+			std::sort(expected.begin(), expected.end());
+			EXPECT_EQ(words, expected) << n_threads << " threads, board " << i;
+			EXPECT_EQ(sink.word_count(i), n_solutions[i]) << n_threads << " threads, board " << i;
+		}
+	}
+}
+
+/*
+ * Test that the word IDs found on a board resolve to the words found on it, with the loaded
+ * dictionary and a minimized one, on the calling thread and on a pool.
+ */
+TEST(BoggleTest, SolveIds) {
+	Boggle<8>::load_dictionary(DICT_PATH);
+	const Trie dawg = Boggle<8>::read_dictionary(DICT_PATH, true);
+	Boggle<8> boggle("SERSPATGLINESERSTATSGNILETEROPSERRITAESSETIDNALPERSETEMRAIOLINSD");
+
+	auto expected = boggle.solve();
+	std::sort(expected.begin(), expected.end());
+
+	ThreadPool pool(3);
+	Boggle<8>::Workspace workspace;
+	for (const Trie *dictionary : {&Boggle<8>::dictionary(), &dawg}) {
+		std::vector<std::uint32_t> serial;
+		boggle.solve_ids(*dictionary, workspace, serial);
+		for (const auto& ids : {serial, boggle.solve_ids(*dictionary, pool)}) {
+			std::vector<std::string> words;
+			for (std::uint32_t id : ids) {
+				words.push_back(dictionary->word(id));
 			}
+			std::sort(words.begin(), words.end());
+			EXPECT_EQ(words, expected);
 		}
-		ss.ignore();
-		while (ss >> c) {
-			n_solutions_str.push_back(c);
+	}
+}
+
+/*
+ * Test that visiting the words of a board finds the same words as solve, along valid paths, and
+ * that the visitor can stop the search.
+ */
+TEST(BoggleTest, Visit) {
+	Boggle<4>::load_dictionary(DICT_PATH);
+	Boggle<4> boggle("QAHTOSREEBUNLNTI");
+
+	auto expected = boggle.solve();
+	std::sort(expected.begin(), expected.end());
+	ASSERT_GT(expected.size(), 10);
+
+	std::vector<std::string> words;
+	bool finished = boggle.visit([&](const Boggle<4>::Match& match) {
+		std::string word(match.word, match.length);
+		EXPECT_EQ(word, Boggle<4>::dictionary().word(match.id));
+
+		// The path spells out the word and moves between adjacent squares.
+		std::string letters;
+		for (std::size_t i = 0; i < match.path_length; ++i) {
+			std::size_t square = match.square(i);
+			letters.push_back(boggle[square / 4][square % 4]);
+			if (letters.back() == 'Q') {
+				letters.push_back('U');
+			}
+			if (i > 0) {
+				std::size_t previous = match.square(i - 1);
+				EXPECT_LE(std::abs(int(square / 4) - int(previous / 4)), 1);
+				EXPECT_LE(std::abs(int(square % 4) - int(previous % 4)), 1);
+				EXPECT_NE(square, previous);
+			}
 		}
+		EXPECT_EQ(letters, word);
 
-		Boggle<4> boggle(boggle_board);
-		auto solution = boggle.solve();
-		int n_solutions = std::stoi(n_solutions_str);
-		EXPECT_EQ(solution.size(), n_solutions) << "Boggle board: " << boggle_board;
+		words.push_back(word);
+		return true;
+	});
+	EXPECT_TRUE(finished);
+	std::sort(words.begin(), words.end());
+	EXPECT_EQ(words, expected);
+
+	// Stop after ten words, then check that the workspace is left fit for another search.
+	std::size_t n_visited = 0;
+	finished = boggle.visit([&](const Boggle<4>::Match&) {
+		return ++n_visited < 10;
+	});
+	EXPECT_FALSE(finished);
+	EXPECT_EQ(n_visited, 10);
+
+	n_visited = 0;
+	boggle.visit([&](const Boggle<4>::Match&) {
+		++n_visited;
+		return true;
+	});
+	EXPECT_EQ(n_visited, expected.size());
+}
+
+/*
+ * Test that the board filter does not change the words found, on boards small enough for its
+ * bitwise construction and on a larger one.
+ */
+TEST(BoggleTest, Filter) {
+	Boggle<4>::load_dictionary(DICT_PATH);
+	Boggle<8>::load_dictionary(DICT_PATH);
+	Boggle<9>::load_dictionary(DICT_PATH);
+
+	auto check = [](const auto& boggle) {
+		using boggle_t = std::decay_t<decltype(boggle)>;
+		typename boggle_t::Workspace filtered;
+		typename boggle_t::Workspace unfiltered;
+		unfiltered.use_filter(false);
+
+		std::vector<std::string> words;
+		std::vector<std::string> expected;
+		boggle.solve(filtered, words);
+		boggle.solve(unfiltered, expected);
+		std::sort(words.begin(), words.end());
+		std::sort(expected.begin(), expected.end());
+		EXPECT_FALSE(expected.empty());
+		EXPECT_EQ(words, expected);
+	};
+	check(Boggle<4>("QAHTOSREEBUNLNTI"));
+	check(Boggle<4>("OODALITAKULOIHTR"));
+	check(Boggle<8>("SERSPATGLINESERSTATSGNILETEROPSERRITAESSETIDNALPERSETEMRAIOLINSD"));
+	check(Boggle<9>("SERSPATGLINESERSTATSGNILETEROPSERRITAESSETIDNALPERSETEMRAIOLINSD"
+	                "QUARTZESXYLOPHONE"));
+}
+
+/*
+ * Test that solving with search counters finds the same words, and that the counters add up: every
+ * word is one terminal hit that was not a duplicate, and the nodes of the starting squares add up
+ * to all the nodes.
+ */
+TEST(BoggleTest, SearchStats) {
+	Boggle<8>::load_dictionary(DICT_PATH);
+	Boggle<8> boggle("SERSPATGLINESERSTATSGNILETEROPSERRITAESSETIDNALPERSETEMRAIOLINSD");
+	const Trie& dictionary = Boggle<8>::dictionary();
+
+	auto check = [](const SearchStats& stats, std::size_t n_words, std::size_t n_threads) {
+		EXPECT_EQ(stats.terminal_hits - stats.duplicate_hits, n_words);
+		EXPECT_EQ(stats.square_nodes.size(), 64);
+		std::uint64_t nodes = 0;
+		for (auto n : stats.square_nodes) {
+			nodes += n;
+		}
+		EXPECT_EQ(nodes, stats.nodes);
+		EXPECT_GT(stats.nodes, n_words);
+		EXPECT_GE(stats.trie_steps, stats.nodes);
+		EXPECT_LT(stats.prefix_rejections, stats.trie_steps);
+		EXPECT_GT(stats.filter_rejections, 0);
+		EXPECT_LE(stats.thread_seconds.size(), n_threads);
+		EXPECT_GE(stats.thread_seconds.size(), 1);
+	};
+
+	Boggle<8>::Workspace workspace;
+	std::vector<std::string> expected;
+	boggle.solve(dictionary, workspace, expected);
+	std::sort(expected.begin(), expected.end());
+
+	SearchStats stats;
+	std::vector<std::string> words;
+	boggle.solve(dictionary, workspace, words, stats);
+	std::sort(words.begin(), words.end());
+	EXPECT_EQ(words, expected);
+	check(stats, words.size(), 1);
+
+	for (std::size_t n_threads : {1, 3}) {
+		ThreadPool pool(n_threads);
+		words = boggle.solve(dictionary, pool, stats);
+		std::sort(words.begin(), words.end());
+		EXPECT_EQ(words, expected) << n_threads << " threads";
+		check(stats, words.size(), n_threads);
+	}
+}
+
+/*
+ * Test that advancing several searches in turn finds the same words, IDs and paths, and does the
+ * same work, as a single search, however many searches there are, on boards small enough for the
+ * bitwise set of squares and on a larger one.
+ */
+TEST(BoggleTest, Interleave) {
+	Boggle<4>::load_dictionary(DICT_PATH);
+	Boggle<8>::load_dictionary(DICT_PATH);
+	Boggle<16>::load_dictionary(DICT_PATH);
+
+	auto check = [](const auto& boggle) {
+		using boggle_t = std::decay_t<decltype(boggle)>;
+		const Trie& dictionary = boggle_t::dictionary();
+		typename boggle_t::Workspace single;
+		std::vector<std::string> expected;
+		std::vector<std::uint32_t> expected_ids;
+		SearchStats expected_stats;
+		boggle.solve(dictionary, single, expected, expected_stats);
+		boggle.solve_ids(dictionary, single, expected_ids);
+		std::sort(expected.begin(), expected.end());
+		std::sort(expected_ids.begin(), expected_ids.end());
+		EXPECT_FALSE(expected.empty());
+
+		for (std::size_t n_searches : {2, 3, 8, 300}) {
+			typename boggle_t::Workspace interleaved;
+			interleaved.interleave(n_searches);
+			for (bool filter : {true, false}) {
+				interleaved.use_filter(filter);
+				std::vector<std::string> words;
+				boggle.solve(dictionary, interleaved, words);
+				std::sort(words.begin(), words.end());
+				EXPECT_EQ(words, expected) << n_searches << " searches";
+			}
+			interleaved.use_filter(true);
+
+			std::vector<std::uint32_t> ids;
+			boggle.solve_ids(dictionary, interleaved, ids);
+			std::sort(ids.begin(), ids.end());
+			EXPECT_EQ(ids, expected_ids);
+
+			SearchStats stats;
+			std::vector<std::string> words;
+			boggle.solve(dictionary, interleaved, words, stats);
+			EXPECT_EQ(stats.nodes, expected_stats.nodes);
+			EXPECT_EQ(stats.trie_steps, expected_stats.trie_steps);
+			EXPECT_EQ(stats.square_nodes, expected_stats.square_nodes);
+
+			// Every path spells out its word, and a search stopped early leaves the workspace fit
+			// for the next.
+			std::size_t n_visited = 0;
+			bool finished = boggle.visit(dictionary, interleaved, [&](const auto& match) {
+				std::string letters;
+				for (std::size_t i = 0; i < match.path_length; ++i) {
+					char c = boggle[0][match.square(i)];
+					letters += c == 'Q' ? std::string("QU") : std::string(1, c);
+				}
+				EXPECT_EQ(letters, std::string(match.word, match.length));
+				return ++n_visited < 5;
+			});
+			EXPECT_FALSE(finished);
+			boggle.solve(dictionary, interleaved, words);
+			EXPECT_EQ(words.size(), expected.size());
+		}
+	};
+	check(Boggle<4>("QAHTOSREEBUNLNTI"));
+	check(Boggle<4>("OODALITAKULOIHTR"));
+	check(Boggle<8>("SERSPATGLINESERSTATSGNILETEROPSERRITAESSETIDNALPERSETEMRAIOLINSD"));
+	std::string letters;
+	for (int i = 0; i < 4; ++i) {
+		letters += "SERSPATGLINESERSTATSGNILETEROPSERRITAESSETIDNALPERSETEMRAIOLINSD";
 	}
+	check(Boggle<16>(letters));
 }
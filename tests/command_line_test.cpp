@@ -0,0 +1,37 @@
+/*
+ * Unit tests for the helpers shared by the command-line tools.
+ */
+#include <stdexcept>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "command_line.hpp"
+
+/*
+ * Return the letters parse_board reads from the given line, or "-" if it reads none.
+ */
+static std::string parse(const std::string& line) {
+	std::string letters = "stale";
+	return parse_board(line.data(), line.data() + line.size(), letters) ? letters : "-";
+}
+
+/*
+ * Test that a board line is read up to its first comma, in uppercase, with every spelling of the
+ * square 'QU' read as one square, and that anything but letters is rejected.
+ */
+TEST(CommandLineTest, ParseBoard) {
+	EXPECT_EQ(parse("OODALITAKULOIHTR,89"), "OODALITAKULOIHTR");
+	EXPECT_EQ(parse("oodA LITA\tkulo IHTR\r"), "OODALITAKULOIHTR");
+	EXPECT_EQ(parse(""), "-");
+	EXPECT_EQ(parse("\r"), "-");
+	EXPECT_EQ(parse(",89"), "-");
+	for (const char *line : {"QABC", "QuABC", "QUABC", "quabc", "qUabc", "qabc"}) {
+		EXPECT_EQ(parse(line), "QABC") << line;
+	}
+	EXPECT_EQ(parse("QUU"), "QU");
+	EXPECT_EQ(parse("Q U"), "QU");
+	EXPECT_EQ(parse("UQ"), "UQ");
+	for (const char *line : {"ABC1", "AB-C", "AB[C", "AB\xff"}) {
+		EXPECT_THROW(parse(line), std::invalid_argument) << line;
+	}
+}
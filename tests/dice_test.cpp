@@ -0,0 +1,120 @@
+/*
+ * Unit tests for the DiceSet and CounterRng classes.
+ */
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "counter_rng.hpp"
+#include "dice.hpp"
+
+/*
+ * Return true if each letter of the given board can be the face of a different die of the given
+ * set, finding a matching of squares to dice with augmenting paths.
+ */
+static bool from_dice(const DiceSet& dice, const std::string& board) {
+	std::vector<std::size_t> owner(dice.size(), board.size()); // The square of each die, if any.
+	std::vector<bool> tried;
+	std::function<bool(std::size_t)> assign = [&](std::size_t square) {
+		for (std::size_t i = 0; i < dice.size(); ++i) {
+			const auto& die = dice.die(i);
+			if (tried[i] or std::find(die.begin(), die.end(), board[square]) == die.end()) {
+				continue;
+			}
+			tried[i] = true;
+			if (owner[i] == board.size() or assign(owner[i])) {
+				owner[i] = square;
+				return true;
+			}
+		}
+		return false;
+	};
+	for (std::size_t square = 0; square < board.size(); ++square) {
+		tried.assign(dice.size(), false);
+		if (not assign(square)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * Test that a stream gives the same numbers however it is reached, and different streams and seeds
+ * give different numbers.
+ */
+TEST(DiceTest, CounterRng) {
+	CounterRng a(42, 7);
+	CounterRng b(42, 7);
+	std::vector<std::uint64_t> numbers;
+	for (int i = 0; i < 100; ++i) {
+		numbers.push_back(a());
+		EXPECT_EQ(numbers.back(), b());
+	}
+	EXPECT_NE(CounterRng(42, 8)(), numbers[0]);
+	EXPECT_NE(CounterRng(43, 7)(), numbers[0]);
+	std::sort(numbers.begin(), numbers.end());
+	EXPECT_EQ(std::unique(numbers.begin(), numbers.end()), numbers.end());
+
+	// Every value of below(n) comes up about as often as the others.
+	std::array<int, 6> counts{};
+	CounterRng rng(0, 0);
+	for (int i = 0; i < 60000; ++i) {
+		std::uint32_t value = rng.below(6);
+		ASSERT_LT(value, 6);
+		++counts[value];
+	}
+	for (int count : counts) {
+		EXPECT_NEAR(count, 10000, 500);
+	}
+}
+
+/*
+ * Test that a rolled board has one face of each die, and that the same stream rolls the same board.
+ */
+TEST(DiceTest, Roll) {
+	for (const auto& name : {"classic", "modern", "big"}) {
+		const DiceSet& dice = DiceSet::named(name);
+		EXPECT_EQ(dice.size(), std::string(name) == "big" ? 25 : 16);
+		for (std::uint64_t stream = 0; stream < 100; ++stream) {
+			std::string board(dice.size(), ' ');
+			std::string again(dice.size(), ' ');
+			CounterRng rng(1, stream);
+			CounterRng same(1, stream);
+			dice.roll(rng, &board[0]);
+			dice.roll(same, &again[0]);
+			EXPECT_EQ(board, again);
+			EXPECT_TRUE(from_dice(dice, board)) << name << " " << board;
+		}
+	}
+	EXPECT_THROW(DiceSet::named("unknown"), std::invalid_argument);
+	EXPECT_THROW(DiceSet({"ABCDE"}), std::invalid_argument);
+	EXPECT_THROW(DiceSet({"ABCDE1"}), std::invalid_argument);
+}
+
+/*
+ * Test that the dice land in every square.
+ */
+TEST(DiceTest, Shuffle) {
+	DiceSet dice({"AAAAAA", "BBBBBB", "CCCCCC", "DDDDDD"});
+	std::array<std::array<int, 4>, 4> counts{};
+	for (std::uint64_t stream = 0; stream < 4000; ++stream) {
+		CounterRng rng(0, stream);
+		std::string board(4, ' ');
+		dice.roll(rng, &board[0]);
+		std::string sorted = board;
+		std::sort(sorted.begin(), sorted.end());
+		ASSERT_EQ(sorted, "ABCD");
+		for (std::size_t i = 0; i < 4; ++i) {
+			++counts[static_cast<std::size_t>(board[i] - 'A')][i];
+		}
+	}
+	for (const auto& squares : counts) {
+		for (int count : squares) {
+			EXPECT_NEAR(count, 1000, 150);
+		}
+	}
+}
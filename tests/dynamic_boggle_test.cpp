@@ -0,0 +1,182 @@
+/*
+ * Unit tests for the DynamicBoggle class.
+ */
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "boggle.hpp"
+#include "dynamic_boggle.hpp"
+
+namespace {
+/*
+ * Return a string of the given number of random uppercase letters, the same for a given seed.
+ */
+std::string random_letters(std::size_t length, unsigned seed) {
+	std::minstd_rand eng(seed);
+	std::uniform_int_distribution<int> dist(0, 25);
+	std::string letters;
+	for (std::size_t i = 0; i < length; ++i) {
+		letters.push_back(static_cast<char>('A' + dist(eng)));
+	}
+	return letters;
+}
+
+/*
+ * Return the given words sorted.
+ */
+std::vector<std::string> sorted(std::vector<std::string> words) {
+	std::sort(words.begin(), words.end());
+	return words;
+}
+}
+
+/*
+ * Test that the board is laid out in row-major order and that bad dimensions are rejected.
+ */
+TEST(DynamicBoggleTest, Constructor) {
+	DynamicBoggle boggle(2, 3, "ABCDEF");
+	EXPECT_EQ(boggle.rows(), 2);
+	EXPECT_EQ(boggle.cols(), 3);
+	EXPECT_EQ(boggle[0][2], 'C');
+	EXPECT_EQ(boggle[1][0], 'D');
+
+	EXPECT_THROW(DynamicBoggle(2, 3, "ABCDE"), std::invalid_argument);
+	EXPECT_THROW(DynamicBoggle(0, 3, ""), std::invalid_argument);
+}
+
+/*
+ * Test that the generic kernel finds the same words as the Boggle instantiations, on square and
+ * rectangular boards, on the calling thread and on a pool.
+ */
+TEST(DynamicBoggleTest, SameAsBoggle) {
+	Boggle<4>::load_dictionary(DICT_PATH);
+	const Trie& dictionary = Boggle<4>::dictionary();
+
+	ThreadPool pool(3);
+	DynamicBoggle::Workspace workspace;
+	std::vector<std::string> words;
+	for (unsigned seed = 0; seed < 20; ++seed) {
+		std::string letters = random_letters(16, seed);
+		auto expected = sorted(Boggle<4>(letters).solve(dictionary));
+		DynamicBoggle boggle(4, 4, letters);
+		boggle.solve(dictionary, workspace, words);
+		EXPECT_EQ(sorted(words), expected) << letters;
+		EXPECT_EQ(sorted(boggle.solve(dictionary, pool)), expected) << letters;
+	}
+
+	std::string letters = random_letters(21, 21);
+	DynamicBoggle rectangle(3, 7, letters);
+	rectangle.solve(dictionary, workspace, words);
+	EXPECT_EQ(sorted(words), sorted(Boggle<3, 7>(letters).solve(dictionary)));
+
+	// A board of more than 64 squares, using several words for the path.
+	letters = random_letters(81, 81);
+	DynamicBoggle large(9, 9, letters);
+	auto expected = sorted(Boggle<9>(letters).solve(dictionary));
+	EXPECT_GT(expected.size(), 100);
+	large.solve(dictionary, workspace, words);
+	EXPECT_EQ(sorted(words), expected);
+
+	std::vector<std::uint32_t> ids = large.solve_ids(dictionary, pool);
+	words.clear();
+	for (std::uint32_t id : ids) {
+		words.push_back(dictionary.word(id));
+	}
+	EXPECT_EQ(sorted(words), expected);
+}
+
+/*
+ * Test that searching without the filter of the board, or with several searches interleaved, finds
+ * the same words, and that a workspace can go from a large board to a smaller one.
+ */
+TEST(DynamicBoggleTest, FilterAndInterleave) {
+	Boggle<4>::load_dictionary(DICT_PATH);
+	const Trie& dictionary = Boggle<4>::dictionary();
+
+	DynamicBoggle::Workspace filtered;
+	DynamicBoggle::Workspace unfiltered;
+	unfiltered.use_filter(false);
+	DynamicBoggle::Workspace interleaved;
+	interleaved.interleave(4);
+	std::vector<std::string> words;
+	const std::size_t sizes[][2] = {{9, 9}, {3, 7}};
+	for (const auto& size : sizes) {
+		std::string letters = random_letters(size[0] * size[1], 7);
+		DynamicBoggle boggle(size[0], size[1], letters);
+		boggle.solve(dictionary, filtered, words);
+		auto expected = sorted(words);
+		EXPECT_FALSE(expected.empty()) << letters;
+		boggle.solve(dictionary, unfiltered, words);
+		EXPECT_EQ(sorted(words), expected) << letters;
+		boggle.solve(dictionary, interleaved, words);
+		EXPECT_EQ(sorted(words), expected) << letters;
+	}
+}
+
+/*
+ * Test that a visitor sees every word once and can stop the search.
+ */
+TEST(DynamicBoggleTest, Visit) {
+	Boggle<4>::load_dictionary(DICT_PATH);
+	DynamicBoggle boggle(3, 5, "QAHTOSREEBUNLNT");
+	DynamicBoggle::Workspace workspace;
+
+	std::vector<std::string> expected;
+	boggle.solve(Boggle<4>::dictionary(), workspace, expected);
+	ASSERT_GT(expected.size(), 10);
+
+	std::vector<std::string> words;
+	EXPECT_TRUE(boggle.visit(Boggle<4>::dictionary(), workspace,
+	                         [&](const DynamicBoggle::Match& match) {
+		words.emplace_back(match.word, match.length);
+		EXPECT_GE(match.path_length, 2);
+		return true;
+	}));
+	EXPECT_EQ(sorted(words), sorted(expected));
+
+	std::size_t n_visited = 0;
+	EXPECT_FALSE(boggle.visit(Boggle<4>::dictionary(), workspace,
+	                          [&](const DynamicBoggle::Match&) {
+		return ++n_visited < 5;
+	}));
+	EXPECT_EQ(n_visited, 5);
+
+	boggle.solve(Boggle<4>::dictionary(), workspace, words);
+	EXPECT_EQ(sorted(words), sorted(expected));
+}
+
+/*
+ * Test that solving with search counters finds the same words and that the counters add up, see
+ * BoggleTest.SearchStats.
+ */
+TEST(DynamicBoggleTest, SearchStats) {
+	Boggle<4>::load_dictionary(DICT_PATH);
+	const Trie& dictionary = Boggle<4>::dictionary();
+	DynamicBoggle boggle(3, 5, "QAHTOSREEBUNLNT");
+	DynamicBoggle::Workspace workspace;
+
+	std::vector<std::string> expected;
+	boggle.solve(dictionary, workspace, expected);
+
+	SearchStats stats;
+	std::vector<std::string> words;
+	boggle.solve(dictionary, workspace, words, stats);
+	EXPECT_EQ(sorted(words), sorted(expected));
+	EXPECT_EQ(stats.terminal_hits - stats.duplicate_hits, words.size());
+	EXPECT_EQ(stats.square_nodes.size(), 15);
+
+	ThreadPool pool(3);
+	words = boggle.solve(dictionary, pool, stats);
+	EXPECT_EQ(sorted(words), sorted(expected));
+	EXPECT_EQ(stats.terminal_hits - stats.duplicate_hits, words.size());
+	std::uint64_t nodes = 0;
+	for (auto n : stats.square_nodes) {
+		nodes += n;
+	}
+	EXPECT_EQ(nodes, stats.nodes);
+	EXPECT_LE(stats.thread_seconds.size(), 3);
+}
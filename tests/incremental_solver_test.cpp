@@ -0,0 +1,107 @@
+/*
+ * Unit tests for the IncrementalSolver class.
+ */
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "incremental_solver.hpp"
+
+namespace {
+/*
+ * Return the sorted IDs of the words of the given board, solved from scratch.
+ */
+template <std::size_t N, std::size_t M>
+std::vector<std::uint32_t> solve_ids(const Boggle<N, M>& boggle) {
+	auto ids = boggle.solve_ids();
+	std::sort(ids.begin(), ids.end());
+	return ids;
+}
+
+/*
+ * Change random squares of the given board to random letters, and check after each change that the
+ * solver holds the words of the board and reported the words it added and removed.
+ */
+template <std::size_t N, std::size_t M>
+void check_changes(const Boggle<N, M>& boggle, std::size_t n_changes) {
+	Boggle<N, M>::load_dictionary(DICT_PATH);
+	IncrementalSolver<N, M> solver(boggle);
+	auto expected = solve_ids(boggle);
+	ASSERT_EQ(solver.words(), expected);
+	ASSERT_EQ(solver.size(), expected.size());
+
+	std::minstd_rand eng(N * M);
+	std::uniform_int_distribution<std::size_t> square(0, N * M - 1);
+	std::uniform_int_distribution<int> letter(0, 25);
+	std::vector<std::uint32_t> added;
+	std::vector<std::uint32_t> removed;
+	for (std::size_t i = 0; i < n_changes; ++i) {
+		std::size_t s = square(eng);
+		solver.set(s / M, s % M, static_cast<char>('A' + letter(eng)), added, removed);
+		auto before = expected;
+		expected = solve_ids(solver.board());
+		EXPECT_EQ(solver.words(), expected) << "change " << i;
+		EXPECT_EQ(solver.size(), expected.size()) << "change " << i;
+
+		std::vector<std::uint32_t> expected_added;
+		std::vector<std::uint32_t> expected_removed;
+		std::set_difference(expected.begin(), expected.end(), before.begin(), before.end(),
+		                    std::back_inserter(expected_added));
+		std::set_difference(before.begin(), before.end(), expected.begin(), expected.end(),
+		                    std::back_inserter(expected_removed));
+		std::sort(added.begin(), added.end());
+		std::sort(removed.begin(), removed.end());
+		EXPECT_EQ(added, expected_added) << "change " << i;
+		EXPECT_EQ(removed, expected_removed) << "change " << i;
+	}
+}
+}
+
+/*
+ * Test changing the squares of a 4 by 4 board, which has a QU square to begin with.
+ */
+TEST(IncrementalSolverTest, Set4x4) {
+	check_changes(Boggle<4>("QAHTOSREEBUNLNTI"), 200);
+}
+
+/*
+ * Test changing the squares of a rectangular board.
+ */
+TEST(IncrementalSolverTest, Set3x5) {
+	check_changes(Boggle<3, 5>("SERSPATGLINESER"), 200);
+}
+
+/*
+ * Test that the solver counts every path spelling out a word, and that setting a square to its
+ * own letter changes nothing.
+ */
+TEST(IncrementalSolverTest, Paths) {
+	// A T A
+	// T E T
+	// A T A
+	Boggle<3>::load_dictionary(DICT_PATH);
+	IncrementalSolver<3> solver(Boggle<3>("ATATETATA"));
+	const Trie& dictionary = Boggle<3>::dictionary();
+
+	std::uint32_t id = 0;
+	Trie::node_t node = 0;
+	for (char c : {'E', 'A', 'T'}) {
+		node = dictionary.child(node, c, id);
+	}
+	ASSERT_TRUE(dictionary.terminal(node));
+	// The E in the middle, then any of the four As, then either T next to it.
+	EXPECT_EQ(solver.paths(id), 8);
+
+	std::vector<std::uint32_t> added;
+	std::vector<std::uint32_t> removed;
+	solver.set(1, 1, 'E', added, removed);
+	EXPECT_TRUE(added.empty());
+	EXPECT_TRUE(removed.empty());
+	EXPECT_EQ(solver.paths(id), 8);
+
+	solver.set(1, 1, 'O', added, removed);
+	EXPECT_FALSE(solver.contains(id));
+	EXPECT_NE(std::find(removed.begin(), removed.end(), id), removed.end());
+}
@@ -0,0 +1,69 @@
+/*
+ * Unit tests for the Neighbours class.
+ */
+#include <algorithm>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "neighbours.hpp"
+
+namespace {
+/*
+ * Return the neighbours of the given square that are not in the given set, in the order they are
+ * produced by the cursor.
+ */
+template <typename T>
+std::vector<std::size_t> free_neighbours(std::size_t square, const typename T::set_t& visited) {
+	std::vector<std::size_t> neighbours;
+	auto cursor = T::begin(square, visited);
+	std::size_t neighbour;
+	while (T::next(square, cursor, visited, neighbour)) {
+		neighbours.push_back(neighbour);
+	}
+	std::sort(neighbours.begin(), neighbours.end());
+	return neighbours;
+}
+}
+
+/*
+ * Test the neighbour masks of a 3 by 4 board, which uses a single word per set.
+ */
+TEST(NeighboursTest, SmallBoard) {
+	using neighbours_t = Neighbours<3, 4>;
+
+	// Corner, edge and interior squares.
+	EXPECT_EQ(neighbours_t::mask(0), 0b000000110010u);
+	EXPECT_EQ(neighbours_t::mask(1), 0b000001110101u);
+	EXPECT_EQ(neighbours_t::mask(5), 0b011101010111u);
+	EXPECT_EQ(neighbours_t::mask(11), 0b010011000000u);
+
+	neighbours_t::set_t visited = 0;
+	neighbours_t::insert(visited, 4);
+	neighbours_t::insert(visited, 6);
+	EXPECT_EQ(free_neighbours<neighbours_t>(5, visited),
+	          (std::vector<std::size_t>{0, 1, 2, 8, 9, 10}));
+
+	neighbours_t::erase(visited, 6);
+	EXPECT_EQ(free_neighbours<neighbours_t>(5, visited),
+	          (std::vector<std::size_t>{0, 1, 2, 6, 8, 9, 10}));
+}
+
+/*
+ * Test the neighbour lists of a 10 by 10 board, which uses a multiword set.
+ */
+TEST(NeighboursTest, LargeBoard) {
+	using neighbours_t = Neighbours<10, 10>;
+
+	neighbours_t::set_t visited{};
+	EXPECT_EQ(free_neighbours<neighbours_t>(0, visited), (std::vector<std::size_t>{1, 10, 11}));
+	EXPECT_EQ(free_neighbours<neighbours_t>(99, visited), (std::vector<std::size_t>{88, 89, 98}));
+
+	neighbours_t::insert(visited, 63);
+	neighbours_t::insert(visited, 65);
+	EXPECT_EQ(free_neighbours<neighbours_t>(64, visited),
+	          (std::vector<std::size_t>{53, 54, 55, 73, 74, 75}));
+
+	neighbours_t::erase(visited, 65);
+	EXPECT_EQ(free_neighbours<neighbours_t>(64, visited),
+	          (std::vector<std::size_t>{53, 54, 55, 65, 73, 74, 75}));
+}
@@ -0,0 +1,16 @@
+/*
+ * Unit tests for the standard Boggle scoring.
+ */
+#include "gtest/gtest.h"
+#include "scoring.hpp"
+
+/*
+ * Test the score of words of every length.
+ */
+TEST(ScoringTest, WordScore) {
+	unsigned expected[] = {0, 0, 0, 1, 1, 2, 3, 5, 11, 11, 11};
+	for (std::size_t length = 0; length < 11; ++length) {
+		EXPECT_EQ(word_score(length), expected[length]) << length << " letters";
+	}
+	EXPECT_EQ(word_score(16), 11);
+}
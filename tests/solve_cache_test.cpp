@@ -0,0 +1,110 @@
+/*
+ * Unit tests for the SolveCache class.
+ */
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "solve_cache.hpp"
+
+/*
+ * Test that every rotation and reflection of a square board has the same canonical form, and that
+ * a rectangular board is only turned into boards of its own shape.
+ */
+TEST(SolveCacheTest, Canonical) {
+	// A B C
+	// D E F
+	// G H I
+	std::vector<std::string> square = {"ABCDEFGHI", "GDAHEBIFC", "IHGFEDCBA", "CFIBEHADG",
+	                                   "CBAFEDIHG", "GHIDEFABC", "ADGBEHCFI", "IFCHEBGDA"};
+	for (const auto& letters : square) {
+		EXPECT_EQ(SolveCache<3>::canonical(Boggle<3>(letters)), "ABCDEFGHI") << letters;
+	}
+	EXPECT_EQ(SolveCache<3>::canonical(Boggle<3>("ABCDEFGIH")), "ABCDEFGIH");
+
+	// Z A B
+	// C D E
+	std::vector<std::string> rectangle = {"ZABCDE", "BAZEDC", "CDEZAB", "EDCBAZ"};
+	for (const auto& letters : rectangle) {
+		EXPECT_EQ((SolveCache<2, 3>::canonical(Boggle<2, 3>(letters))), "BAZEDC") << letters;
+	}
+}
+
+/*
+ * Test that the words of a board are cached for all its rotations and reflections, and that hits
+ * and misses are counted.
+ */
+TEST(SolveCacheTest, Solve) {
+	Boggle<4>::load_dictionary(DICT_PATH);
+	SolveCache<4> cache(8);
+
+	Boggle<4> boggle("QAHTOSREEBUNLNTI");
+	Boggle<4> reflected("THAQERSONUBEITNL");
+	auto expected = boggle.solve();
+	std::sort(expected.begin(), expected.end());
+
+	EXPECT_EQ(cache.find(boggle), nullptr);
+	auto words = cache.solve(boggle);
+	ASSERT_NE(words, nullptr);
+	auto sorted = *words;
+	std::sort(sorted.begin(), sorted.end());
+	EXPECT_EQ(sorted, expected);
+	EXPECT_EQ(cache.solve(reflected), words);
+	EXPECT_EQ(cache.find(reflected), words);
+	EXPECT_EQ(cache.hits(), 2);
+	EXPECT_EQ(cache.misses(), 2);
+	EXPECT_EQ(cache.size(), 1);
+
+	cache.clear();
+	EXPECT_EQ(cache.size(), 0);
+	EXPECT_EQ(cache.hits(), 0);
+	EXPECT_EQ(cache.find(boggle), nullptr);
+}
+
+/*
+ * Test that a full cache evicts its least recently used board.
+ */
+TEST(SolveCacheTest, Eviction) {
+	Boggle<4>::load_dictionary(DICT_PATH);
+	SolveCache<4> cache(2, Boggle<4>::dictionary(), 1);
+
+	Boggle<4> a("QAHTOSREEBUNLNTI");
+	Boggle<4> b("OODALITAKULOIHTR");
+	Boggle<4> c("TKYSGEOOWRDLDETY");
+	cache.solve(a);
+	cache.solve(b);
+	cache.find(a);
+	cache.solve(c);
+	EXPECT_EQ(cache.size(), 2);
+	EXPECT_NE(cache.find(a), nullptr);
+	EXPECT_EQ(cache.find(b), nullptr);
+	EXPECT_NE(cache.find(c), nullptr);
+}
+
+/*
+ * Test that threads solving the same boards through the cache all get their words.
+ */
+TEST(SolveCacheTest, Threads) {
+	Boggle<4>::load_dictionary(DICT_PATH);
+	SolveCache<4> cache(64);
+	std::vector<Boggle<4>> boggles = {Boggle<4>("QAHTOSREEBUNLNTI"), Boggle<4>("OODALITAKULOIHTR"),
+	                                  Boggle<4>("TKYSGEOOWRDLDETY")};
+
+	std::vector<std::thread> threads;
+	for (std::size_t t = 0; t < 4; ++t) {
+		threads.emplace_back([&]() {
+			for (std::size_t i = 0; i < 30; ++i) {
+				const auto& boggle = boggles[i % boggles.size()];
+				EXPECT_EQ(cache.solve(boggle)->size(), boggle.solve().size());
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	EXPECT_EQ(cache.hits() + cache.misses(), 120);
+	EXPECT_GE(cache.hits(), 120 - 4 * boggles.size());
+	EXPECT_EQ(cache.size(), boggles.size());
+}
@@ -0,0 +1,66 @@
+/*
+ * Unit tests for the ThreadPool class.
+ */
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "thread_pool.hpp"
+
+/*
+ * Test that a job runs once on every thread of the pool, repeatedly.
+ */
+TEST(ThreadPoolTest, RunsOnEveryThread) {
+	for (std::size_t n_threads : {0, 1, 2, 5}) {
+		ThreadPool pool(n_threads);
+		EXPECT_EQ(pool.size(), std::max<std::size_t>(n_threads, 1));
+
+		for (int repeat = 0; repeat < 100; ++repeat) {
+			std::vector<std::atomic<int>> calls(pool.size());
+			auto job = [&calls](std::size_t i) {
+				++calls[i];
+			};
+			pool.run(job);
+			for (const auto& n_calls : calls) {
+				EXPECT_EQ(n_calls.load(), 1);
+			}
+		}
+	}
+}
+
+/*
+ * Test that an exception thrown by a job on any thread is rethrown by run, and that the pool can
+ * be used afterwards.
+ */
+TEST(ThreadPoolTest, RethrowsExceptions) {
+	ThreadPool pool(3);
+	for (std::size_t thrower = 0; thrower < pool.size(); ++thrower) {
+		auto job = [thrower](std::size_t i) {
+			if (i == thrower) {
+				throw std::runtime_error("job failed");
+			}
+		};
+		EXPECT_THROW(pool.run(job), std::runtime_error);
+	}
+
+	std::atomic<int> n_calls(0);
+	auto job = [&n_calls](std::size_t) {
+		++n_calls;
+	};
+	pool.run(job);
+	EXPECT_EQ(n_calls.load(), 3);
+}
+
+/*
+ * Test replacing the process-wide pool.
+ */
+TEST(ThreadPoolTest, Global) {
+	ThreadPool::reset_global(4, true);
+	EXPECT_EQ(ThreadPool::global().size(), 4);
+	EXPECT_TRUE(ThreadPool::global().pinned());
+
+	ThreadPool::reset_global(2);
+	EXPECT_EQ(ThreadPool::global().size(), 2);
+	EXPECT_FALSE(ThreadPool::global().pinned());
+}
@@ -0,0 +1,195 @@
+/*
+ * Unit tests for the LatencyHistogram, SpanRing and Tracer classes.
+ */
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "trace.hpp"
+
+/*
+ * Test that small values are counted exactly and large ones to within 1/64, and merging.
+ */
+TEST(TraceTest, LatencyHistogram) {
+	LatencyHistogram empty;
+	EXPECT_EQ(empty.count(), 0);
+	EXPECT_EQ(empty.quantile(0.5), 0);
+
+	LatencyHistogram small;
+	for (std::uint64_t value = 1; value <= 100; ++value) {
+		small.add(value);
+	}
+	EXPECT_EQ(small.count(), 100);
+	EXPECT_DOUBLE_EQ(small.mean(), 50.5);
+	EXPECT_EQ(small.min(), 1);
+	EXPECT_EQ(small.max(), 100);
+	EXPECT_EQ(small.quantile(0.5), 50);
+	EXPECT_EQ(small.quantile(0.99), 99);
+	EXPECT_EQ(small.quantile(1), 100);
+
+	// Every quantile of values spread over many powers of two is no less than the exact one and
+	// within 1/64 of it.
+	LatencyHistogram large;
+	std::vector<std::uint64_t> values;
+	for (std::uint64_t value = 1000; value < 100000000000; value = value * 17 / 16) {
+		values.push_back(value);
+		large.add(value);
+	}
+	for (double q : {0.1, 0.25, 0.5, 0.9, 0.99, 0.999}) {
+		auto rank = static_cast<std::size_t>(std::ceil(q * static_cast<double>(values.size())));
+		std::uint64_t exact = values[rank - 1];
+		EXPECT_GE(large.quantile(q), exact);
+		EXPECT_LE(large.quantile(q), exact + exact / 64);
+	}
+	EXPECT_EQ(large.quantile(1), values.back());
+	EXPECT_GE(large.quantile(0), values.front());
+	EXPECT_LE(large.quantile(0), values.front() + values.front() / 64);
+
+	LatencyHistogram merged;
+	merged.merge(small);
+	merged.merge(large);
+	EXPECT_EQ(merged.count(), small.count() + large.count());
+	EXPECT_EQ(merged.min(), 1);
+	EXPECT_EQ(merged.max(), values.back());
+}
+
+/*
+ * Test that a ring passes on spans in order and counts those it had to overwrite.
+ */
+TEST(TraceTest, SpanRing) {
+	SpanRing ring(8);
+	std::vector<std::uint64_t> starts;
+	auto collect = [&](const SpanRing::span_t& span) {
+		starts.push_back(span.start);
+	};
+
+	EXPECT_EQ(ring.drain(collect), 0);
+	EXPECT_TRUE(starts.empty());
+
+	for (std::uint64_t i = 0; i < 5; ++i) {
+		ring.push(1, i, 10);
+	}
+	EXPECT_EQ(ring.drain(collect), 0);
+	EXPECT_EQ(starts, (std::vector<std::uint64_t>{0, 1, 2, 3, 4}));
+
+	starts.clear();
+	for (std::uint64_t i = 5; i < 25; ++i) {
+		ring.push(2, i, 10);
+	}
+	// Once the ring has filled up, the oldest span left in it may be being overwritten by the next
+	// push, so it is dropped as well.
+	EXPECT_EQ(ring.drain(collect), 13);
+	EXPECT_EQ(starts, (std::vector<std::uint64_t>{18, 19, 20, 21, 22, 23, 24}));
+}
+
+/*
+ * Test recording spans from several threads, the histograms and the trace file after each flush.
+ */
+TEST(TraceTest, Tracer) {
+	Tracer& tracer = Tracer::global();
+	tracer.reset();
+	std::string path = testing::TempDir() + "trace_test.json";
+	tracer.open(path);
+	std::uint32_t outer = tracer.name("outer \"quoted\"");
+	std::uint32_t inner = tracer.name("inner");
+	EXPECT_EQ(tracer.name("inner"), inner);
+
+	auto read = [&]() {
+		std::ifstream in(path);
+		return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	};
+	EXPECT_EQ(read(), "[\n]\n");
+
+	// Spans are recorded whether or not tracing is enabled; only TraceSpan checks.
+	tracer.enable(false);
+	{
+		TraceSpan span(inner);
+	}
+	tracer.flush();
+	EXPECT_EQ(read(), "[\n]\n");
+
+	tracer.enable(true);
+	std::vector<std::thread> threads;
+	for (std::uint64_t t = 0; t < 4; ++t) {
+		threads.emplace_back([&, t]() {
+			for (std::uint64_t i = 0; i < 100; ++i) {
+				tracer.record(outer, 1000 * i, 1000 * i + 1000 * (t + 1));
+				TraceSpan span(inner);
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	tracer.flush();
+	tracer.record(inner, 2000, 3500);
+	tracer.close();
+	tracer.enable(false);
+
+	std::string trace = read();
+	EXPECT_EQ(trace.substr(0, 3), "[\n{");
+	EXPECT_EQ(trace.substr(trace.size() - 4), "}\n]\n");
+	EXPECT_NE(trace.find("{\"name\":\"outer \\\"quoted\\\"\",\"ph\":\"X\","), std::string::npos);
+	EXPECT_NE(trace.find("\"ts\":2.000,\"dur\":1.500}\n]\n"), std::string::npos);
+	std::size_t n_events = 0;
+	for (std::size_t i = trace.find("\"ph\":\"X\""); i != std::string::npos;
+	     i = trace.find("\"ph\":\"X\"", i + 1)) {
+		++n_events;
+	}
+	EXPECT_EQ(n_events, 801);
+
+	auto histograms = tracer.histograms();
+	ASSERT_EQ(histograms.size(), 2);
+	EXPECT_EQ(histograms[0].first, "outer \"quoted\"");
+	EXPECT_EQ(histograms[0].second.count(), 400);
+	EXPECT_EQ(histograms[0].second.min(), 1000);
+	EXPECT_EQ(histograms[0].second.max(), 4000);
+	EXPECT_DOUBLE_EQ(histograms[0].second.mean(), 2500);
+	EXPECT_EQ(histograms[1].first, "inner");
+	EXPECT_EQ(histograms[1].second.count(), 401);
+	EXPECT_EQ(tracer.dropped(), 0);
+
+	tracer.reset();
+	EXPECT_TRUE(tracer.histograms().empty());
+	std::remove(path.c_str());
+}
+
+/*
+ * Test that the ring of a thread that has exited is handed to the next thread once flushed, which
+ * takes over its thread number in the trace.
+ */
+TEST(TraceTest, RecycleRings) {
+	Tracer& tracer = Tracer::global();
+	tracer.reset();
+	std::string path = testing::TempDir() + "trace_test_recycle.json";
+	tracer.open(path);
+	std::uint32_t name = tracer.name("recycled");
+	for (std::uint64_t t = 0; t < 3; ++t) {
+		std::thread([&]() {
+			tracer.record(name, 1000, 2000);
+		}).join();
+		tracer.flush();
+	}
+	tracer.close();
+
+	std::ifstream in(path);
+	std::string trace{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+	std::vector<std::string> tids;
+	for (std::size_t i = trace.find("\"tid\":"); i != std::string::npos;
+	     i = trace.find("\"tid\":", i + 1)) {
+		tids.push_back(trace.substr(i, trace.find(',', i) - i));
+	}
+	ASSERT_EQ(tids.size(), 3);
+	EXPECT_EQ(tids[1], tids[0]);
+	EXPECT_EQ(tids[2], tids[0]);
+	EXPECT_EQ(tracer.dropped(), 0);
+
+	tracer.reset();
+	std::remove(path.c_str());
+}
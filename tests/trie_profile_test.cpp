@@ -0,0 +1,109 @@
+/*
+ * Unit tests for the TrieProfile class and laying a dictionary out by a profile.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "boggle.hpp"
+#include "counter_rng.hpp"
+#include "dice.hpp"
+#include "trie_profile.hpp"
+
+/*
+ * Test that a profile counts the visits of every board solved with it, and merging profiles.
+ */
+TEST(TrieProfileTest, Visits) {
+	Trie dictionary = Boggle<4>::read_dictionary(DICT_PATH);
+	Boggle<4> boggle("OODALITAKULOIHTR");
+	Boggle<4>::Workspace workspace;
+
+	TrieProfile empty(dictionary);
+	EXPECT_EQ(empty.visits().size(), dictionary.size());
+	EXPECT_EQ(empty.boards(), 0);
+	EXPECT_EQ(empty.nodes_visited(), 0);
+
+	TrieProfile once(dictionary);
+	once.add(dictionary, boggle, workspace);
+	EXPECT_EQ(once.boards(), 1);
+	EXPECT_GT(once.nodes_visited(), 0);
+	EXPECT_EQ(once.visits()[0], 0);
+
+	// Every prefix of a word found is visited, and the counts add up over boards.
+	std::uint32_t id = 0;
+	Trie::node_t node = 0;
+	for (char c : std::string("TOAD")) {
+		node = dictionary.child(node, c, id);
+		ASSERT_NE(node, 0);
+		EXPECT_GT(once.visits()[node], 0);
+	}
+	TrieProfile twice(dictionary);
+	twice.add(dictionary, boggle, workspace);
+	twice.add(dictionary, boggle, workspace);
+	EXPECT_EQ(twice.boards(), 2);
+	EXPECT_EQ(twice.nodes_visited(), once.nodes_visited());
+	for (std::size_t i = 0; i < once.visits().size(); ++i) {
+		EXPECT_EQ(twice.visits()[i], 2 * once.visits()[i]);
+	}
+
+	// On a QU square the node of the Q is visited on the way to the node of QU.
+	TrieProfile quest(dictionary);
+	quest.add(dictionary, Boggle<4>("QAHTOSREEBUNLNTI"), workspace);
+	Trie::node_t q = dictionary.child(0, 'Q', id);
+	Trie::node_t qu = dictionary.child(q, 'U', id);
+	ASSERT_NE(qu, 0);
+	EXPECT_GT(quest.visits()[q], 0);
+	EXPECT_EQ(quest.visits()[q], quest.visits()[qu]);
+
+	once.merge(twice);
+	EXPECT_EQ(once.boards(), 3);
+	EXPECT_EQ(once.visits()[node], 3 * twice.visits()[node] / 2);
+}
+
+/*
+ * Test that a dictionary and a DAWG laid out by the profile of some boards find the same words on
+ * other boards, and that the nodes the profiled boards visit are all laid out first.
+ */
+TEST(TrieProfileTest, LayoutByHeat) {
+	const DiceSet& dice = DiceSet::modern();
+	for (bool minimize : {false, true}) {
+		Trie dictionary = Boggle<4>::read_dictionary(DICT_PATH, minimize);
+		Trie laid_out = Boggle<4>::read_dictionary(DICT_PATH, minimize);
+		Boggle<4>::Workspace workspace;
+		Boggle<4> boggle;
+		TrieProfile profile(laid_out);
+		for (std::uint64_t i = 0; i < 200; ++i) {
+			CounterRng rng(0, i);
+			dice.roll(rng, boggle[0]);
+			profile.add(laid_out, boggle, workspace);
+		}
+		laid_out.layout_by_heat(profile.visits());
+		EXPECT_GT(laid_out.hot_nodes(), profile.nodes_visited());
+		EXPECT_LT(laid_out.hot_nodes(), laid_out.size());
+		EXPECT_EQ(laid_out.word_count(), dictionary.word_count());
+
+		TrieProfile again(laid_out);
+		for (std::uint64_t i = 0; i < 200; ++i) {
+			CounterRng rng(0, i);
+			dice.roll(rng, boggle[0]);
+			again.add(laid_out, boggle, workspace);
+		}
+		for (std::size_t node = laid_out.hot_nodes(); node < laid_out.size(); ++node) {
+			EXPECT_EQ(again.visits()[node], 0);
+		}
+
+		std::vector<std::string> expected;
+		std::vector<std::string> words;
+		for (std::uint64_t i = 0; i < 200; ++i) {
+			CounterRng rng(1, i);
+			dice.roll(rng, boggle[0]);
+			boggle.solve(dictionary, workspace, expected);
+			boggle.solve(laid_out, workspace, words);
+			std::sort(expected.begin(), expected.end());
+			std::sort(words.begin(), words.end());
+			EXPECT_EQ(words, expected);
+		}
+	}
+}
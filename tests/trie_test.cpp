@@ -1,7 +1,16 @@
 /*
  * Unit tests for the Trie class.
  */
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 #include "gtest/gtest.h"
+#include "thread_pool.hpp"
 #include "trie.hpp"
 
 /*
@@ -145,3 +154,472 @@ TEST(TrieTest, MoveAssignment) {
 
 	EXPECT_TRUE(trie.empty());
 }
+
+/*
+ * Test walking the trie one character at a time.
+ */
+TEST(TrieTest, ChildAndTerminal) {
+	Trie trie;
+	trie.insert("SOME");
+	trie.insert("SOMETIMES");
+	trie.insert("QUANTUM");
+
+	Trie::node_t node = trie.child(0, 'S');
+	ASSERT_NE(node, 0);
+	EXPECT_FALSE(trie.terminal(node));
+	node = trie.child(node, 'O');
+	ASSERT_NE(node, 0);
+	node = trie.child(node, 'M');
+	ASSERT_NE(node, 0);
+	node = trie.child(node, 'E');
+	ASSERT_NE(node, 0);
+	EXPECT_TRUE(trie.terminal(node));
+	EXPECT_NE(trie.child(node, 'T'), 0);
+	EXPECT_EQ(trie.child(node, 'S'), 0);
+
+	EXPECT_EQ(trie.child(0, 'A'), 0);
+	EXPECT_FALSE(trie.terminal(0));
+	ASSERT_NE(trie.child(0, 'Q'), 0);
+	EXPECT_NE(trie.child(trie.child(0, 'Q'), 'U'), 0);
+}
+
+/*
+ * Test that removing the holes from the arena keeps the strings and does not grow the trie.
+ */
+TEST(TrieTest, ShrinkToFit) {
+	Trie trie;
+	trie.insert("ZEBRA");
+	trie.insert("APPLE");
+	trie.insert("MANGO");
+	trie.insert("APPLY");
+	trie.insert("BANANA");
+	trie.insert("AP");
+
+	std::size_t size = trie.size();
+	trie.shrink_to_fit();
+	EXPECT_LE(trie.size(), size);
+	EXPECT_EQ(trie.size(), 23);
+
+	EXPECT_TRUE(trie.has_string("ZEBRA"));
+	EXPECT_TRUE(trie.has_string("APPLE"));
+	EXPECT_TRUE(trie.has_string("MANGO"));
+	EXPECT_TRUE(trie.has_string("APPLY"));
+	EXPECT_TRUE(trie.has_string("BANANA"));
+	EXPECT_TRUE(trie.has_string("AP"));
+	EXPECT_TRUE(trie.has_prefix("APPL"));
+	EXPECT_FALSE(trie.has_string("APPL"));
+	EXPECT_FALSE(trie.has_string("A"));
+
+	trie.insert("APPLES");
+	EXPECT_TRUE(trie.has_string("APPLES"));
+	EXPECT_TRUE(trie.has_string("APPLE"));
+}
+
+/*
+ * Test that a minimized trie shares suffixes, answers lookups like the original trie and refuses
+ * insertions.
+ */
+TEST(TrieTest, Minimize) {
+	Trie trie;
+	trie.insert("WALKING");
+	trie.insert("TALKING");
+	trie.insert("WALK");
+	trie.insert("TALK");
+	trie.insert("TALKS");
+	trie.insert("WALKS");
+	trie.insert("SOME");
+	trie.insert("SOMETIMES");
+	trie.shrink_to_fit();
+	std::size_t size = trie.size();
+
+	trie.minimize();
+	EXPECT_TRUE(trie.minimized());
+	EXPECT_LT(trie.size(), size);
+
+	EXPECT_TRUE(trie.has_string("WALKING"));
+	EXPECT_TRUE(trie.has_string("TALKING"));
+	EXPECT_TRUE(trie.has_string("WALK"));
+	EXPECT_TRUE(trie.has_string("TALK"));
+	EXPECT_TRUE(trie.has_string("TALKS"));
+	EXPECT_TRUE(trie.has_string("WALKS"));
+	EXPECT_TRUE(trie.has_string("SOME"));
+	EXPECT_TRUE(trie.has_string("SOMETIMES"));
+
+	EXPECT_FALSE(trie.has_string("WAL"));
+	EXPECT_FALSE(trie.has_string("TALKINGS"));
+	EXPECT_FALSE(trie.has_string("SOMES"));
+	EXPECT_FALSE(trie.has_string("SOMETIME"));
+	EXPECT_TRUE(trie.has_prefix("TALKIN"));
+	EXPECT_TRUE(trie.has_prefix("SOMETIME"));
+	EXPECT_FALSE(trie.has_prefix("ING"));
+
+	EXPECT_THROW(trie.insert("RUNNING"), std::logic_error);
+
+	Trie other(std::move(trie));
+	EXPECT_TRUE(other.minimized());
+	EXPECT_TRUE(other.has_string("WALKS"));
+	EXPECT_FALSE(trie.minimized());
+}
+
+/*
+ * Test saving a trie and a minimized trie to a file and mapping them back.
+ */
+TEST(TrieTest, SaveAndMap) {
+	std::string path = ::testing::TempDir() + "trie_test_save_and_map.bin";
+	for (bool minimize : {false, true}) {
+		Trie trie;
+		trie.insert("SOME");
+		trie.insert("SOMETIMES");
+		trie.insert("SPACETIME");
+		trie.insert("SPACE");
+		if (minimize) {
+			trie.minimize();
+		} else {
+			trie.shrink_to_fit();
+		}
+		trie.save(path);
+
+		Trie mapped = Trie::map(path);
+		EXPECT_EQ(mapped.size(), trie.size());
+		EXPECT_EQ(mapped.minimized(), minimize);
+		EXPECT_TRUE(mapped.has_string("SOME"));
+		EXPECT_TRUE(mapped.has_string("SOMETIMES"));
+		EXPECT_TRUE(mapped.has_string("SPACETIME"));
+		EXPECT_TRUE(mapped.has_string("SPACE"));
+		EXPECT_FALSE(mapped.has_string("SPACES"));
+		EXPECT_TRUE(mapped.has_prefix("SOMET"));
+		EXPECT_THROW(mapped.insert("SPACES"), std::logic_error);
+
+		Trie moved(std::move(mapped));
+		EXPECT_TRUE(moved.has_string("SPACE"));
+		EXPECT_TRUE(mapped.empty());
+	}
+}
+
+/*
+ * Test that mapping a file with a damaged header or damaged nodes fails.
+ */
+TEST(TrieTest, MapRejectsBadFiles) {
+	std::string path = ::testing::TempDir() + "trie_test_map_rejects_bad_files.bin";
+	EXPECT_THROW(Trie::map(path + ".missing"), std::runtime_error);
+
+	Trie trie;
+	trie.insert("HELLO");
+	trie.shrink_to_fit();
+
+	// Damage the version, then the last node.
+	for (std::streamoff offset : {std::streamoff{8}, std::streamoff{-1}}) {
+		trie.save(path);
+		std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+		file.seekp(offset, offset < 0 ? std::ios::end : std::ios::beg);
+		file.put('\x7f');
+		file.close();
+		EXPECT_THROW(Trie::map(path), std::runtime_error);
+	}
+
+	// Leave a stray byte after the nodes.
+	trie.save(path);
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::app);
+		file.put('\0');
+	}
+	EXPECT_THROW(Trie::map(path), std::runtime_error);
+}
+
+/*
+ * Return the ID of the given string in the given trie, found by walking down to it one character
+ * at a time, or -1 if the trie does not contain the string.
+ */
+static long word_id(const Trie& trie, const char *s) {
+	std::uint32_t id = 0;
+	Trie::node_t node = 0;
+	for (; *s != '\0'; ++s) {
+		node = trie.child(node, *s, id);
+		if (node == 0) {
+			return -1;
+		}
+	}
+	return trie.terminal(node) ? static_cast<long>(id) : -1;
+}
+
+/*
+ * Test that the strings of a trie are numbered in alphabetical order, whatever the order they were
+ * inserted in, and keep their IDs when the trie is shrunk, minimized, saved and mapped.
+ */
+TEST(TrieTest, WordIds) {
+	std::string path = ::testing::TempDir() + "trie_test_word_ids.bin";
+	const char *sorted[] = {"AP", "APPLE", "APPLES", "APPLY", "BANANA", "MANGO", "ZEBRA"};
+	for (bool minimize : {false, true}) {
+		Trie trie;
+		trie.insert("ZEBRA");
+		trie.insert("APPLE");
+		trie.insert("MANGO");
+		trie.insert("APPLY");
+		trie.insert("BANANA");
+		trie.insert("AP");
+		trie.insert("APPLES");
+		trie.insert("APPLE");
+		EXPECT_EQ(trie.word_count(), 7);
+		for (long i = 0; i < 7; ++i) {
+			EXPECT_EQ(word_id(trie, sorted[i]), i);
+		}
+
+		if (minimize) {
+			trie.minimize();
+		} else {
+			trie.shrink_to_fit();
+		}
+		trie.save(path);
+		Trie mapped = Trie::map(path);
+		for (const Trie *t : {&trie, &mapped}) {
+			EXPECT_EQ(t->word_count(), 7);
+			for (long i = 0; i < 7; ++i) {
+				EXPECT_EQ(word_id(*t, sorted[i]), i);
+			}
+			EXPECT_EQ(word_id(*t, "APPL"), -1);
+		}
+	}
+
+	// Inserting after shrinking shifts the IDs of the later strings.
+	Trie trie;
+	trie.insert("BANANA");
+	trie.insert("ZEBRA");
+	trie.shrink_to_fit();
+	trie.insert("MANGO");
+	EXPECT_EQ(word_id(trie, "BANANA"), 0);
+	EXPECT_EQ(word_id(trie, "MANGO"), 1);
+	EXPECT_EQ(word_id(trie, "ZEBRA"), 2);
+}
+
+/*
+ * Test that a mapped trie copied into an arena of its own with shrink_to_fit can be inserted into,
+ * and that the IDs of its strings are shifted as in a trie that was never saved.
+ */
+TEST(TrieTest, MapShrinkInsert) {
+	std::string path = ::testing::TempDir() + "trie_test_map_shrink_insert.bin";
+	Trie trie;
+	for (const char *s : {"CAT", "CATS", "DOG", "COWL", "ZEBRA"}) {
+		trie.insert(s);
+	}
+	trie.shrink_to_fit();
+	trie.save(path);
+
+	Trie mapped = Trie::map(path);
+	mapped.shrink_to_fit();
+	for (Trie *t : {&trie, &mapped}) {
+		t->insert("COW");
+		t->insert("CA");
+		t->insert("ZEBRAS");
+	}
+	const char *sorted[] = {"CA", "CAT", "CATS", "COW", "COWL", "DOG", "ZEBRA", "ZEBRAS"};
+	EXPECT_EQ(mapped.word_count(), 8);
+	for (long i = 0; i < 8; ++i) {
+		EXPECT_EQ(word_id(mapped, sorted[i]), i);
+		EXPECT_EQ(word_id(trie, sorted[i]), i);
+	}
+	std::remove(path.c_str());
+}
+
+/*
+ * Test resolving IDs back to their strings.
+ */
+TEST(TrieTest, Word) {
+	const char *sorted[] = {"AP", "APPLE", "APPLES", "APPLY", "BANANA", "MANGO", "ZEBRA"};
+	for (bool minimize : {false, true}) {
+		Trie trie;
+		for (const char *s : {"ZEBRA", "APPLE", "MANGO", "APPLY", "BANANA", "AP", "APPLES"}) {
+			trie.insert(s);
+		}
+		if (minimize) {
+			trie.minimize();
+		}
+
+		std::string s;
+		for (std::uint32_t i = 0; i < 7; ++i) {
+			EXPECT_EQ(trie.word(i), sorted[i]);
+			trie.word(i, s);
+			EXPECT_EQ(s, sorted[i]);
+		}
+		EXPECT_THROW(trie.word(7), std::out_of_range);
+	}
+}
+
+/*
+ * Test that laying a trie out by heat keeps its strings and their IDs, that the hot blocks come
+ * first, and that the layout survives saving and mapping.
+ */
+TEST(TrieTest, LayoutByHeat) {
+	std::string path = ::testing::TempDir() + "trie_test_layout_by_heat.bin";
+	const char *sorted[] = {"AP", "APPLE", "APPLES", "APPLY", "BANANA", "MANGO", "ZEBRA"};
+	for (bool minimize : {false, true}) {
+		Trie trie;
+		for (const char *s : {"ZEBRA", "APPLE", "MANGO", "APPLY", "BANANA", "AP", "APPLES"}) {
+			trie.insert(s);
+		}
+		if (minimize) {
+			trie.minimize();
+		}
+		EXPECT_THROW(trie.layout_by_heat(std::vector<std::uint64_t>(trie.size() + 1)),
+		             std::invalid_argument);
+
+		// Heat the path of ZEBRA only.
+		std::vector<std::uint64_t> heat(trie.size(), 0);
+		std::uint32_t id = 0;
+		Trie::node_t node = 0;
+		for (const char *s = "ZEBRA"; *s != '\0'; ++s) {
+			node = trie.child(node, *s, id);
+			heat[node] = 10;
+		}
+		trie.layout_by_heat(heat);
+
+		// The root and the blocks on the path of ZEBRA are laid out first.
+		EXPECT_GE(trie.hot_nodes(), 6);
+		EXPECT_LT(trie.hot_nodes(), trie.size());
+		id = 0;
+		node = 0;
+		for (const char *s = "ZEBRA"; *s != '\0'; ++s) {
+			node = trie.child(node, *s, id);
+			EXPECT_LT(node, trie.hot_nodes());
+		}
+		EXPECT_EQ(id, 6);
+
+		trie.save(path);
+		Trie mapped = Trie::map(path);
+		EXPECT_EQ(mapped.hot_nodes(), trie.hot_nodes());
+		for (const Trie *t : {&trie, &mapped}) {
+			EXPECT_EQ(t->word_count(), 7);
+			for (long i = 0; i < 7; ++i) {
+				EXPECT_EQ(word_id(*t, sorted[i]), i);
+				EXPECT_EQ(t->word(static_cast<std::uint32_t>(i)), sorted[i]);
+			}
+			EXPECT_FALSE(t->has_string("APPL"));
+			EXPECT_TRUE(t->has_prefix("APPL"));
+		}
+
+		// A trie that was not minimized can still be added to, and so can a mapped one once it
+		// has been laid out into an arena of its own.
+		if (not minimize) {
+			mapped.layout_by_heat(std::vector<std::uint64_t>(mapped.size(), 1));
+			for (Trie *t : {&trie, &mapped}) {
+				t->insert("MANGOES");
+				t->insert("APPLIED");
+				EXPECT_EQ(word_id(*t, "APPLIED"), 3);
+				EXPECT_EQ(word_id(*t, "MANGOES"), 7);
+				EXPECT_EQ(word_id(*t, "ZEBRA"), 8);
+			}
+		}
+	}
+}
+
+/*
+ * Test that after laying a trie out by heat every visited block of children that fits in a cache
+ * line lies within one, whatever the blocks placed before it.
+ */
+TEST(TrieTest, LayoutByHeatCacheLines) {
+	constexpr std::size_t line = CacheLineAllocator<Trie::Node>::alignment;
+	for (bool minimize : {false, true}) {
+		// Strings over a few letters, so the blocks of children have every size from 1 to 7 nodes.
+		Trie trie;
+		std::uint64_t state = 1;
+		for (std::size_t i = 0; i < 5000; ++i) {
+			std::string s;
+			state = state * 6364136223846793005 + 1442695040888963407;
+			for (std::size_t j = 0; j < 1 + (state >> 61); ++j) {
+				s.push_back(static_cast<char>('A' + (state >> (4 * j + 16)) % 7));
+			}
+			trie.insert(s.c_str());
+		}
+		if (minimize) {
+			trie.minimize();
+		}
+		trie.layout_by_heat(std::vector<std::uint64_t>(trie.size(), 1));
+
+		std::vector<Trie::node_t> pending = {0};
+		std::vector<bool> seen(trie.size(), false);
+		std::size_t n_checked = 0;
+		while (not pending.empty()) {
+			Trie::node_t node = pending.back();
+			pending.pop_back();
+			std::uint32_t letters = trie.letters(node);
+			if (letters == 0) {
+				continue;
+			}
+			Trie::node_t first = trie.child(node, static_cast<char>('A' + __builtin_ctz(letters)));
+			auto n = static_cast<std::size_t>(__builtin_popcount(letters));
+			if (seen[first]) {
+				continue;
+			}
+			seen[first] = true;
+			std::size_t begin = first * sizeof(Trie::Node);
+			std::size_t end = begin + n * sizeof(Trie::Node);
+			if (end - begin <= line) {
+				EXPECT_EQ(begin / line, (end - 1) / line) << "block of " << n << " at " << begin;
+				++n_checked;
+			}
+			for (std::size_t i = 0; i < n; ++i) {
+				pending.push_back(first + static_cast<Trie::node_t>(i));
+			}
+		}
+		EXPECT_GT(n_checked, 100);
+	}
+}
+
+/*
+ * Return the contents of the given file.
+ */
+static std::string read_file(const std::string& path) {
+	std::ifstream in(path, std::ios::binary);
+	return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+/*
+ * Test that building a trie from sorted strings gives exactly the trie inserting them and
+ * shrinking it gives, on any number of threads, and that it can still be inserted into.
+ */
+TEST(TrieTest, Build) {
+	std::string path = ::testing::TempDir() + "trie_test_build.bin";
+	std::vector<std::vector<const char *>> lists = {
+			{},
+			{""},
+			{"", "A", "AB"},
+			{"AP", "APPLE", "APPLES", "APPLY", "BANANA", "MANGO", "QUIZ", "ZEBRA", "ZEBRAS"},
+			{"A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K", "L", "M", "N", "O", "P", "Q",
+			 "R", "S", "T", "U", "V", "W", "X", "Y", "Z"},
+	};
+	for (const auto& strings : lists) {
+		Trie inserted;
+		for (const char *s : strings) {
+			inserted.insert(s);
+		}
+		inserted.shrink_to_fit();
+		inserted.save(path);
+		std::string expected = read_file(path);
+
+		for (std::size_t n_threads : {1, 4}) {
+			ThreadPool pool(n_threads);
+			Trie built = Trie::build(strings.data(), strings.size(), pool);
+			EXPECT_EQ(built.word_count(), strings.size());
+			built.save(path);
+			EXPECT_EQ(read_file(path), expected) << strings.size() << " strings";
+		}
+
+		Trie built = Trie::build(strings.data(), strings.size());
+		built.insert("MANGOES");
+		inserted.insert("MANGOES");
+		for (const char *s : strings) {
+			EXPECT_EQ(word_id(built, s), word_id(inserted, s));
+		}
+		EXPECT_EQ(word_id(built, "MANGOES"), word_id(inserted, "MANGOES"));
+	}
+
+	auto build = [](std::vector<const char *> strings) {
+		return Trie::build(strings.data(), strings.size());
+	};
+	EXPECT_THROW(build({"B", "A"}), std::invalid_argument);
+	EXPECT_THROW(build({"AB", "AA"}), std::invalid_argument);
+	EXPECT_THROW(build({"A", "A"}), std::invalid_argument);
+	EXPECT_THROW(build({"", ""}), std::invalid_argument);
+	EXPECT_THROW(build({"Ab"}), std::invalid_argument);
+	EXPECT_THROW(build({"1"}), std::invalid_argument);
+	std::remove(path.c_str());
+}
@@ -0,0 +1,270 @@
+"""Tests of the bot's session, puzzle loop and tracing, run against a stub of
+wordplays.com served from this process, and of the boards the module takes.
+
+The boggle module must have been built into boggle-bot. The tests of the
+session are skipped if the bot's requirements are not installed.
+"""
+import http.server
+import json
+import os
+import sys
+import tempfile
+import threading
+import unittest
+import urllib.parse
+
+BOT_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..',
+                       'boggle-bot')
+sys.path.insert(0, BOT_DIR)
+
+import tracing  # noqa: E402
+from boggle import Boggle, Tracer  # noqa: E402
+
+try:
+    from play import play
+    from wordplays import Wordplays
+    HAVE_REQUIREMENTS = True
+except ImportError:
+    HAVE_REQUIREMENTS = False
+
+BOARD = 'OODALITAKULOIHTR'
+
+
+class StubHandler(http.server.BaseHTTPRequestHandler):
+    """Serves the pages of wordplays.com the bot reads, keeping the answers
+    posted in the server's 'answers' list."""
+
+    def do_GET(self):
+        if self.path != '/boggle':
+            self.send_error(404)
+            return
+        cells = ''.join('<td><input value="{}"></td>'.format(c) for c in BOARD)
+        self._reply('<html><body><table id="pzl"><tr>{}</tr></table>'
+                    '<input name="pzlnbr" value="42">'
+                    '<input name="pzlkey" value="key">'
+                    '</body></html>'.format(cells))
+
+    def do_POST(self):
+        length = int(self.headers['Content-Length'])
+        form = urllib.parse.parse_qs(self.rfile.read(length).decode())
+        if self.path == '/wordgames/signin.pl':
+            signed_in = form['pwd'] == ['secret']
+            self._reply('<html><body>{}</body></html>'.format(
+                '<div id="signed-in"></div>' if signed_in else ''))
+        elif self.path == '/boggle':
+            answers = form['answers'][0].split('\n')
+            self.server.answers.append(answers)
+            self._reply('<html><body><table id="score-table"><tr>'
+                        '<td>{}</td><td>{}</td></tr></table></body></html>'.
+                        format(len(answers), 1000))
+        else:
+            self.send_error(404)
+
+    def log_message(self, *args):
+        pass
+
+    def _reply(self, html):
+        body = html.encode()
+        self.send_response(200)
+        self.send_header('Content-Type', 'text/html')
+        self.send_header('Content-Length', str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+
+def setUpModule():
+    Boggle.load_dictionary(os.path.join(BOT_DIR, 'dict.list'))
+
+
+class BoardTest(unittest.TestCase):
+    """Tests of the letters a board is made from."""
+
+    def test_lowercase(self):
+        board = Boggle(BOARD.lower())
+        self.assertEqual(board.board(), list(BOARD))
+        self.assertEqual(sorted(board.solve()), sorted(Boggle(BOARD).solve()))
+        self.assertEqual(sorted(Boggle.solve_many([BOARD.lower()])[0]),
+                         sorted(Boggle(BOARD).solve()))
+
+    def test_not_letters(self):
+        for board in ('OODALITAKULOIHT1', 'OODALITAKULOIHT[', 'OODALITAKU OIHTR',
+                      'OODALITAKULOIHT\xff'):
+            with self.subTest(board=board):
+                with self.assertRaises(ValueError):
+                    Boggle(board)
+                with self.assertRaises(ValueError):
+                    Boggle(board, 2, 8)
+                with self.assertRaises(ValueError):
+                    Boggle.solve_many([BOARD, board])
+
+
+class ThreadsTest(unittest.TestCase):
+    """Tests of replacing the pool and the dictionary while other threads
+    solve."""
+
+    def tearDown(self):
+        Boggle.set_threads(os.cpu_count() or 1, False)
+        Boggle.load_dictionary(os.path.join(BOT_DIR, 'dict.list'), False)
+
+    def test_replace_while_solving(self):
+        expected = sorted(Boggle(BOARD).solve())
+        stop = threading.Event()
+        results = []
+
+        def solve():
+            board = Boggle(BOARD)
+            while not stop.is_set():
+                results.append(sorted(board.solve()) == expected)
+                results.append(len(board.solve_ids()) == len(expected))
+                results.append(sorted(Boggle.solve_many([BOARD])[0]) == expected)
+
+        threads = [threading.Thread(target=solve) for _ in range(3)]
+        for thread in threads:
+            thread.start()
+        try:
+            for n_threads in (1, 3, 2, 4):
+                Boggle.set_threads(n_threads, False)
+            Boggle.load_dictionary(os.path.join(BOT_DIR, 'dict.list'), True)
+        finally:
+            stop.set()
+            for thread in threads:
+                thread.join()
+        self.assertTrue(results)
+        self.assertTrue(all(results))
+
+
+class TracingTest(unittest.TestCase):
+    """Tests of spans, histograms and the trace file."""
+
+    def setUp(self):
+        self.directory = tempfile.TemporaryDirectory()
+        self.path = os.path.join(self.directory.name, 'trace.json')
+        Tracer.reset()
+
+    def tearDown(self):
+        Tracer.enable(False)
+        Tracer.close()
+        self.directory.cleanup()
+
+    def test_disabled(self):
+        with tracing.span('disabled'):
+            pass
+        self.assertNotIn('disabled', Tracer.histograms())
+
+    def test_histograms(self):
+        Tracer.enable()
+        for _ in range(10):
+            with tracing.span('outer'):
+                with tracing.span('inner'):
+                    pass
+        with self.assertRaises(KeyError):
+            with tracing.span('raising'):
+                raise KeyError()
+        histograms = Tracer.histograms()
+        self.assertEqual(histograms['outer']['count'], 10)
+        self.assertEqual(histograms['inner']['count'], 10)
+        self.assertEqual(histograms['raising']['count'], 1)
+        self.assertLessEqual(histograms['inner']['p50'],
+                             histograms['outer']['max'])
+        for h in histograms.values():
+            self.assertLessEqual(h['min'], h['p50'])
+            self.assertLessEqual(h['p50'], h['p99'])
+            self.assertLessEqual(h['p99'], h['max'])
+        self.assertIn('outer', tracing.summary())
+
+    def test_exporter(self):
+        # With no interval every tick flushes, and the file is a complete
+        # trace after each flush.
+        with tracing.Exporter(self.path, interval=0) as exporter:
+            for i in range(3):
+                with tracing.span('tick'):
+                    Boggle(BOARD).solve()
+                exporter.tick()
+                with open(self.path) as f:
+                    events = json.load(f)
+                ticks = [e for e in events if e['name'] == 'tick']
+                self.assertEqual(len(ticks), i + 1)
+        self.assertFalse(Tracer.enabled())
+
+        with open(self.path) as f:
+            events = json.load(f)
+        searches = [e for e in events if e['name'] == 'search']
+        self.assertEqual(len(searches), 3 * Boggle.threads())
+        for event in events:
+            self.assertEqual(event['ph'], 'X')
+            self.assertGreaterEqual(event['dur'], 0)
+        # Every search lies within the span of the solve it is part of.
+        ticks = [e for e in events if e['name'] == 'tick']
+        for search in searches:
+            self.assertTrue(any(t['ts'] <= search['ts'] and
+                                search['ts'] + search['dur'] <=
+                                t['ts'] + t['dur'] + 0.001 for t in ticks))
+
+    def test_open_error(self):
+        with self.assertRaises(RuntimeError):
+            tracing.Exporter(os.path.join(self.path, 'missing', 'trace.json'))
+
+
+@unittest.skipUnless(HAVE_REQUIREMENTS, 'requests, bs4 or lxml missing')
+class WordplaysTest(unittest.TestCase):
+    """Tests of a session and the puzzle loop against the stub server."""
+
+    def setUp(self):
+        self.server = http.server.ThreadingHTTPServer(('127.0.0.1', 0),
+                                                      StubHandler)
+        self.server.answers = []
+        self.thread = threading.Thread(target=self.server.serve_forever)
+        self.thread.start()
+        self.url = 'http://127.0.0.1:{}'.format(self.server.server_port)
+        self.directory = tempfile.TemporaryDirectory()
+        self.path = os.path.join(self.directory.name, 'trace.json')
+        Tracer.reset()
+
+    def tearDown(self):
+        self.server.shutdown()
+        self.thread.join()
+        self.server.server_close()
+        self.directory.cleanup()
+
+    def test_login(self):
+        with Wordplays(base_url=self.url) as wp:
+            self.assertFalse(wp.login(username='bot', password='wrong'))
+            self.assertTrue(wp.login(username='bot', password='secret'))
+
+    def test_start_boggle(self):
+        with Wordplays(base_url=self.url) as wp:
+            self.assertEqual(wp.start_boggle(), list(BOARD))
+            self.assertEqual(wp.pzlnbr, '42')
+            self.assertEqual(wp.pzlkey, 'key')
+
+    def test_play(self):
+        with Wordplays(base_url=self.url) as wp, \
+                tracing.Exporter(self.path):
+            self.assertTrue(wp.login(username='bot', password='secret'))
+            for _ in range(2):
+                score, max_score = play(wp)
+
+        words = sorted(Boggle(BOARD).solve())
+        self.assertEqual([sorted(a) for a in self.server.answers], [words] * 2)
+        self.assertEqual((score, max_score), (str(len(words)), '1000'))
+
+        # Every stage of both puzzles is in the trace, on the thread that
+        # played them.
+        with open(self.path) as f:
+            events = json.load(f)
+        stages = ['puzzle', 'fetch', 'parse', 'construct', 'solve', 'submit',
+                  'parse_score']
+        for stage in stages:
+            self.assertEqual(
+                len([e for e in events if e['name'] == stage]), 2, stage)
+        self.assertEqual(len({e['tid'] for e in events
+                              if e['name'] in stages}), 1)
+        self.assertEqual(len([e for e in events if e['name'] == 'login']), 1)
+        histograms = Tracer.histograms()
+        self.assertEqual(histograms['puzzle']['count'], 2)
+        self.assertGreaterEqual(histograms['puzzle']['min'],
+                                histograms['solve']['max'])
+
+
+if __name__ == '__main__':
+    unittest.main()